@@ -0,0 +1,94 @@
+#include "AssignmentSolver.h"
+#include <limits>
+
+/**
+ * Finds the cheapest assignment
+ * @param cost The cost of each pairing, row-major with rows * cols entries
+ * @param rows The number of rows
+ * @param cols The number of columns
+ * @return For each row the column it is given, or -1 for rows left over
+ */
+const std::vector<int>& AssignmentSolver::solve(const std::vector<int64_t>& cost, int rows, int cols) {
+    rowColumn.assign(rows, -1);
+    if (rows == 0 || cols == 0) {
+        return rowColumn;
+    }
+    // The algorithm matches every row of the smaller side, so a tall matrix is solved on its side
+    if (rows <= cols) {
+        solveWide(cost, rows, cols, false);
+    } else {
+        solveWide(cost, cols, rows, true);
+    }
+    return rowColumn;
+}
+
+/**
+ * Matches each of n rows to one of m >= n columns, growing the matching one row at a time
+ * along the cheapest augmenting path under the current potentials
+ * @param cost The caller's cost matrix
+ * @param n Rows to match
+ * @param m Columns to match them to
+ * @param transposed True if the rows here are the caller's columns
+ */
+void AssignmentSolver::solveWide(const std::vector<int64_t>& cost, int n, int m, bool transposed) {
+    const int stride = transposed ? n : m;
+    auto at = [&](int row, int col) {
+        return transposed ? cost[static_cast<size_t>(col) * stride + row] : cost[static_cast<size_t>(row) * stride + col];
+    };
+    const int64_t unreached = std::numeric_limits<int64_t>::max();
+
+    // Index 0 is a sentinel column that the new row starts from
+    rowPotential.assign(n + 1, 0);
+    columnPotential.assign(m + 1, 0);
+    columnRow.assign(m + 1, 0);
+    previousColumn.assign(m + 1, 0);
+    for (int row = 1; row <= n; row++) {
+        columnRow[0] = row;
+        int column = 0;
+        slack.assign(m + 1, unreached);
+        visited.assign(m + 1, 0);
+        do {
+            visited[column] = 1;
+            int fromRow = columnRow[column];
+            int64_t delta = unreached;
+            int nextColumn = 0;
+            for (int j = 1; j <= m; j++) {
+                if (visited[j]) continue;
+                int64_t reduced = at(fromRow - 1, j - 1) - rowPotential[fromRow] - columnPotential[j];
+                if (reduced < slack[j]) {
+                    slack[j] = reduced;
+                    previousColumn[j] = column;
+                }
+                if (slack[j] < delta) {
+                    delta = slack[j];
+                    nextColumn = j;
+                }
+            }
+            for (int j = 0; j <= m; j++) {
+                if (visited[j]) {
+                    rowPotential[columnRow[j]] += delta;
+                    columnPotential[j] -= delta;
+                } else {
+                    slack[j] -= delta;
+                }
+            }
+            column = nextColumn;
+        } while (columnRow[column] != 0);
+
+        // Flip the path so every column on it takes the row before it
+        do {
+            int previous = previousColumn[column];
+            columnRow[column] = columnRow[previous];
+            column = previous;
+        } while (column != 0);
+    }
+
+    for (int j = 1; j <= m; j++) {
+        if (columnRow[j] == 0) continue;
+        if (transposed) {
+            rowColumn[j - 1] = columnRow[j] - 1;
+        } else {
+            rowColumn[columnRow[j] - 1] = j - 1;
+        }
+    }
+}
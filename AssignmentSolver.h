@@ -0,0 +1,41 @@
+#ifndef ASSIGNMENT_SOLVER_H
+#define ASSIGNMENT_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ASSIGNMENT_INFEASIBLE (INT64_MAX / 4)  // Cost of a pairing that must not be chosen
+
+/**
+ * Minimum-cost assignment of rows to columns (the Hungarian algorithm with potentials).
+ * Every row of the smaller side is matched to a different column of the other so the
+ * summed cost is as low as possible, in O(n^2 m) time for n rows and m columns. The
+ * working arrays are kept between calls so solving a window allocates nothing once the
+ * sizes have been seen.
+ */
+class AssignmentSolver {
+private:
+    std::vector<int64_t> rowPotential;
+    std::vector<int64_t> columnPotential;
+    std::vector<int64_t> slack;         // Least reduced cost into each column this round
+    std::vector<int> columnRow;         // Row matched to each column, 0 for none (1-based)
+    std::vector<int> previousColumn;    // Augmenting path back-pointers
+    std::vector<char> visited;
+    std::vector<int> rowColumn;         // The answer, one column per row
+
+    void solveWide(const std::vector<int64_t>& cost, int rows, int cols, bool transposed);
+
+public:
+    /**
+     * Finds the cheapest assignment
+     * @param cost The cost of each pairing, row-major with rows * cols entries
+     * @param rows The number of rows
+     * @param cols The number of columns
+     * @return For each row the column it is given, or -1 for rows left over when there are
+     *         more rows than columns
+     */
+    const std::vector<int>& solve(const std::vector<int64_t>& cost, int rows, int cols);
+};
+
+#endif // ASSIGNMENT_SOLVER_H
@@ -0,0 +1,163 @@
+#include "Checkpoint.h"
+#include "Logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+CheckpointWriter::CheckpointWriter() {
+    data.reserve(4096);
+    data.insert(data.end(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + 4);
+    data.push_back(CHECKPOINT_VERSION);
+}
+
+void CheckpointWriter::putInt(int64_t value) {
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80) {
+        data.push_back(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(zigzag));
+}
+
+void CheckpointWriter::putString(const std::string& text) {
+    putInt(static_cast<int64_t>(text.size()));
+    data.insert(data.end(), text.begin(), text.end());
+}
+
+void CheckpointWriter::putEvent(const Event& event) {
+    putString(event.time);
+    putString(event.source);
+    putString(event.floorButton);
+    putInt(event.elevatorButton);
+    putInt(event.isFromFloor);
+    putInt(event.assignedElevator);
+    putInt(event.currentFloor);
+    putInt(event.riders);
+    putInt(event.isComplete);
+    putInt(event.fault);
+    putInt(event.callMs);
+    putInt(event.answering);
+}
+
+void CheckpointWriter::putItinerary(const Itinerary& stops) {
+    putInt(static_cast<int64_t>(stops.pickups.size()));
+    for (const Itinerary::Pickup& pickup : stops.pickups) {
+        putInt(pickup.origin);
+        putInt(pickup.destination);
+        putInt(pickup.direction);
+    }
+    putInt(static_cast<int64_t>(stops.dropoffs.size()));
+    for (int dropoff : stops.dropoffs) {
+        putInt(dropoff);
+    }
+}
+
+/**
+ * Writes the checkpoint to a file
+ * @param fileName The file, replaced if it exists
+ * @return False if it could not be written
+ */
+bool CheckpointWriter::writeFile(const std::string& fileName) const {
+    FILE* file = std::fopen(fileName.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("Could not create checkpoint " << fileName << ": " << std::strerror(errno));
+        return false;
+    }
+    bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = (std::fclose(file) == 0) && written;
+    if (!written) {
+        LOG_ERROR("Error writing checkpoint " << fileName);
+    }
+    return written;
+}
+
+/**
+ * Reads a checkpoint file and checks its header
+ * @param fileName The file
+ * @return False if the file is missing or is not a checkpoint of this version
+ */
+bool CheckpointReader::readFile(const std::string& fileName) {
+    FILE* file = std::fopen(fileName.c_str(), "rb");
+    if (!file) {
+        LOG_ERROR("Could not open checkpoint " << fileName << ": " << std::strerror(errno));
+        return false;
+    }
+    data.clear();
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    std::fclose(file);
+
+    if (data.size() < CHECKPOINT_HEADER_SIZE || std::memcmp(data.data(), CHECKPOINT_MAGIC, 4) != 0
+        || data[4] != CHECKPOINT_VERSION) {
+        LOG_ERROR(fileName << " is not a checkpoint of version " << CHECKPOINT_VERSION);
+        return false;
+    }
+    position = CHECKPOINT_HEADER_SIZE;
+    return true;
+}
+
+int64_t CheckpointReader::getInt() {
+    uint64_t zigzag = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= data.size()) {
+            throw std::runtime_error("checkpoint ends early");
+        }
+        uint8_t byte = data[position++];
+        zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        }
+    }
+    throw std::runtime_error("checkpoint has a number that is too long");
+}
+
+size_t CheckpointReader::getCount() {
+    int64_t count = getInt();
+    if (count < 0 || static_cast<uint64_t>(count) > data.size() - position) {
+        throw std::runtime_error("checkpoint has a bad count");
+    }
+    return static_cast<size_t>(count);
+}
+
+std::string CheckpointReader::getString() {
+    size_t length = getCount();
+    std::string text(reinterpret_cast<const char*>(data.data() + position), length);
+    position += length;
+    return text;
+}
+
+Event CheckpointReader::getEvent() {
+    Event event;
+    event.time = getString();
+    event.source = getString();
+    event.floorButton = getString();
+    event.elevatorButton = static_cast<int>(getInt());
+    event.isFromFloor = getInt() != 0;
+    event.assignedElevator = static_cast<int>(getInt());
+    event.currentFloor = static_cast<int>(getInt());
+    event.riders = static_cast<int>(getInt());
+    event.isComplete = getInt() != 0;
+    event.fault = static_cast<int>(getInt());
+    event.callMs = getInt();
+    event.answering = static_cast<Direction>(getInt());
+    return event;
+}
+
+Itinerary CheckpointReader::getItinerary() {
+    Itinerary stops;
+    stops.pickups.resize(getCount());
+    for (Itinerary::Pickup& pickup : stops.pickups) {
+        pickup.origin = static_cast<int>(getInt());
+        pickup.destination = static_cast<int>(getInt());
+        pickup.direction = static_cast<Direction>(getInt());
+    }
+    stops.dropoffs.resize(getCount());
+    for (int& dropoff : stops.dropoffs) {
+        dropoff = static_cast<int>(getInt());
+    }
+    return stops;
+}
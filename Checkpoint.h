@@ -0,0 +1,81 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Event.h"
+#include "Itinerary.h"
+
+#define CHECKPOINT_MAGIC "ELVS"         // First bytes of every checkpoint file
+#define CHECKPOINT_VERSION 6
+#define CHECKPOINT_HEADER_SIZE 5        // Magic and version
+
+/**
+ * Builds a checkpoint in memory. Numbers are written as zigzag varints, so the small
+ * floors, counts and ids that make up most of the state take a byte each, and strings
+ * are written with their length so events come back exactly as they were.
+ */
+class CheckpointWriter {
+public:
+    CheckpointWriter();
+
+    void putInt(int64_t value);
+    void putString(const std::string& text);
+    void putEvent(const Event& event);
+    void putItinerary(const Itinerary& stops);
+
+    /**
+     * Writes the checkpoint to a file
+     * @param fileName The file, replaced if it exists
+     * @return False if it could not be written
+     */
+    bool writeFile(const std::string& fileName) const;
+
+    /**
+     * Gets the bytes written so far, header included
+     * @return The checkpoint
+     */
+    const std::vector<uint8_t>& bytes() const { return data; }
+
+private:
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Reads back what a CheckpointWriter wrote, in the same order. Reading past the end
+ * throws std::runtime_error, so a cut-off file is refused instead of half restored.
+ */
+class CheckpointReader {
+public:
+    /**
+     * Reads a checkpoint file and checks its header
+     * @param fileName The file
+     * @return False if the file is missing or is not a checkpoint of this version
+     */
+    bool readFile(const std::string& fileName);
+
+    int64_t getInt();
+    std::string getString();
+    Event getEvent();
+    Itinerary getItinerary();
+
+    /**
+     * Reads a count and checks it is no more than the bytes left could hold
+     * @return The count
+     */
+    size_t getCount();
+
+    /**
+     * Checks every byte was read
+     * @return True at the end of the checkpoint
+     */
+    bool atEnd() const { return position == data.size(); }
+
+private:
+    std::vector<uint8_t> data;
+    size_t position = 0;
+};
+
+#endif // CHECKPOINT_H
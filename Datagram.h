@@ -1,5 +1,7 @@
+ #include <algorithm>
  #include <vector>
  #include <exception>
+ #include <cstdint>
  #include <cstring>
  #include <sys/errno.h>
  #include <sys/types.h> 
@@ -19,34 +21,261 @@
  
  class DatagramPacket {
  public:
-     DatagramPacket( std::vector<uint8_t>& data, size_t length, in_addr_t address=INADDR_ANY, in_port_t port=0 ) : _data(data) {
+     DatagramPacket( std::vector<uint8_t>& data, size_t length, in_addr_t address=INADDR_ANY, in_port_t port=0 )
+     : DatagramPacket( data.data(), data.size(), length, address, port ) {}
+
+     /*
+      * Packet over a caller's buffer, such as one taken from a DatagramBufferPool.
+      */
+     DatagramPacket( uint8_t * data, size_t capacity, size_t length, in_addr_t address=INADDR_ANY, in_port_t port=0 )
+     : _data(data), _capacity(capacity) {
+     memset(&_address, 0, sizeof(_address));
      _address.sin_family = AF_INET; 
      _address.sin_port = port;
      _address.sin_addr.s_addr = address;
-     _length = std::min( data.size(), length );	// Take smaller value.
+     _length = std::min( capacity, length );	// Take smaller value.
      }
  
-     void * getData() const { return const_cast<void *>(static_cast<const void *>(_data.data())); }
+     void * getData() const { return _data; }
      size_t getLength() const { return _length; }
-     void setLength( size_t length ) { _length = std::min( length, _data.size() ); }
+     size_t getCapacity() const { return _capacity; }
+     void setLength( size_t length ) { _length = std::min( length, _capacity ); }
      in_addr_t getAddress() { return _address.sin_addr.s_addr; }
      in_port_t getPort() { return _address.sin_port; } 	// swap to host byte order.
      std::string getAddressAsString() const { return std::string( inet_ntoa( _address.sin_addr ) ); }
  
      struct sockaddr* address() { return reinterpret_cast<sockaddr*>(&_address); }
-     std::vector<uint8_t>::const_iterator begin() const { return _data.begin(); }
-     std::vector<uint8_t>::const_iterator end() const { return _data.end(); }
+     const uint8_t * begin() const { return _data; }
+     const uint8_t * end() const { return _data + _capacity; }
  
  private:
-     std::vector<uint8_t>& _data;	/* Don't copy data passed in constructor */
+     uint8_t * _data;	/* Don't copy data passed in constructor */
+     size_t _capacity;
      size_t _length;
      struct sockaddr_in _address;
  };
  
+ #define DATAGRAM_BATCH_SIZE 32      // Packets moved per system call by the batch APIs
+ #define DATAGRAM_PACKET_SIZE 256    // Bytes reserved for each packet in a batch, and the largest a socket takes in whole
+ #define DATAGRAM_POOL_SIZE 64       // Buffers in a DatagramBufferPool
+ #define DATAGRAM_SLAB_ALIGN 64      // Pool buffers start on their own cache line
+
+ class DatagramSocket;
+ class DatagramBufferPool;
+
+ /*
+  * A buffer on loan from a DatagramBufferPool, given back when the handle goes away.
+  */
+ class PooledBuffer {
+ public:
+     PooledBuffer() : _pool(nullptr), _slab(0) {}
+     PooledBuffer( PooledBuffer&& other ) noexcept : _pool(other._pool), _slab(other._slab) { other._pool = nullptr; }
+     PooledBuffer& operator=( PooledBuffer&& other ) noexcept {
+     if ( this != &other ) {
+         reset();
+         _pool = other._pool;
+         _slab = other._slab;
+         other._pool = nullptr;
+     }
+     return *this;
+     }
+     PooledBuffer( const PooledBuffer& ) = delete;
+     PooledBuffer& operator=( const PooledBuffer& ) = delete;
+     ~PooledBuffer() { reset(); }
+
+     /*
+      * False if the pool had no buffer free.
+      */
+     explicit operator bool() const { return _pool != nullptr; }
+
+     inline uint8_t * data() const;
+     inline size_t size() const;
+
+     /*
+      * Give the buffer back to its pool now.
+      */
+     inline void reset();
+
+ private:
+     friend class DatagramBufferPool;
+     PooledBuffer( DatagramBufferPool * pool, size_t slab ) : _pool(pool), _slab(slab) {}
+
+     DatagramBufferPool * _pool;
+     size_t _slab;
+ };
+
+ /*
+  * Fixed-size receive buffers carved out of one allocation.  Taking and giving back a
+  * buffer only moves an index on a free list that never grows past its first size, so a
+  * datagram can be received into a buffer, handed to the decoder and given back without
+  * touching the heap.  Not thread-safe: each receiving thread keeps its own pool, and the
+  * pool must outlive every buffer taken from it.
+  */
+ class DatagramBufferPool {
+ public:
+     DatagramBufferPool( size_t bufferSize, size_t count=DATAGRAM_POOL_SIZE )
+     : _stride(( bufferSize + DATAGRAM_SLAB_ALIGN - 1 ) / DATAGRAM_SLAB_ALIGN * DATAGRAM_SLAB_ALIGN),
+       _slabs(count * _stride + DATAGRAM_SLAB_ALIGN), _free(count), _bufferSize(bufferSize), _count(count) {
+     size_t offset = reinterpret_cast<uintptr_t>(_slabs.data()) % DATAGRAM_SLAB_ALIGN;
+     _base = _slabs.data() + ( offset ? DATAGRAM_SLAB_ALIGN - offset : 0 );
+     for ( size_t i = 0; i < count; i++ ) {
+         _free[i] = count - 1 - i;	// Lowest slab is taken first
+     }
+     }
+
+     /*
+      * Buffers sized for the largest datagram the socket takes in whole.
+      */
+     explicit inline DatagramBufferPool( const DatagramSocket& socket, size_t count=DATAGRAM_POOL_SIZE );
+
+     DatagramBufferPool( const DatagramBufferPool& ) = delete;
+     DatagramBufferPool& operator=( const DatagramBufferPool& ) = delete;
+
+     /*
+      * Take a free buffer, or an empty handle if every buffer is on loan.
+      */
+     PooledBuffer acquire() {
+     if ( _free.empty() ) {
+         return PooledBuffer();
+     }
+     size_t slab = _free.back();
+     _free.pop_back();
+     return PooledBuffer( this, slab );
+     }
+
+     size_t bufferSize() const { return _bufferSize; }
+     size_t capacity() const { return _count; }
+     size_t available() const { return _free.size(); }
+
+ private:
+     friend class PooledBuffer;
+
+     uint8_t * slab( size_t index ) const { return _base + index * _stride; }
+     void release( size_t index ) { _free.push_back( index ); }	// Never past the size reserved at construction
+
+     size_t _stride;
+     std::vector<uint8_t> _slabs;
+     std::vector<size_t> _free;
+     size_t _bufferSize;
+     size_t _count;
+     uint8_t * _base;
+ };
+
+ uint8_t * PooledBuffer::data() const { return _pool ? _pool->slab( _slab ) : nullptr; }
+ size_t PooledBuffer::size() const { return _pool ? _pool->bufferSize() : 0; }
+ void PooledBuffer::reset() {
+     if ( _pool ) {
+         _pool->release( _slab );
+         _pool = nullptr;
+     }
+ }
+
+ /*
+  * A preallocated array of packets for sendmmsg/recvmmsg.  Buffers, iovecs and
+  * addresses are set up once so sending or receiving a batch allocates nothing.
+  */
+ class DatagramBatch {
+ public:
+     DatagramBatch( size_t capacity=DATAGRAM_BATCH_SIZE, size_t packetSize=DATAGRAM_PACKET_SIZE )
+     : _buffers(capacity * packetSize), _messages(capacity), _iovecs(capacity), _addresses(capacity), _pool(nullptr), _loans(0), _packetSize(packetSize), _count(0) {
+     setup();
+     }
+
+     /*
+      * Receive-only batch whose packets land in buffers on loan from the pool.  Each
+      * receive takes a buffer for every packet slot that gave its last one up with take(),
+      * so the pool must hold at least capacity buffers to keep the batch full, and must
+      * outlive the batch.
+      */
+     DatagramBatch( DatagramBufferPool& pool, size_t capacity=DATAGRAM_BATCH_SIZE )
+     : _messages(capacity), _iovecs(capacity), _addresses(capacity), _pool(&pool), _loans(capacity), _packetSize(pool.bufferSize()), _count(0) {
+     setup();
+     }
+
+     size_t capacity() const { return _messages.size(); }
+     size_t size() const { return _count; }
+     bool full() const { return _count == _messages.size(); }
+     void clear() { _count = 0; }
+
+     /*
+      * Buffer of the next free packet, to be filled in before calling push.
+      */
+     uint8_t * slot() { return _buffers.data() + _count * _packetSize; }
+     size_t slotSize() const { return _packetSize; }
+
+     /*
+      * Queue the packet written into slot() for sending.
+      */
+     void push( size_t length, in_addr_t address, in_port_t port ) {
+     _iovecs[_count].iov_len = std::min( length, _packetSize );
+     _addresses[_count].sin_family = AF_INET;
+     _addresses[_count].sin_port = port;
+     _addresses[_count].sin_addr.s_addr = address;
+     _messages[_count].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+     _count++;
+     }
+
+     uint8_t * getData( size_t i ) { return static_cast<uint8_t *>( _iovecs[i].iov_base ); }
+     size_t getLength( size_t i ) const { return std::min<size_t>( _messages[i].msg_len, _packetSize ); }
+
+     /*
+      * Hand received packet i's pooled buffer to the caller, who gives it back to the pool
+      * by dropping the handle.  The slot takes a fresh buffer on the next receive.
+      */
+     PooledBuffer take( size_t i ) { return std::move( _loans[i] ); }
+
+     /*
+      * Whether received packet i was larger than its buffer and was cut off.
+      */
+     bool truncated( size_t i ) const { return ( _messages[i].msg_hdr.msg_flags & MSG_TRUNC ) != 0; }
+
+ private:
+     friend class DatagramSocket;
+
+     void setup() {
+     for ( size_t i = 0; i < _messages.size(); i++ ) {
+         _iovecs[i].iov_base = _pool ? nullptr : _buffers.data() + i * _packetSize;
+         _iovecs[i].iov_len = _packetSize;
+         _messages[i].msg_hdr.msg_iov = &_iovecs[i];
+         _messages[i].msg_hdr.msg_iovlen = 1;
+         _messages[i].msg_hdr.msg_name = &_addresses[i];
+         _messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+     }
+     }
+
+     // Restore full sized buffers and address lengths before a receive, taking pooled
+     // buffers for the slots that gave theirs up.  Returns how many packets fit.
+     size_t prepareReceive() {
+     _count = 0;
+     for ( size_t i = 0; i < _messages.size(); i++ ) {
+         if ( _pool && !_loans[i] ) {
+             _loans[i] = _pool->acquire();
+             if ( !_loans[i] ) {
+                 return i;	// Every buffer is on loan; receive into the slots that have one
+             }
+             _iovecs[i].iov_base = _loans[i].data();
+         }
+         _iovecs[i].iov_len = _packetSize;
+         _messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+         _messages[i].msg_hdr.msg_flags = 0;
+     }
+     return _messages.size();
+     }
+
+     std::vector<uint8_t> _buffers;
+     std::vector<struct mmsghdr> _messages;
+     std::vector<struct iovec> _iovecs;
+     std::vector<struct sockaddr_in> _addresses;
+     DatagramBufferPool * _pool;	// Null when the batch owns its buffers
+     std::vector<PooledBuffer> _loans;	// Pooled buffer behind each packet slot
+     size_t _packetSize;
+     size_t _count;
+ };
+
  // Creating socket file descriptor
  class DatagramSocket {
  public:
-     DatagramSocket() : socket_fd(socket(AF_INET, SOCK_DGRAM, 0)) {
+     DatagramSocket() : socket_fd(socket(AF_INET, SOCK_DGRAM, 0)), receive_size(DATAGRAM_PACKET_SIZE) {
      if ( socket_fd < 0 ) {
          throw std::runtime_error( std::string("socket creation failed: ") + strerror(errno) );
      }
@@ -54,13 +283,20 @@
  
      /*
       * Open a socket and bind to a specific port.  The socket is attached to all interfaces.
+      * Datagrams up to receiveSize bytes are taken in whole; buffers for it are sized from that.
       */
      
-     DatagramSocket(in_port_t port) : socket_fd(socket(AF_INET, SOCK_DGRAM, 0)) {
+     DatagramSocket(in_port_t port, size_t receiveSize=DATAGRAM_PACKET_SIZE) : socket_fd(socket(AF_INET, SOCK_DGRAM, 0)), receive_size(receiveSize) {
      if ( socket_fd < 0 ) {
          throw std::runtime_error( std::string("socket creation failed: ") + strerror(errno) );
      }
- 
+     bind( port );
+     }
+
+     /*
+      * Bind an already open socket to a specific port on all interfaces.
+      */
+     void bind(in_port_t port) {
      struct sockaddr_in address;
      memset(&address, 0, sizeof(address)); 
         
@@ -68,10 +304,9 @@
      address.sin_port = port; 
      address.sin_addr.s_addr = INADDR_ANY;		/* Bind to all local interfaces */
  
-     if ( bind(socket_fd, (const struct sockaddr *)&address, sizeof(address) ) < 0 ) {
+     if ( ::bind(socket_fd, (const struct sockaddr *)&address, sizeof(address) ) < 0 ) {
          throw std::runtime_error( std::string("socket bind failed") + strerror(errno) );
      }
-     
      }
      
      ~DatagramSocket() {
@@ -86,16 +321,74 @@
      return sent;
      }
      
-     void receive( DatagramPacket& packet ) {
-     socklen_t len = sizeof(*packet.address());
-     int received = recvfrom(socket_fd, packet.getData(), MAXLINE, MSG_WAITALL, packet.address(), &len);
+     /*
+      * Receive one datagram, writing no more than the packet's buffer holds.  Returns
+      * false if the datagram was larger than the buffer and was cut off.
+      */
+     bool receive( DatagramPacket& packet ) {
+     socklen_t len = sizeof(struct sockaddr_in);
+     ssize_t received = recvfrom(socket_fd, packet.getData(), packet.getCapacity(), MSG_TRUNC, packet.address(), &len);
      if ( received < 0 ) {
          throw std::runtime_error( std::string("recvfrom failed: ") + strerror(errno) );
      }
-     packet.setLength(received);
+     packet.setLength(received);	// With MSG_TRUNC this is the whole datagram's length
+     return static_cast<size_t>(received) <= packet.getCapacity();
+     }
+
+     /*
+      * Send every queued packet in the batch, using as few sendmmsg calls as possible.
+      * The batch is cleared afterwards.
+      */
+     size_t sendBatch( DatagramBatch& batch ) {
+     size_t sent = 0;
+     while ( sent < batch._count ) {
+         int result = sendmmsg( socket_fd, &batch._messages[sent], batch._count - sent, 0 );
+         if ( result == -1 ) {
+             batch.clear();
+             throw std::runtime_error( std::string("sendmmsg failed: ") + strerror(errno) );
+         }
+         sent += result;
+     }
+     batch.clear();
+     return sent;
+     }
+
+     /*
+      * Block until at least one packet arrives, then take every packet already queued
+      * on the socket up to the batch capacity.  Returns the number of packets received.
+      * With wait=false the call never blocks and returns 0 if nothing is queued.  A pooled
+      * batch also returns 0 at once if its pool has no buffer left to receive into.
+      */
+     size_t receiveBatch( DatagramBatch& batch, bool wait=true ) {
+     size_t room = batch.prepareReceive();
+     if ( room == 0 ) {
+         return 0;
+     }
+     int received = recvmmsg( socket_fd, batch._messages.data(), room, wait ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr );
+     if ( received < 0 ) {
+         if ( !wait && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+             return 0;
+         }
+         throw std::runtime_error( std::string("recvmmsg failed: ") + strerror(errno) );
+     }
+     batch._count = received;
+     return received;
      }
      
+     /*
+      * Descriptor of the socket, for registering with a Reactor.
+      */
+     int fd() const { return socket_fd; }
+
+     /*
+      * Largest datagram the socket takes in whole, the size to give its receive buffers.
+      */
+     size_t receiveSize() const { return receive_size; }
+
  private:
      int socket_fd;
-     static const size_t MAXLINE=1024;
+     size_t receive_size;
  };
+
+ DatagramBufferPool::DatagramBufferPool( const DatagramSocket& socket, size_t count )
+ : DatagramBufferPool( socket.receiveSize(), count ) {}
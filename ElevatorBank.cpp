@@ -0,0 +1,68 @@
+#include "ElevatorBank.h"
+#include "Logger.h"
+
+/**
+ * Constructor for the ElevatorBank class
+ * @param s The scheduler instance
+ * @param elevatorCount The number of elevators
+ * @param threads Worker threads; 0 starts one per core
+ */
+ElevatorBank::ElevatorBank(Scheduler& s, int elevatorCount, unsigned threads)
+    : scheduler(s), pool(threads), endpoint(s.getTransport().open(ELEVATOR_PORT, SENDERS_ONE)) {
+    scheduler.setElevatorBankPort(ELEVATOR_PORT);
+    cars.reserve(elevatorCount);
+    for (int i = 0; i < elevatorCount; i++) {
+        cars.push_back(std::make_unique<ElevatorSubsystem>(scheduler, i, *this));
+    }
+    LOG_INFO("Created " << elevatorCount << " elevators on " << pool.size() << " worker threads, port " << ELEVATOR_PORT);
+}
+
+/**
+ * Destructor stops the worker pool before the cars are freed
+ */
+ElevatorBank::~ElevatorBank() {
+    pool.stop();
+}
+
+/**
+ * Registers the bank's endpoint with an event loop
+ * @param reactor The event loop to run on
+ */
+void ElevatorBank::registerWith(Reactor& reactor) {
+    reactor.addReadable(endpoint->fd(), [this]() { handleEvents(); });
+}
+
+/**
+ * Hands every assignment waiting at the endpoint to the car it is for
+ */
+void ElevatorBank::handleEvents() {
+    try {
+        endpoint->receive(inbound);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error receiving event: " << e.what());
+        return;
+    }
+
+    for (const Event& event : inbound) {
+        if (event.assignedElevator < 0 || event.assignedElevator >= size()) {
+            LOG_WARN("Dropped assignment for unknown elevator " << event.assignedElevator);
+            continue;
+        }
+        cars[event.assignedElevator]->accept(event);
+    }
+}
+
+/**
+ * Sends a car's response to the scheduler
+ * @param response The response
+ */
+void ElevatorBank::sendResponse(const Event& response) {
+    try {
+        std::lock_guard<std::mutex> lock(sendMtx);
+        endpoint->send(SCHEDULER_PORT, response);
+        endpoint->flush();
+        LOG_INFO("Elevator subsystem " << response.assignedElevator << " sent response to scheduler");
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error sending response: " << e.what());
+    }
+}
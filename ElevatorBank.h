@@ -0,0 +1,73 @@
+#ifndef ELEVATOR_BANK_H
+#define ELEVATOR_BANK_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ElevatorSubsystem.h"
+
+/**
+ * Every elevator of a building in one object. The cars run as coroutines on a shared
+ * worker pool instead of a thread each, and one endpoint at ELEVATOR_PORT receives the
+ * assignments for all of them, so a fleet of thousands of cars costs a few threads and
+ * one descriptor.
+ */
+class ElevatorBank {
+private:
+    Scheduler& scheduler;
+    WorkerPool pool;                        // Resumes the cars' coroutines
+    std::unique_ptr<Endpoint> endpoint;     // Receives assignments for every car and sends their responses
+    std::mutex sendMtx;                     // Cars on different workers share the endpoint to send
+    std::vector<Event> inbound;             // Assignments drained from the endpoint on each wakeup
+    std::vector<std::unique_ptr<ElevatorSubsystem>> cars;
+
+    void handleEvents();
+
+public:
+    /**
+     * Constructor for the ElevatorBank class. Tells the scheduler to send every
+     * assignment to ELEVATOR_PORT.
+     * @param s The scheduler instance
+     * @param elevatorCount The number of elevators
+     * @param threads Worker threads; 0 starts one per core
+     */
+    ElevatorBank(Scheduler& s, int elevatorCount, unsigned threads = 0);
+
+    /**
+     * Destructor stops the worker pool before the cars are freed
+     */
+    ~ElevatorBank();
+
+    /**
+     * Registers the bank's endpoint with an event loop so assignments reach the cars as soon as they arrive
+     * @param reactor The event loop to run on
+     */
+    void registerWith(Reactor& reactor);
+
+    /**
+     * Sends a car's response to the scheduler. Any worker may call this.
+     * @param response The response
+     */
+    void sendResponse(const Event& response);
+
+    /**
+     * Gets the pool the cars run on
+     * @return The worker pool
+     */
+    WorkerPool& getPool() { return pool; }
+
+    /**
+     * Gets one car
+     * @param id The elevator ID
+     * @return The car's subsystem
+     */
+    ElevatorSubsystem& getCar(int id) { return *cars[id]; }
+
+    /**
+     * Get the number of elevators in the bank
+     * @return The number of elevators
+     */
+    int size() const { return static_cast<int>(cars.size()); }
+};
+
+#endif // ELEVATOR_BANK_H
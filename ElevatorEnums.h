@@ -21,6 +21,16 @@ enum elevatorState {
     ELEVATOR_DOOR_CLOSE
 };
 
+// Phases of the stop cycle, stepped through by Elevator::advance
+enum elevatorPhase {
+    PHASE_IDLE,         // No stops left
+    PHASE_MOVING,       // Travelling to the next stop
+    PHASE_OPENING,      // Opening doors at a stop
+    PHASE_TRANSFER,     // Passengers leaving and boarding
+    PHASE_CLOSING,      // Closing doors before the next leg
+    PHASE_RECOVERING    // Out of service after a fault, waiting to be released
+};
+
 // Direction enumeration 
 enum Direction {
     DIRECTION_UP,
@@ -28,4 +38,17 @@ enum Direction {
     DIRECTION_IDLE
 };
 
+// Policies the scheduler can assign hall calls with
+enum DispatchPolicy {
+    DISPATCH_HEURISTIC, // Score by distance, direction and whether the car is busy
+    DISPATCH_LOOK,      // Collective control: the car that reaches the call soonest on its sweep
+    DISPATCH_ETA        // The car with the earliest estimated arrival, from travel, door and transfer times
+};
+
+// Encoding used for events sent between subsystems
+enum WireFormat {
+    WIRE_TEXT,      // Comma separated text, easy to read in a packet capture
+    WIRE_BINARY     // Fixed-layout binary record
+};
+
 #endif // ELEVATOR_ENUMS_H
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "ElevatorFleet.h"
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLEET_X86 1
+#endif
+
+/**
+ * Creates a fleet of cars resting at floor 1
+ * @param count The number of cars
+ */
+ElevatorFleet::ElevatorFleet(int count)
+    : currentFloor(count, 1), state(count, elevatorState::ELEVATOR_REST), busy(count, 0),
+      passengers(count, 0), totalPassengers(count, 0), load(count, 0), stops(count),
+      sweep(count, Direction::DIRECTION_IDLE), moving(count, 0), live((count + 63) / 64, 0) {
+    for (int i = 0; i < count; i++) {
+        live[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+/**
+ * Checks if the AVX2 kernel can run on this CPU
+ * @return True if scoreHeuristic uses AVX2
+ */
+bool ElevatorFleet::hasAvx2() {
+#ifdef FLEET_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Scores every car for a hall call
+ * @param originFloor The floor the call was made on
+ * @param isGoingUp Whether the caller is going up
+ * @param scores Output, one score per car
+ * @param allowSimd False to force the scalar kernel
+ */
+void ElevatorFleet::scoreHeuristic(int originFloor, bool isGoingUp, int32_t* scores, bool allowSimd) const {
+    if (allowSimd && hasAvx2()) {
+        scoreAvx2(originFloor, isGoingUp, scores);
+    } else {
+        scoreScalar(originFloor, isGoingUp, scores, 0);
+    }
+}
+
+/**
+ * Scores cars one at a time
+ * @param originFloor The floor the call was made on
+ * @param isGoingUp Whether the caller is going up
+ * @param scores Output, one score per car
+ * @param from The first car to score
+ */
+void ElevatorFleet::scoreScalar(int originFloor, bool isGoingUp, int32_t* scores, int from) const {
+    for (int i = from; i < size(); i++) {
+        if (!isLive(i)) {
+            scores[i] = SCORE_REMOVED;
+            continue;
+        }
+        int floor = currentFloor[i];
+        bool goingUp = state[i] == elevatorState::ELEVATOR_MOVING_UP;
+        bool goingDown = state[i] == elevatorState::ELEVATOR_MOVING_DOWN;
+        bool atRest = !goingUp && !goingDown;
+
+        int score = SCORE_BASE + busy[i] * SCORE_BUSY + std::abs(floor - originFloor) * SCORE_PER_FLOOR;
+        if (isFull(i)) {
+            score += SCORE_FULL;
+        }
+        if (isGoingUp) {
+            if (goingUp && floor <= originFloor) {
+                score -= SCORE_ON_THE_WAY;
+            } else if (atRest) {
+                score -= SCORE_AT_REST;
+            }
+        } else {
+            if (goingDown && floor >= originFloor) {
+                score -= SCORE_ON_THE_WAY;
+            } else if (floor > originFloor) {
+                score -= SCORE_ABOVE;
+            } else if (atRest) {
+                score -= SCORE_AT_REST;
+            }
+        }
+        scores[i] = score;
+    }
+}
+
+#ifdef FLEET_X86
+/**
+ * Scores eight cars per step with AVX2, finishing any remainder with the scalar kernel.
+ * Each branch of the scalar kernel becomes a lane mask and the adjustments are blended.
+ * @param originFloor The floor the call was made on
+ * @param isGoingUp Whether the caller is going up
+ * @param scores Output, one score per car
+ */
+__attribute__((target("avx2")))
+void ElevatorFleet::scoreAvx2(int originFloor, bool isGoingUp, int32_t* scores) const {
+    const __m256i origin = _mm256_set1_epi32(originFloor);
+    const __m256i base = _mm256_set1_epi32(SCORE_BASE);
+    const __m256i busyScore = _mm256_set1_epi32(SCORE_BUSY);
+    const __m256i perFloor = _mm256_set1_epi32(SCORE_PER_FLOOR);
+    const __m256i onTheWay = _mm256_set1_epi32(SCORE_ON_THE_WAY);
+    const __m256i above = _mm256_set1_epi32(SCORE_ABOVE);
+    const __m256i atRestScore = _mm256_set1_epi32(SCORE_AT_REST);
+    const __m256i fullScore = _mm256_set1_epi32(SCORE_FULL);
+    const __m256i roomLeft = _mm256_set1_epi32(ELEVATOR_CAPACITY - 1);
+    const __m256i removed = _mm256_set1_epi32(SCORE_REMOVED);
+    const __m256i movingUp = _mm256_set1_epi32(elevatorState::ELEVATOR_MOVING_UP);
+    const __m256i movingDown = _mm256_set1_epi32(elevatorState::ELEVATOR_MOVING_DOWN);
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    int count = size();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i floor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&currentFloor[i]));
+        __m256i carState = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&state[i]));
+        __m256i carBusy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&busy[i]));
+        __m256i carLoad = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&load[i]));
+
+        __m256i score = _mm256_add_epi32(base, _mm256_mullo_epi32(carBusy, busyScore));
+        __m256i distance = _mm256_abs_epi32(_mm256_sub_epi32(floor, origin));
+        score = _mm256_add_epi32(score, _mm256_mullo_epi32(distance, perFloor));
+        __m256i full = _mm256_cmpgt_epi32(carLoad, roomLeft);
+        score = _mm256_add_epi32(score, _mm256_and_si256(full, fullScore));
+
+        __m256i goingUp = _mm256_cmpeq_epi32(carState, movingUp);
+        __m256i goingDown = _mm256_cmpeq_epi32(carState, movingDown);
+        __m256i isAbove = _mm256_cmpgt_epi32(floor, origin);
+        __m256i isBelow = _mm256_cmpgt_epi32(origin, floor);
+        __m256i restBonus = _mm256_andnot_si256(_mm256_or_si256(goingUp, goingDown), atRestScore);
+
+        // Later blends take priority, matching the order of the scalar if/else chain
+        __m256i bonus;
+        if (isGoingUp) {
+            __m256i approaching = _mm256_andnot_si256(isAbove, goingUp);
+            bonus = _mm256_blendv_epi8(restBonus, onTheWay, approaching);
+        } else {
+            __m256i approaching = _mm256_andnot_si256(isBelow, goingDown);
+            bonus = _mm256_blendv_epi8(restBonus, above, isAbove);
+            bonus = _mm256_blendv_epi8(bonus, onTheWay, approaching);
+        }
+        score = _mm256_sub_epi32(score, bonus);
+
+        // Eight bits of the liveness bitset become eight lane masks
+        int bits = static_cast<int>((live[i / 64] >> (i % 64)) & 0xFF);
+        __m256i alive = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), laneBits), laneBits);
+        score = _mm256_blendv_epi8(removed, score, alive);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&scores[i]), score);
+    }
+    scoreScalar(originFloor, isGoingUp, scores, i);
+}
+
+/**
+ * Finds the lowest score eight lanes at a time, then the first car with it
+ * @param scores Scores from scoreHeuristic
+ * @return The car, or -1 if every car is out of service
+ */
+__attribute__((target("avx2")))
+int ElevatorFleet::lowestScoreAvx2(const int32_t* scores) const {
+    int count = size();
+    __m256i lowest = _mm256_set1_epi32(SCORE_REMOVED);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        lowest = _mm256_min_epi32(lowest, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&scores[i])));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), lowest);
+    int32_t bestScore = SCORE_REMOVED;
+    for (int32_t lane : lanes) bestScore = std::min(bestScore, lane);
+    for (int j = i; j < count; j++) bestScore = std::min(bestScore, scores[j]);
+    if (bestScore == SCORE_REMOVED) {
+        return -1;
+    }
+
+    const __m256i target = _mm256_set1_epi32(bestScore);
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m256i match = _mm256_cmpeq_epi32(target, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&scores[i])));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(match));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < count; i++) {
+        if (scores[i] == bestScore) return i;
+    }
+    return -1;
+}
+#else
+void ElevatorFleet::scoreAvx2(int originFloor, bool isGoingUp, int32_t* scores) const {
+    scoreScalar(originFloor, isGoingUp, scores, 0);
+}
+
+int ElevatorFleet::lowestScoreAvx2(const int32_t* scores) const {
+    return lowestScore(scores, false);
+}
+#endif
+
+/**
+ * Finds the live car with the lowest score, the lowest id winning ties
+ * @param scores Scores from scoreHeuristic
+ * @param allowSimd False to force the scalar search
+ * @return The car, or -1 if every car is out of service
+ */
+int ElevatorFleet::lowestScore(const int32_t* scores, bool allowSimd) const {
+    if (allowSimd && hasAvx2()) {
+        return lowestScoreAvx2(scores);
+    }
+    int best = -1;
+    int32_t bestScore = SCORE_REMOVED;
+    for (int i = 0; i < size(); i++) {
+        if (scores[i] < bestScore) {
+            bestScore = scores[i];
+            best = i;
+        }
+    }
+    return best;
+}
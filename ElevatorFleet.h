@@ -0,0 +1,96 @@
+#ifndef ELEVATOR_FLEET_H
+#define ELEVATOR_FLEET_H
+
+#include <cstdint>
+#include <vector>
+#include "ElevatorEnums.h"
+#include "Itinerary.h"
+
+// Terms of the scoring heuristic (lower scores win)
+#define SCORE_BASE 1000         // Every live car starts here
+#define SCORE_BUSY 5000         // Added for a car that is already serving a call
+#define SCORE_PER_FLOOR 10      // Added per floor between the car and the call
+#define SCORE_ON_THE_WAY 500    // Taken off for a car already heading to the call in its direction
+#define SCORE_ABOVE 400         // Taken off for any car above a downward call
+#define SCORE_AT_REST 300       // Taken off for a car that is not moving
+#define SCORE_FULL 1000000      // Added for a full car, so it only gets a call when every car is full
+#define SCORE_REMOVED INT32_MAX // Score of a car that has been taken out of service
+
+/**
+ * State of every car the scheduler tracks, stored column by column so a whole fleet
+ * can be scored in one pass over contiguous memory. Car i is row i of every column,
+ * and bit i of the liveness bitset says whether it is still in service.
+ */
+struct ElevatorFleet {
+    std::vector<int32_t> currentFloor;
+    std::vector<int32_t> state;             // elevatorState of each car
+    std::vector<int32_t> busy;              // 1 while the car is serving a call
+    std::vector<int32_t> passengers;
+    std::vector<int32_t> totalPassengers;
+    std::vector<int32_t> load;              // Passengers riding or assigned and waiting, see Itinerary::load
+    std::vector<Itinerary> stops;           // Calls assigned to each car that it has not finished
+    std::vector<Direction> sweep;           // Direction each car last reported moving in
+    std::vector<uint8_t> moving;            // 1 between leaving a floor and arriving at the next stop
+    std::vector<uint64_t> live;             // Liveness bitset, one bit per car
+
+    /**
+     * Creates a fleet of cars resting at floor 1
+     * @param count The number of cars
+     */
+    explicit ElevatorFleet(int count);
+
+    int size() const { return static_cast<int>(currentFloor.size()); }
+
+    bool isLive(int id) const {
+        return id >= 0 && id < size() && (live[id / 64] >> (id % 64)) & 1;
+    }
+
+    /**
+     * Takes a car out of service
+     * @param id The car
+     */
+    void remove(int id) {
+        if (id >= 0 && id < size()) live[id / 64] &= ~(uint64_t(1) << (id % 64));
+    }
+
+    /**
+     * Puts a car back in service
+     * @param id The car
+     */
+    void restore(int id) {
+        if (id >= 0 && id < size()) live[id / 64] |= uint64_t(1) << (id % 64);
+    }
+
+    bool isFull(int id) const { return load[id] >= ELEVATOR_CAPACITY; }
+
+    /**
+     * Scores every car for a hall call. Cars out of service score SCORE_REMOVED.
+     * Uses the AVX2 kernel when the CPU has it.
+     * @param originFloor The floor the call was made on
+     * @param isGoingUp Whether the caller is going up
+     * @param scores Output, one score per car
+     * @param allowSimd False to force the scalar kernel
+     */
+    void scoreHeuristic(int originFloor, bool isGoingUp, int32_t* scores, bool allowSimd = true) const;
+
+    /**
+     * Finds the live car with the lowest score, the lowest id winning ties
+     * @param scores Scores from scoreHeuristic
+     * @param allowSimd False to force the scalar search
+     * @return The car, or -1 if every car is out of service
+     */
+    int lowestScore(const int32_t* scores, bool allowSimd = true) const;
+
+    /**
+     * Checks if the AVX2 kernel can run on this CPU
+     * @return True if scoreHeuristic uses AVX2
+     */
+    static bool hasAvx2();
+
+private:
+    void scoreScalar(int originFloor, bool isGoingUp, int32_t* scores, int from) const;
+    void scoreAvx2(int originFloor, bool isGoingUp, int32_t* scores) const;
+    int lowestScoreAvx2(const int32_t* scores) const;
+};
+
+#endif // ELEVATOR_FLEET_H
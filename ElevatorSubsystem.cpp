@@ -1,63 +1,172 @@
 #include "ElevatorSubsystem.h"
+#include "Logger.h"
+#include "Simulation.h"
+#include "ElevatorBank.h"
+#include <chrono>
 #include <iostream>
 #include <thread>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
 
 /**
  * Constructor for ElevatorSubsystem
  * @param s Reference to the Scheduler
  * @param id The ID for this elevator
- * @param port The UDP port to listen on
+ * @param port The port to listen on, opened on the scheduler's transport
  */
 ElevatorSubsystem::ElevatorSubsystem(Scheduler& s, int id, int port) 
-    : scheduler(s), mtx(), elevatorId(id), receiveSocket(port), sendSocket() {
+    : scheduler(s), mtx(), elevatorId(id), endpoint(s.getTransport().open(port, SENDERS_ONE)), inboundNext(0),
+      simulation(nullptr), advancing(false), bank(nullptr) {
     
     // Create an elevator
     elevator = std::make_unique<Elevator>(*this, elevatorId);  
 
     // Create an elevator thread 
-    std::cout << "Created elevator " << elevatorId << " on port " << port << std::endl;
+    LOG_INFO("Created elevator " << elevatorId << " on port " << port);
     elevatorThread = std::thread(&Elevator::run, elevator.get());
 }
 
+/**
+ * Constructor for an ElevatorSubsystem stepped by a simulation
+ * @param s Reference to the Scheduler
+ * @param id The ID for this elevator
+ * @param sim The simulation that owns the virtual clock
+ */
+ElevatorSubsystem::ElevatorSubsystem(Scheduler& s, int id, Simulation& sim) 
+    : scheduler(s), mtx(), elevatorId(id), inboundNext(0), simulation(&sim), advancing(false), bank(nullptr) {
+    elevator = std::make_unique<Elevator>(*this, elevatorId);
+}
+
+/**
+ * Constructor for an ElevatorSubsystem run as a coroutine on a bank's worker pool
+ * @param s Reference to the Scheduler
+ * @param id The ID for this elevator
+ * @param owner The bank the elevator belongs to
+ */
+ElevatorSubsystem::ElevatorSubsystem(Scheduler& s, int id, ElevatorBank& owner)
+    : scheduler(s), mtx(), elevatorId(id), inboundNext(0), simulation(nullptr), advancing(false), bank(&owner) {
+    elevator = std::make_unique<Elevator>(*this, elevatorId);
+    driver = elevator->drive(owner.getPool());
+}
+
+/**
+ * Adds an assigned event to the elevator's itinerary and starts it stepping if it is idle
+ * @param event The event assigned to this elevator
+ */
+void ElevatorSubsystem::dispatch(const Event& event) {
+    elevator->assign(event);
+    if (!advancing && !elevator->outOfService) {
+        advancing = true;
+        scheduleAdvance(0);
+    }
+}
+
+/**
+ * Schedules the next step of the elevator's stop cycle on the simulation clock
+ * @param delay Milliseconds of simulated time until the step is due
+ */
+void ElevatorSubsystem::scheduleAdvance(int delay) {
+    simulation->scheduleAdvance(elevatorId, delay);
+}
+
+/**
+ * Runs the elevator's next simulated step and schedules the one after it
+ */
+void ElevatorSubsystem::step() {
+    int next = elevator->advance();
+    if (next >= 0) {
+        scheduleAdvance(next);
+    } else {
+        // No stops left; the next dispatch starts the elevator again
+        advancing = false;
+    }
+}
+
+/**
+ * Writes the elevator and whether it has a step scheduled to a checkpoint
+ * @param out The checkpoint
+ */
+void ElevatorSubsystem::saveState(CheckpointWriter& out) {
+    out.putInt(advancing);
+    elevator->save(out);
+}
+
+/**
+ * Replaces the elevator's state with one saved by saveState
+ * @param in The checkpoint
+ */
+void ElevatorSubsystem::restoreState(CheckpointReader& in) {
+    advancing = in.getInt() != 0;
+    elevator->restore(in);
+}
+
+/**
+ * Reads the clock trip times are measured on
+ * @return Simulated milliseconds, or milliseconds of real time when running in real time
+ */
+long long ElevatorSubsystem::now() const {
+    if (simulation) {
+        return simulation->now();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void ElevatorSubsystem::removeElevator() {
     scheduler.removeElevator(elevatorId);
 }
 
+/**
+ * Returns the elevator to service after it has recovered from a fault
+ */
+void ElevatorSubsystem::restoreElevator() {
+    scheduler.restoreElevator(elevatorId);
+}
+
+/**
+ * Takes a request the elevator could not board off its stops at the scheduler
+ * @param event The floor request
+ */
+void ElevatorSubsystem::releaseCall(const Event& event) {
+    scheduler.releaseCall(elevatorId, event);
+}
+
 bool ElevatorSubsystem::receiveEvent(Event& event) {
     try {
-        std::vector<uint8_t> data(100);
-        DatagramPacket packet(data, data.size());
         // Non-blocking check
         if (scheduler.isFinish()) return false;
 
-        // Receive the packet
-        receiveSocket.receive(packet);
-
-        event = Event::bytes_to_event(data);
+        // Wait for the endpoint unless events are left from the last receive
+        while (inboundNext == inbound.size()) {
+            struct pollfd ready = {endpoint->fd(), POLLIN, 0};
+            if (poll(&ready, 1, -1) < 0 && errno != EINTR) {
+                throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+            }
+            endpoint->receive(inbound);
+            inboundNext = 0;
+        }
+        event = std::move(inbound[inboundNext++]);
         // Make sure this event is for this elevator
         return (event.assignedElevator == elevatorId);
     } catch (const std::exception& e) {
-        std::cerr << "Error receiving event: " << e.what() << std::endl;
+        LOG_ERROR("Error receiving event: " << e.what());
         return false;
     }
 }
 
 /**
- * Send a response via UDP
+ * Send a response to the scheduler
  * @param response The response to send
  */
 void ElevatorSubsystem::sendResponse(const Event& response) {
     try {
-        // Serialize the response
-        std::vector<uint8_t> data = response.event_to_bytes();
+        endpoint->send(SCHEDULER_PORT, response);
+        endpoint->flush();
         
-        // Create and send the packet to the scheduler
-        DatagramPacket packet(data, data.size(), InetAddress::getLocalHost(), SCHEDULER_PORT);
-        sendSocket.send(packet);
-        
-        std::cout << "Elevator subsystem " << elevatorId << " sent response to scheduler" << std::endl;
+        LOG_INFO("Elevator subsystem " << elevatorId << " sent response to scheduler");
     } catch (const std::exception& e) {
-        std::cerr << "Error sending response: " << e.what() << std::endl;
+        LOG_ERROR("Error sending response: " << e.what());
     }
 }
 
@@ -66,6 +175,14 @@ void ElevatorSubsystem::sendResponse(const Event& response) {
  * @param response The response event generated by the elevator
  */
 void ElevatorSubsystem::addElevatorResponse(Event response) {
+    if (simulation) {
+        simulation->handleElevatorResponse(response);
+        return;
+    }
+    if (bank) {
+        bank->sendResponse(response);
+        return;
+    }
     sendResponse(response);
     cv.notify_all();  
 }
@@ -80,22 +197,54 @@ bool ElevatorSubsystem::isFinish(){
 
 /**
  * Main loop for the elevator subsystem to process events
- * Continuously fetches events from the scheduler and assigns them to the elevator
+ * Waits on an event loop and hands each assignment to the elevator as it arrives
 */
 void ElevatorSubsystem::run() {
-    while (!scheduler.isFinish()) {
-        Event event;     
-        if (receiveEvent(event)){
-            std::cout << "ElevatorSubsystem " << elevatorId << " received event, Time=" << event.time 
-                     << ", Source=" << event.source << std::endl;
-
-            std::lock_guard<std::mutex> lock(elevator->mtx);
-            elevator->setEvent(event);
-            elevator->cv.notify_all(); // Notify elevator
-        }
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    Reactor reactor;
+    scheduler.addReactor(&reactor);
+    registerWith(reactor);
+    if (!scheduler.isFinish()) {
+        reactor.run();
     }
+    scheduler.removeReactor(&reactor);
+}
+
+/**
+ * Registers the elevator endpoint with an event loop
+ * @param reactor The event loop to run on
+ */
+void ElevatorSubsystem::registerWith(Reactor& reactor) {
+    reactor.addReadable(endpoint->fd(), [this]() { handleEvents(); });
+}
+
+/**
+ * Hands every assignment waiting at the endpoint to the elevator
+ */
+void ElevatorSubsystem::handleEvents() {
+    try {
+        endpoint->receive(inbound);
+        inboundNext = inbound.size();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error receiving event: " << e.what());
+        return;
+    }
+
+    for (const Event& event : inbound) {
+        accept(event);
+    }
+}
+
+/**
+ * Hands an assignment received for this elevator to the elevator
+ * @param event The event; events for other elevators are ignored
+ */
+void ElevatorSubsystem::accept(const Event& event) {
+    // Make sure this event is for this elevator
+    if (event.assignedElevator != elevatorId) return;
+
+    LOG_INFO("ElevatorSubsystem " << elevatorId << " received event, Time=" << event.time 
+             << ", Source=" << event.source);
+    elevator->post(event);
 }
 
 /**
@@ -114,9 +263,22 @@ ElevatorSubsystem::~ElevatorSubsystem() {
  * @return If move to was successfull
  */
 bool Elevator::moveTo(int dstn) {
+    int delay = beginMove(dstn);
+    do {
+        pause(delay);
+    } while ((delay = awaitArrival()) >= 0);
+    return endMove(dstn);
+}
+
+/**
+ * Starts moving the elevator towards the destination floor
+ * @param dstn The destination floor
+ * @return Time in milliseconds until the car is due to arrive
+ */
+int Elevator::beginMove(int dstn) {
     if (curr_floor == dstn) {
         state = elevatorState::ELEVATOR_REST;
-        return true;
+        return 0;
     }
     // Set the appropriate movement state
     state = (dstn > curr_floor) ? elevatorState::ELEVATOR_MOVING_UP : elevatorState::ELEVATOR_MOVING_DOWN;
@@ -138,33 +300,87 @@ bool Elevator::moveTo(int dstn) {
     };
     elevatorSubsystem.addElevatorResponse(stateUpdate);
     
-    std::cout << "Elevator " << elevatorId << " is moving from " << curr_floor << " to " << dstn << "." << std::endl;
+    LOG_INFO("Elevator " << elevatorId << " is moving from " << curr_floor << " to " << dstn << ".");
     
-    // Check for fault with this part
-    if(event.fault == ELEVATOR_STUCK) {
-        // Make timer go off before getting to destination
-        std::this_thread::sleep_for(std::chrono::seconds(moveBetweenFloorsTime(dstn) - 3));
-        std::cout << "Timer went off!"<< std::endl;
-        std::cout << "Elevator " << elevatorId << " got stuck while moving from " << curr_floor << " to " << dstn << "." << std::endl;
-        return false;
-        
+    // The arrival sensor reports when the car reaches the floor, and the watchdog armed
+    // here allows it ARRIVAL_WATCHDOG_MS more. A car that stops short, or whose sensor
+    // fails, never reports, so the watchdog goes off instead.
+    int travelMs = moveBetweenFloorsTime(dstn) * 1000;
+    long long startMs = elevatorSubsystem.now();
+    bool reports = event.fault != ELEVATOR_STUCK && event.fault != ARRIVAL_SENSOR_ISSUE;
+    arrivalDueMs = reports ? startMs + travelMs : -1;
+    armWatchdog(startMs + travelMs + ARRIVAL_WATCHDOG_MS);
+    return travelMs;
+}
+
+/**
+ * Arms the arrival watchdog of the current move on the car's timing wheel
+ * @param dueMs When it goes off on the subsystem's clock
+ */
+void Elevator::armWatchdog(long long dueMs) {
+    watchdogFired = false;
+    watchdogDueMs = dueMs;
+    watchdog = timers.scheduleAt(dueMs, [this]() {
+        LOG_INFO("Arrival watchdog went off!");
+        watchdog = 0;
+        watchdogDueMs = -1;
+        watchdogFired = true;
+    });
+}
+
+/**
+ * Checks on a move once it is due: the arrival report cancels the watchdog, and
+ * without one the car waits until the watchdog goes off
+ * @return Milliseconds until the move is due to be checked again, or -1 once the car
+ *         has reported arriving or its watchdog has gone off
+ */
+int Elevator::awaitArrival() {
+    long long nowMs = elevatorSubsystem.now();
+    if (arrivalDueMs >= 0 && nowMs >= arrivalDueMs) {
+        arrivalDueMs = -1;
+        timers.cancel(watchdog);
+        watchdog = 0;
+        watchdogDueMs = -1;
+        return -1;
     }
-    else if(event.fault == ARRIVAL_SENSOR_ISSUE) {
-        // Make timer go off before getting to destination
-        std::this_thread::sleep_for(std::chrono::seconds(moveBetweenFloorsTime(dstn) - 3));
-        std::cout << "Timer went off!"<< std::endl;
-        std::cout << "Elevator " << elevatorId << " received an issue with the arrival sensor while moving from " << curr_floor << " to " << dstn << "." << std::endl;
-        return false;
+    timers.advance(nowMs);
+    if (watchdogDueMs < 0) {
+        return -1;
+    }
+    long long dueMs = (arrivalDueMs >= 0) ? std::min(arrivalDueMs, watchdogDueMs) : watchdogDueMs;
+    return static_cast<int>(std::max(dueMs - nowMs, 0LL));
+}
+
+/**
+ * Finishes a move started by beginMove, once the car has reported arriving or its arrival
+ * watchdog has gone off
+ * @param dstn The destination floor
+ * @return If the elevator arrived at the destination
+ */
+bool Elevator::endMove(int dstn) {
+    if (curr_floor == dstn) {
+        state = elevatorState::ELEVATOR_REST;
+        return true;
     }
-    else {
-        // Travel to floor
-        std::this_thread::sleep_for(std::chrono::seconds(moveBetweenFloorsTime(dstn))); 
+    if (watchdogFired) {
+        watchdogFired = false;
+        if(event.fault == ELEVATOR_STUCK) {
+            LOG_INFO("Elevator " << elevatorId << " got stuck while moving from " << curr_floor << " to " << dstn << ".");
+        }
+        else if(event.fault == ARRIVAL_SENSOR_ISSUE) {
+            LOG_INFO("Elevator " << elevatorId << " received an issue with the arrival sensor while moving from " << curr_floor << " to " << dstn << ".");
+        }
+        else {
+            LOG_INFO("Elevator " << elevatorId << " did not report arriving while moving from " << curr_floor << " to " << dstn << ".");
+        }
+        return false;
     }
 
     // Update position and state
     state = elevatorState::ELEVATOR_REST;
     curr_floor = dstn; 
     
+    std::string source = "Elevator: " + std::to_string(elevatorId);
     Event positionUpdate{
         event.time,
         source,
@@ -188,65 +404,96 @@ bool Elevator::moveTo(int dstn) {
  * @return The time to move between floors
  */
 int Elevator::moveBetweenFloorsTime(int dstn) {
-    int floorsToMove = std::abs(dstn - curr_floor);
-    if(floorsToMove == 1) {
-        return TIME_BTWN_1_FLOOR;
-    }
-    else if(floorsToMove == 2) {
-        return TIME_BTWN_2_FLOORS;
-    }
-    else if(floorsToMove == 3) {
-        return TIME_BTWN_3_FLOORS;
-    }
-    else {
-        return floorsToMove * TIME_BTWN_X_FLOORS_PER_FLOOR;
-    }
+    return travelSeconds(dstn - curr_floor);
 }
 
 /**
  * Simulates opening elevator doors
  */
 void Elevator::openDoors() {
-    std::cout << "Elevator " << elevatorId << " is opening doors at floor #" << curr_floor << "." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(TIME_TO_OPEN_CLOSE_DOOR)); 
-    // Check for fault for this part
-    if(event.fault != DOOR_CLOSE_STUCK) {
-        state = ELEVATOR_DOOR_OPEN; 
+    pause(beginOpenDoors());
+    endOpenDoors();
+}
+
+/**
+ * Starts opening the elevator doors
+ * @return Time in milliseconds until the doors are open, including any recovery
+ */
+int Elevator::beginOpenDoors() {
+    LOG_INFO("Elevator " << elevatorId << " is opening doors at floor #" << curr_floor << ".");
+    if(event.fault == DOOR_CLOSE_STUCK) {
+        return (TIME_TO_OPEN_CLOSE_DOOR + RECOVERY_TIME) * 1000;
     }
-    else {
-        std::cout << "Elevator " << elevatorId << " doors are stuck closed at floor #" << curr_floor << "." << std::endl;
-        std::cout << "Elevator " << elevatorId << " is recovering from doors being stuck at floor #" << curr_floor << "." << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(RECOVERY_TIME)); 
-        std::cout << "Elevator " << elevatorId << " has recovered and doors are opened at floor #" << curr_floor << "." << std::endl;
-        state = ELEVATOR_DOOR_OPEN; 
+    return TIME_TO_OPEN_CLOSE_DOOR * 1000;
+}
+
+/**
+ * Finishes opening the elevator doors
+ */
+void Elevator::endOpenDoors() {
+    // Check for fault for this part
+    if(event.fault == DOOR_CLOSE_STUCK) {
+        LOG_INFO("Elevator " << elevatorId << " doors are stuck closed at floor #" << curr_floor << ".");
+        LOG_INFO("Elevator " << elevatorId << " is recovering from doors being stuck at floor #" << curr_floor << ".");
+        LOG_INFO("Elevator " << elevatorId << " has recovered and doors are opened at floor #" << curr_floor << ".");
     }
+    state = ELEVATOR_DOOR_OPEN; 
 }
 
 /**
  * Simulates closing elevator doors
  */
 void Elevator::closeDoors() {
-    std::cout << "Elevator " << elevatorId << " is closing doors at floor #" << curr_floor << "." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(TIME_TO_OPEN_CLOSE_DOOR)); 
-    // Check for fault for this part
-    if(event.fault != DOOR_OPEN_STUCK) {
-        state = ELEVATOR_DOOR_CLOSE; 
+    pause(beginCloseDoors());
+    endCloseDoors();
+}
+
+/**
+ * Starts closing the elevator doors
+ * @return Time in milliseconds until the doors are closed, including any recovery
+ */
+int Elevator::beginCloseDoors() {
+    LOG_INFO("Elevator " << elevatorId << " is closing doors at floor #" << curr_floor << ".");
+    if(event.fault == DOOR_OPEN_STUCK) {
+        return (TIME_TO_OPEN_CLOSE_DOOR + RECOVERY_TIME) * 1000;
     }
-    else {
-        std::cout << "Elevator " << elevatorId << " doors are stuck open at floor #" << curr_floor << "." << std::endl;
-        std::cout << "Elevator " << elevatorId << " is recovering from doors being stuck at floor #" << curr_floor << "." << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(RECOVERY_TIME)); 
-        std::cout << "Elevator " << elevatorId << " has recovered and doors are closed at floor #" << curr_floor << "." << std::endl;
-        state = ELEVATOR_DOOR_CLOSE; 
+    return TIME_TO_OPEN_CLOSE_DOOR * 1000;
+}
+
+/**
+ * Finishes closing the elevator doors
+ */
+void Elevator::endCloseDoors() {
+    // Check for fault for this part
+    if(event.fault == DOOR_OPEN_STUCK) {
+        LOG_INFO("Elevator " << elevatorId << " doors are stuck open at floor #" << curr_floor << ".");
+        LOG_INFO("Elevator " << elevatorId << " is recovering from doors being stuck at floor #" << curr_floor << ".");
+        LOG_INFO("Elevator " << elevatorId << " has recovered and doors are closed at floor #" << curr_floor << ".");
     }
+    state = ELEVATOR_DOOR_CLOSE; 
 }
 
 /**
  * Load passenger
  */
 void Elevator::load() { 
-    std::cout << "Elevator " << elevatorId << " is loading at floor #" << curr_floor << "." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(TIME_TO_LOAD_UNLOAD_1_PASSENGER)); 
+    pause(beginLoad());
+    endLoad();
+}
+
+/**
+ * Starts loading a passenger
+ * @return Time in milliseconds to load the passenger
+ */
+int Elevator::beginLoad() {
+    LOG_INFO("Elevator " << elevatorId << " is loading at floor #" << curr_floor << ".");
+    return TIME_TO_LOAD_UNLOAD_1_PASSENGER * 1000;
+}
+
+/**
+ * Finishes loading a passenger
+ */
+void Elevator::endLoad() {
     passengers++;
     totalPassengers++; 
 }
@@ -255,147 +502,529 @@ void Elevator::load() {
  * Unload passenger
  */
 void Elevator::unload() { 
-    std::cout << "Elevator " << elevatorId << " is unloading at floor #" << curr_floor << "." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(TIME_TO_LOAD_UNLOAD_1_PASSENGER)); 
+    pause(beginUnload());
+    endUnload();
+}
+
+/**
+ * Starts unloading a passenger
+ * @return Time in milliseconds to unload the passenger
+ */
+int Elevator::beginUnload() {
+    LOG_INFO("Elevator " << elevatorId << " is unloading at floor #" << curr_floor << ".");
+    return TIME_TO_LOAD_UNLOAD_1_PASSENGER * 1000;
+}
+
+/**
+ * Finishes unloading a passenger
+ */
+void Elevator::endUnload() {
     passengers--;
 }
 
+/**
+ * Blocks the car's own thread for the duration of an action. The end of the action is a
+ * timer on the car's wheel, and the thread waits for the wheel's next expiry, so an
+ * arrival watchdog due first goes off on time. Not for a simulation, whose clock only
+ * moves between steps.
+ * @param durationMs The duration in milliseconds
+ */
+void Elevator::pause(int durationMs) {
+    bool done = false;
+    timers.scheduleAt(elevatorSubsystem.now() + durationMs, [&done]() { done = true; });
+    while (!done) {
+        long long waitMs = timers.nextExpiry() - elevatorSubsystem.now();
+        if (waitMs > 0) {
+            // New assignments wake the car early; it just goes back to waiting
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait_for(lock, std::chrono::milliseconds(waitMs));
+        }
+        timers.advance(elevatorSubsystem.now());
+    }
+}
+
 /**
  * Constructor for the Elevator class.
  * @param elevatorSubsystem_a Reference to the ElevatorSubsystem
  * @param id Elevator id
  */
 Elevator::Elevator(ElevatorSubsystem& elevatorSubsystem_a, int id) 
-    : elevatorSubsystem(elevatorSubsystem_a), elevatorId(id), 
-      state(elevatorState::ELEVATOR_REST), event(Event{}), curr_floor(1),
-      passengers(0), totalPassengers(0) {}
+    : elevatorSubsystem(elevatorSubsystem_a), elevatorId(id), event(Event{}),
+      state(elevatorState::ELEVATOR_REST), phase(elevatorPhase::PHASE_IDLE),
+      sweep(Direction::DIRECTION_IDLE), targetFloor(1), stopArrivalMs(0), outOfService(false), curr_floor(1),
+      passengers(0), totalPassengers(0), pool(nullptr), timers(elevatorSubsystem_a.now()), watchdog(0),
+      watchdogDueMs(-1), arrivalDueMs(-1), watchdogFired(false) {}
 
 /**
- * Sets the current event for the elevator
+ * Sets the event whose fault applies to the next action, used by the single-action wrappers
  * @param event The event to be processed by the elevator
  */
 void Elevator::setEvent(Event event) {
     this->event = event;
 }
 
+/**
+ * Queues an assignment for the elevator thread or coroutine and wakes it
+ * @param event The event to be processed by the elevator
+ */
+void Elevator::post(const Event& event) {
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        inbox.push_back(event);
+        std::swap(waiter, inboxWaiter);
+        cv.notify_all();
+    }
+    if (waiter) {
+        pool->resume(waiter);
+    }
+}
+
+/**
+ * Suspends the coroutine unless an assignment is already waiting
+ * @param handle The elevator's coroutine
+ * @return False to carry on without suspending
+ */
+bool Elevator::Assignments::await_suspend(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(elevator.mtx);
+    if (!elevator.inbox.empty()) {
+        return false;
+    }
+    elevator.inboxWaiter = handle;
+    return true;
+}
+
+/**
+ * Adds an assigned request to the itinerary
+ * @param event The floor request
+ */
+void Elevator::assign(const Event& event) {
+    if (!event.isFromFloor) {
+        return;
+    }
+    LOG_INFO("Elevator " << elevatorId << " processing event: Time=" << event.time 
+              << ", Source=" << event.source 
+              << ", Floor Button=" << event.floorButton 
+              << ", Elevator Button=" << event.elevatorButton);
+    waiting.push_back(event);
+    TripTimes times;
+    times.callMs = event.callMs >= 0 ? event.callMs : elevatorSubsystem.now();
+    waitingTimes.push_back(times);
+}
+
+/**
+ * Moves everything posted by the subsystem into the itinerary
+ */
+void Elevator::takeInbox() {
+    std::deque<Event> posted;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        posted.swap(inbox);
+    }
+    for (const Event& request : posted) {
+        assign(request);
+    }
+}
+
+/**
+ * Builds the stop list from the waiting and riding requests
+ * @return The elevator's itinerary
+ */
+Itinerary Elevator::itinerary() const {
+    Itinerary stops;
+    for (const Event& request : waiting) {
+        int origin = std::stoi(request.source);
+        stops.pickups.push_back({origin, request.elevatorButton,
+                                 Itinerary::travelDirection(origin, request.elevatorButton, request.direction())});
+    }
+    for (const Event& request : riding) {
+        stops.dropoffs.push_back(request.elevatorButton);
+    }
+    return stops;
+}
+
+/**
+ * Gets the stops in the order the elevator will serve them
+ * @return Floors in visiting order
+ */
+std::vector<int> Elevator::getItinerary() const {
+    return itinerary().plan(curr_floor, sweep);
+}
+
+/**
+ * Picks the request a stop is made for. A request carrying a fault wins so the fault
+ * is injected on the leg it was reported for.
+ * @param floor The stop
+ * @return The request, or an empty event if none boards or leaves there
+ */
+Event Elevator::stopEvent(int floor) const {
+    Event chosen{};
+    for (const Event& request : riding) {
+        if (request.elevatorButton == floor && (chosen.source.empty() || request.fault != 0)) {
+            chosen = request;
+        }
+    }
+    for (const Event& request : waiting) {
+        if (std::stoi(request.source) == floor && (chosen.source.empty() || request.fault != 0)) {
+            chosen = request;
+        }
+    }
+    return chosen;
+}
+
+/**
+ * Builds the completion message for a request
+ * @param request The request that has finished
+ * @return The completion response for the scheduler
+ */
+Event Elevator::tripResponse(const Event& request) const {
+    std::string source = "Elevator" + std::to_string(elevatorId);
+    return Event{
+        request.time,
+        source,
+        request.floorButton,
+        request.elevatorButton,
+        false,           // Not from floor
+        elevatorId,      // This elevator
+        curr_floor,      // Current floor
+        passengers,      // Current passengers
+        true,             // This is a completion message!
+        request.fault       // Fault for system
+    };
+}
+
+/**
+ * Takes the elevator out of service after a fault. Passengers still waiting for it are
+ * handed back to the scheduler as hall calls, which go to cars in service straight away;
+ * passengers on board stay with it and are delivered once it recovers.
+ * @return Time in milliseconds until the elevator is released
+ */
+int Elevator::reportFault() {
+    LOG_INFO("Elevator " << elevatorId << " fault occured while going from floor "
+              << curr_floor << " to floor " << targetFloor);
+    LOG_INFO("Elevator " << elevatorId << " is out of service for " << CAR_RECOVERY_TIME << " seconds.");
+    phase = elevatorPhase::PHASE_RECOVERING;
+    state = elevatorState::ELEVATOR_REST;
+    outOfService = true;
+
+    // A fault is injected once: the requests for the stop it struck on lose it
+    for (Event& request : riding) {
+        if (request.elevatorButton == targetFloor) request.fault = 0;
+    }
+
+    // Removed first so the scheduler does not give the calls back to this car
+    elevatorSubsystem.removeElevator();
+    std::vector<Event> handedBack;
+    handedBack.swap(waiting);
+    waitingTimes.clear();
+    for (Event& request : handedBack) {
+        if (std::stoi(request.source) == targetFloor) request.fault = 0;
+    }
+    handBack(handedBack);
+    return CAR_RECOVERY_TIME * 1000;
+}
+
+/**
+ * Gives requests the elevator will not serve back to the scheduler as hall calls. They
+ * must already be out of the itinerary, since in a simulation they may be assigned again
+ * before this returns.
+ * @param requests The requests, cleared once sent
+ */
+void Elevator::handBack(std::vector<Event>& requests) {
+    for (Event& request : requests) {
+        elevatorSubsystem.releaseCall(request);
+        request.assignedElevator = -1;
+        elevatorSubsystem.scheduler.getMetrics().recordReassigned();
+        elevatorSubsystem.addElevatorResponse(request);
+    }
+    requests.clear();
+}
+
+/**
+ * Releases the elevator after its recovery period. It sets off again from the floor it
+ * last left, and anything assigned to it while it was out of service is kept.
+ */
+void Elevator::endRecovery() {
+    LOG_INFO("Elevator " << elevatorId << " has recovered and is back in service at floor #" << curr_floor << ".");
+    outOfService = false;
+    elevatorSubsystem.restoreElevator();
+}
+
+/**
+ * Starts travelling to the next stop on the itinerary
+ * @return Milliseconds until the next call is due, or -1 when there are no stops left
+ */
+int Elevator::startNextLeg() {
+    if (!itinerary().nextStop(curr_floor, sweep, targetFloor)) {
+        sweep = Direction::DIRECTION_IDLE;
+        event = Event{};
+        phase = elevatorPhase::PHASE_IDLE;
+        return -1;
+    }
+    event = stopEvent(targetFloor);
+
+    // Doors left open by the single-action wrappers are closed first
+    if (state == elevatorState::ELEVATOR_DOOR_OPEN) {
+        phase = elevatorPhase::PHASE_CLOSING;
+        return beginCloseDoors();
+    }
+    if (targetFloor == curr_floor) {
+        stopArrivalMs = elevatorSubsystem.now();
+        phase = elevatorPhase::PHASE_OPENING;
+        return beginOpenDoors();
+    }
+    phase = elevatorPhase::PHASE_MOVING;
+    return beginMove(targetFloor);
+}
+
+/**
+ * Starts letting passengers off and on at the current floor. Only passengers going the
+ * way the elevator leaves in board, up to ELEVATOR_CAPACITY; the rest wait for it to
+ * come back, or for another car if this one fills up.
+ * @return Time in milliseconds to move every passenger
+ */
+int Elevator::beginTransfer() {
+    Itinerary stops = itinerary();
+    stops.serve(curr_floor, sweep);
+
+    int moving = 0;
+    int aboard = static_cast<int>(riding.size());
+    for (const Event& request : riding) {
+        if (request.elevatorButton == curr_floor) {
+            moving++;
+            aboard--;
+            LOG_INFO("Elevator " << elevatorId << " is unloading at floor #" << curr_floor << ".");
+        }
+    }
+    for (const Event& request : waiting) {
+        int origin = std::stoi(request.source);
+        if (origin == curr_floor && Itinerary::travelDirection(origin, request.elevatorButton, request.direction()) == sweep
+            && aboard < ELEVATOR_CAPACITY) {
+            moving++;
+            aboard++;
+            LOG_INFO("Elevator " << elevatorId << " is loading at floor #" << curr_floor << ".");
+        }
+    }
+    return moving * TIME_TO_LOAD_UNLOAD_1_PASSENGER * 1000;
+}
+
+/**
+ * Finishes the transfer: arriving passengers complete their requests, boarding ones start riding.
+ * Passengers left on the floor because the car is full are handed back to be given another car.
+ */
+void Elevator::endTransfer() {
+    for (size_t i = 0; i < riding.size();) {
+        if (riding[i].elevatorButton == curr_floor) {
+            endUnload();
+            LOG_INFO("Elevator " << elevatorId << " completed request from floor "
+                      << riding[i].source << " to floor " << riding[i].elevatorButton);
+            // Recorded before the completion goes out, so it is counted by the time anyone sees it
+            ridingTimes[i].destinationMs = stopArrivalMs;
+            elevatorSubsystem.scheduler.getMetrics().recordTrip(elevatorId, std::stoi(riding[i].source), ridingTimes[i]);
+            elevatorSubsystem.addElevatorResponse(tripResponse(riding[i]));
+            riding.erase(riding.begin() + i);
+            ridingTimes.erase(ridingTimes.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    std::vector<Event> leftBehind;
+    for (size_t i = 0; i < waiting.size();) {
+        int origin = std::stoi(waiting[i].source);
+        if (origin == curr_floor && Itinerary::travelDirection(origin, waiting[i].elevatorButton, waiting[i].direction()) == sweep) {
+            if (riding.size() >= ELEVATOR_CAPACITY) {
+                LOG_INFO("Elevator " << elevatorId << " is full, leaving a passenger at floor #" << curr_floor << ".");
+                leftBehind.push_back(waiting[i]);
+            } else {
+                endLoad();
+                waitingTimes[i].arrivalMs = stopArrivalMs;
+                waitingTimes[i].boardMs = elevatorSubsystem.now();
+                riding.push_back(waiting[i]);
+                ridingTimes.push_back(waitingTimes[i]);
+            }
+            waiting.erase(waiting.begin() + i);
+            waitingTimes.erase(waitingTimes.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    handBack(leftBehind);
+}
+
+/**
+ * Finishes the current phase of the stop cycle and starts the next one
+ * @return Milliseconds until the next call is due, or -1 when there are no stops left
+ */
+int Elevator::advance() {
+    switch (phase) {
+        case elevatorPhase::PHASE_IDLE:
+            return startNextLeg();
+
+        case elevatorPhase::PHASE_MOVING: {
+            int waitMs = awaitArrival();
+            if (waitMs >= 0) {
+                // Not reported yet, so the car waits on for its watchdog
+                return waitMs;
+            }
+            if (!endMove(targetFloor)) {
+                return reportFault();
+            }
+            stopArrivalMs = elevatorSubsystem.now();
+            phase = elevatorPhase::PHASE_OPENING;
+            return beginOpenDoors();
+        }
+
+        case elevatorPhase::PHASE_OPENING:
+            endOpenDoors();
+            phase = elevatorPhase::PHASE_TRANSFER;
+            return beginTransfer();
+
+        case elevatorPhase::PHASE_TRANSFER:
+            endTransfer();
+            phase = elevatorPhase::PHASE_CLOSING;
+            return beginCloseDoors();
+
+        case elevatorPhase::PHASE_CLOSING:
+            endCloseDoors();
+            return startNextLeg();
+
+        case elevatorPhase::PHASE_RECOVERING:
+            endRecovery();
+            return startNextLeg();
+    }
+    return -1;
+}
+
 /**
  * Main loop for the elevator to process assigned events
- * Waits for an event, processes it by moving and opening/closing doors, then sends a response
+ * Waits for assignments, then serves its itinerary in real time. Requests assigned
+ * mid-trip join the itinerary between phases.
  */
 void Elevator::run() {
     while (!elevatorSubsystem.isFinish()) {
-        // Wait until there is an event  
-        std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [this] { return !event.source.empty(); });
-
-        if (event.isFromFloor) {
-            // Process the event
-            std::cout << "Elevator " << elevatorId << " processing event: Time=" << event.time 
-                      << ", Source=" << event.source 
-                      << ", Floor Button=" << event.floorButton 
-                      << ", Elevator Button=" << event.elevatorButton << std::endl;
-            
-            // Parse floor number from source
-            int sourceFloor = std::stoi(event.source);
-            
-
-            // First, make sure doors are closed
-            if (state == elevatorState::ELEVATOR_DOOR_OPEN) {
-                closeDoors();
-            }
-            
-            // Go to the source floor
-            bool success = moveTo(sourceFloor);  
-            if(success == false) {
-                std::string source = "Elevator" + std::to_string(elevatorId);
-                Event faultResponse{
-                    event.time,
-                    source,
-                    event.floorButton,
-                    event.elevatorButton,
-                    false,           // Not from floor
-                    elevatorId,      // This elevator
-                    curr_floor,      // Current floor
-                    passengers,      // Current passengers
-                    true,             // This is a completion message!
-                    event.fault       // Fault for system
-                };
-                faultResponse.isComplete = true;
-                std::cout << "Elevator " << elevatorId << " fault occured while going from floor "
-                          << sourceFloor << " to floor " << event.elevatorButton << std::endl;
-                std::cout << "Force termination of elevator " << elevatorId << " and it's event." << std::endl;
-                elevatorSubsystem.removeElevator();
-                elevatorSubsystem.addElevatorResponse(faultResponse);
-                break;
-            }
+        // Wait until there is an assignment
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return !inbox.empty(); });
+        }
+        takeInbox();
 
-            // Open doors
-            openDoors(); 
-
-            // Load elevator
-            load();
-
-            // Close doors
-            closeDoors();
-            
-            // Go to the destination floor
-            success = moveTo(event.elevatorButton);
-            if(success == false) {
-                std::string source = "Elevator" + std::to_string(elevatorId);
-                Event faultResponse{
-                    event.time,
-                    source,
-                    event.floorButton,
-                    event.elevatorButton,
-                    false,           // Not from floor
-                    elevatorId,      // This elevator
-                    curr_floor,      // Current floor
-                    passengers,      // Current passengers
-                    true,             // This is a completion message!
-                    event.fault       // Fault for system
-                };
-                faultResponse.isComplete = true;
-                std::cout << "Elevator " << elevatorId << " fault occured while going from floor "
-                          << sourceFloor << " to floor " << event.elevatorButton << std::endl;
-                std::cout << "Force termination of elevator " << elevatorId << " and it's event." << std::endl;
-                elevatorSubsystem.removeElevator();
-                elevatorSubsystem.addElevatorResponse(faultResponse);
-                break;
-            }
+        // Sleep through each phase of the stop cycle
+        int delay;
+        while ((delay = advance()) >= 0) {
+            pause(delay);
+            takeInbox();
+        }
+    }
+    LOG_INFO("Exiting elevator " << elevatorId);
+}
 
-            // Open Doors
-            openDoors(); 
-
-            // Unload elevator 
-            unload();
-
-            // Close doors
-            closeDoors(); 
-
-            // IMPORTANT: Send final completion response
-            std::string source = "Elevator" + std::to_string(elevatorId);
-            Event completionResponse{
-                event.time,
-                source,
-                event.floorButton,
-                event.elevatorButton,
-                false,           // Not from floor
-                elevatorId,      // This elevator
-                curr_floor,      // Current floor
-                passengers,      // Current passengers
-                true,             // This is a completion message!
-                event.fault       // Fault for system
-            };
-            completionResponse.isComplete = true;
-            
-            // Send explicit completion notification
-            std::cout << "Elevator " << elevatorId << " completed request from floor "
-                      << sourceFloor << " to floor " << event.elevatorButton << std::endl;
-            elevatorSubsystem.addElevatorResponse(completionResponse);
-
-            // Reset event after processing
-            this->event = Event{};
+/**
+ * Main loop for an elevator on a worker pool. Waiting for an assignment and each phase
+ * of the stop cycle suspend the coroutine, so no thread is held while the car is idle
+ * or travelling.
+ * @param workers The pool that resumes the coroutine
+ * @return The coroutine
+ */
+Task Elevator::drive(WorkerPool& workers) {
+    pool = &workers;
+    while (!elevatorSubsystem.isFinish()) {
+        // Wait until there is an assignment
+        co_await Assignments(*this);
+        takeInbox();
+
+        // Sleep through each phase of the stop cycle
+        int delay;
+        while ((delay = advance()) >= 0) {
+            co_await workers.sleep(delay);
+            takeInbox();
         }
     }
-    std::cout << "Exiting elevator " << elevatorId << std::endl;
-}
\ No newline at end of file
+    LOG_INFO("Exiting elevator " << elevatorId);
+}
+
+namespace {
+
+void putRequests(CheckpointWriter& out, const std::vector<Event>& requests, const std::vector<TripTimes>& times) {
+    out.putInt(static_cast<int64_t>(requests.size()));
+    for (size_t i = 0; i < requests.size(); i++) {
+        out.putEvent(requests[i]);
+        out.putInt(times[i].callMs);
+        out.putInt(times[i].arrivalMs);
+        out.putInt(times[i].boardMs);
+        out.putInt(times[i].destinationMs);
+    }
+}
+
+void getRequests(CheckpointReader& in, std::vector<Event>& requests, std::vector<TripTimes>& times) {
+    requests.resize(in.getCount());
+    times.resize(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        requests[i] = in.getEvent();
+        times[i].callMs = in.getInt();
+        times[i].arrivalMs = in.getInt();
+        times[i].boardMs = in.getInt();
+        times[i].destinationMs = in.getInt();
+    }
+}
+
+} // namespace
+
+/**
+ * Writes the car's position, phase, requests and their trip times to a checkpoint
+ * @param out The checkpoint
+ */
+void Elevator::save(CheckpointWriter& out) {
+    out.putEvent(event);
+    out.putInt(state);
+    out.putInt(phase);
+    out.putInt(sweep);
+    out.putInt(targetFloor);
+    putRequests(out, waiting, waitingTimes);
+    putRequests(out, riding, ridingTimes);
+    out.putInt(stopArrivalMs);
+    out.putInt(outOfService);
+    out.putInt(watchdogDueMs);
+    out.putInt(arrivalDueMs);
+    out.putInt(watchdogFired);
+    out.putInt(curr_floor);
+    out.putInt(passengers);
+    out.putInt(totalPassengers);
+    std::lock_guard<std::mutex> lock(mtx);
+    out.putInt(static_cast<int64_t>(inbox.size()));
+    for (const Event& posted : inbox) {
+        out.putEvent(posted);
+    }
+}
+
+/**
+ * Replaces the car's state with one saved by save
+ * @param in The checkpoint
+ */
+void Elevator::restore(CheckpointReader& in) {
+    event = in.getEvent();
+    state = static_cast<elevatorState>(in.getInt());
+    phase = static_cast<elevatorPhase>(in.getInt());
+    sweep = static_cast<Direction>(in.getInt());
+    targetFloor = static_cast<int>(in.getInt());
+    getRequests(in, waiting, waitingTimes);
+    getRequests(in, riding, ridingTimes);
+    stopArrivalMs = in.getInt();
+    outOfService = in.getInt() != 0;
+    timers.cancel(watchdog);
+    watchdog = 0;
+    long long dueMs = in.getInt();
+    if (dueMs >= 0) {
+        armWatchdog(dueMs);
+    }
+    arrivalDueMs = in.getInt();
+    watchdogFired = in.getInt() != 0;
+    curr_floor = static_cast<int>(in.getInt());
+    passengers = static_cast<int>(in.getInt());
+    totalPassengers = static_cast<int>(in.getInt());
+    std::lock_guard<std::mutex> lock(mtx);
+    inbox.resize(in.getCount());
+    for (Event& posted : inbox) {
+        posted = in.getEvent();
+    }
+}
@@ -5,15 +5,13 @@
 #include <mutex>
 #include <thread>
 #include <memory>
+#include <deque>
 #include "Scheduler.h"
 #include "ElevatorEnums.h"
-
-#define TIME_BTWN_1_FLOOR 9
-#define TIME_BTWN_2_FLOORS 11
-#define TIME_BTWN_3_FLOORS 13
-#define TIME_BTWN_X_FLOORS_PER_FLOOR 4 // This is when floors is more than 3
-#define TIME_TO_LOAD_UNLOAD_1_PASSENGER 4 // A passenger loading/unloading
-#define TIME_TO_OPEN_CLOSE_DOOR 2 // Time to open and close door
+#include "Itinerary.h"
+#include "WorkerPool.h"
+#include "TimingWheel.h"
+#include "TravelTime.h"
 
 // Faults for system
 #define ELEVATOR_STUCK 1
@@ -23,8 +21,14 @@
 
 // Recovery time for stuck faults
 #define RECOVERY_TIME 5
+// Seconds a car that stopped between floors is out of service before it is released
+#define CAR_RECOVERY_TIME 30
+// Grace past a leg's travel time before a car that has not reported arriving is taken as faulted
+#define ARRIVAL_WATCHDOG_MS 2000
 
 class Elevator;
+class ElevatorBank;
+class Simulation;
 
 /**
  * Elevator subsystem class represents a single elevator subsystem
@@ -39,11 +43,20 @@ private:
     std::thread elevatorThread;         // Thread to run the elevator
     int elevatorId;                     // ID of the elevator
 
-    DatagramSocket receiveSocket;       // Socket to receive events from scheduler
-    DatagramSocket sendSocket;          // Socket to send responses to scheduler
+    std::unique_ptr<Endpoint> endpoint; // Receives assignments and sends responses, null in a simulation
+    std::vector<Event> inbound;         // Assignments drained from the endpoint on each wakeup
+    size_t inboundNext;                 // Next event in inbound for receiveEvent
+
+    Simulation* simulation;             // Simulation driving this subsystem, null when running in real time
+    bool advancing;                     // Whether an elevator step is scheduled (simulation only)
+    ElevatorBank* bank;                 // Bank whose worker pool runs the elevator, null when it has a thread
+    Task driver;                        // The elevator's coroutine when it runs on a bank's worker pool
 
     bool receiveEvent(Event& event);
+    void handleEvents();
     void sendResponse(const Event& response);
+    void scheduleAdvance(int delay);
+    long long now() const;
 
 public:
     /**
@@ -51,10 +64,45 @@ public:
      * 
      * @param s The scheduler instance
      * @param id The ID for this elevator
-     * @param port The UDP port to listen on
+     * @param port The port to listen on, opened on the scheduler's transport
      */
     ElevatorSubsystem(Scheduler& s, int id, int port);
 
+    /**
+     * Constructor for an elevator subsystem driven by a discrete-event simulation.
+     * No endpoint is opened and no threads are started; the simulation steps the elevator.
+     * 
+     * @param s The scheduler instance
+     * @param id The ID for this elevator
+     * @param sim The simulation that owns the virtual clock
+     */
+    ElevatorSubsystem(Scheduler& s, int id, Simulation& sim);
+
+    /**
+     * Constructor for an elevator subsystem run as a coroutine on a bank's worker pool.
+     * No endpoint is opened and no threads are started; the bank receives and sends for it.
+     * 
+     * @param s The scheduler instance
+     * @param id The ID for this elevator
+     * @param owner The bank the elevator belongs to
+     */
+    ElevatorSubsystem(Scheduler& s, int id, ElevatorBank& owner);
+
+    /**
+     * Hands an assignment received for this elevator to the elevator
+     * 
+     * @param event The event; events for other elevators are ignored
+     */
+    void accept(const Event& event);
+
+    /**
+     * Hands an assigned event to the elevator inside a simulation.
+     * The event joins the elevator's itinerary even if it is mid-trip.
+     * 
+     * @param event The event assigned to this elevator
+     */
+    void dispatch(const Event& event);
+
     /**
      * Adds the elevator response event to the scheduler
      * 
@@ -73,6 +121,12 @@ public:
      */
     void run();
 
+    /**
+     * Registers the elevator endpoint with an event loop so assignments reach the elevator as soon as they arrive
+     * @param reactor The event loop to run on
+     */
+    void registerWith(Reactor& reactor);
+
     /**
      * Gets the elevator ID
      * @return The elevator ID
@@ -95,6 +149,35 @@ public:
      */
     void removeElevator();
 
+    /**
+     * Returns the elevator to service after it has recovered from a fault
+     */
+    void restoreElevator();
+
+    /**
+     * Takes a request the elevator could not board off its stops at the scheduler
+     * @param event The floor request
+     */
+    void releaseCall(const Event& event);
+
+    /**
+     * Runs the elevator's next step of the stop cycle inside a simulation, and schedules
+     * the one after it. Called by the simulation when the step is due.
+     */
+    void step();
+
+    /**
+     * Writes the elevator and whether it has a step scheduled to a checkpoint
+     * @param out The checkpoint
+     */
+    void saveState(CheckpointWriter& out);
+
+    /**
+     * Replaces the elevator's state with one saved by saveState
+     * @param in The checkpoint
+     */
+    void restoreState(CheckpointReader& in);
+
     friend class Elevator;
 };
 
@@ -106,13 +189,72 @@ class Elevator {
 private:
     ElevatorSubsystem& elevatorSubsystem;
     int elevatorId;
-    Event event;
+    Event event;            // Request the current leg is for; its fault applies to the leg
     elevatorState state;
+    elevatorPhase phase;    // Step of the stop cycle
+    Direction sweep;        // Direction of the current sweep
+    int targetFloor;        // Stop being travelled to or served
+    std::vector<Event> waiting; // Assigned requests whose passenger has not boarded
+    std::vector<Event> riding;  // Requests whose passenger is on board
+    std::vector<TripTimes> waitingTimes; // Trip times of each waiting request, in the same order
+    std::vector<TripTimes> ridingTimes;  // Trip times of each riding request, in the same order
+    long long stopArrivalMs;    // When the elevator reached the stop it is serving
+    bool outOfService;      // Set while the elevator recovers from a fault
     int curr_floor;
     int passengers;         // Current number of passengers
     int totalPassengers;    // Total passengers served
+    std::deque<Event> inbox; // Assignments handed over by the subsystem, guarded by mtx
     std::mutex mtx;
     std::condition_variable cv;
+    WorkerPool* pool;       // Pool the elevator's coroutine runs on, null when it has a thread
+    std::coroutine_handle<> inboxWaiter; // The coroutine while it waits for an assignment, guarded by mtx
+    TimingWheel timers;     // The car's own timers on its subsystem's clock, used by the thread driving it
+    TimingWheel::TimerId watchdog;  // Arrival watchdog of the current move, 0 when not armed
+    long long watchdogDueMs;        // When the watchdog goes off, -1 when not armed
+    long long arrivalDueMs;         // When the arrival sensor reports on the current move, -1 if it never will
+    bool watchdogFired;             // Set when the watchdog went off before the car reported arriving
+
+    /**
+     * Awaitable that suspends the elevator's coroutine until the inbox has an assignment
+     */
+    class Assignments {
+    public:
+        explicit Assignments(Elevator& elevator) : elevator(elevator) {}
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+
+    private:
+        Elevator& elevator;
+    };
+
+    // Each action is split into a begin half that returns its duration in
+    // milliseconds and an end half that applies its effect, so the same
+    // state machine can be driven by real sleeps or by a virtual clock.
+    int beginMove(int dstn);
+    int awaitArrival();
+    bool endMove(int dstn);
+    int beginOpenDoors();
+    void endOpenDoors();
+    int beginCloseDoors();
+    void endCloseDoors();
+    int beginLoad();
+    void endLoad();
+    int beginUnload();
+    void endUnload();
+    int beginTransfer();
+    void endTransfer();
+
+    int startNextLeg();
+    Itinerary itinerary() const;
+    Event stopEvent(int floor) const;
+    Event tripResponse(const Event& request) const;
+    int reportFault();
+    void endRecovery();
+    void handBack(std::vector<Event>& requests);
+    void takeInbox();
+    void armWatchdog(long long dueMs);
+    void pause(int durationMs);
 
 public:
     /**
@@ -130,6 +272,27 @@ public:
      */
     void setEvent(Event event);
 
+    /**
+     * Hands an assignment to the elevator thread without waiting for the current trip
+     * 
+     * @param event The event to queue
+     */
+    void post(const Event& event);
+
+    /**
+     * Adds an assigned request to the itinerary. Call from the thread driving the elevator.
+     * 
+     * @param event The floor request
+     */
+    void assign(const Event& event);
+
+    /**
+     * Gets the stops in the order the elevator will serve them
+     * 
+     * @return Floors in visiting order
+     */
+    std::vector<int> getItinerary() const;
+
     /**
      * Gets the current floor of the elevator
      * 
@@ -158,6 +321,20 @@ public:
      */
     int getTotalPassengers() const { return totalPassengers; }
 
+    /**
+     * Checks if the elevator is out of service recovering from a fault
+     * 
+     * @return True if the elevator is out of service
+     */
+    bool isOutOfService() const { return outOfService; }
+
+    /**
+     * Finishes the current phase of the stop cycle and starts the next one
+     * 
+     * @return Milliseconds until the next call is due, or -1 when there are no stops left
+     */
+    int advance();
+
         /**
      * Moves to the destination floor level
      * @param dstn The destination floor level
@@ -197,6 +374,28 @@ public:
      */
     void run();
 
+    /**
+     * The same loop as run, as a coroutine that suspends instead of blocking a thread
+     * 
+     * @param workers The pool that resumes the coroutine
+     * @return The coroutine
+     */
+    Task drive(WorkerPool& workers);
+
+    /**
+     * Writes the car's position, phase, requests and their trip times to a checkpoint
+     * 
+     * @param out The checkpoint
+     */
+    void save(CheckpointWriter& out);
+
+    /**
+     * Replaces the car's state with one saved by save. Call from the thread driving the elevator.
+     * 
+     * @param in The checkpoint
+     */
+    void restore(CheckpointReader& in);
+
     friend class ElevatorSubsystem;
 };
 
@@ -0,0 +1,134 @@
+#include "EtaModel.h"
+#include <algorithm>
+#include <limits>
+
+/**
+ * Constructor for the EtaModel class. Every car starts resting at floor 1.
+ * @param cars The number of cars
+ */
+EtaModel::EtaModel(int cars) : routes(cars), moving(cars, 0), reportMs(cars, 0) {
+    for (std::vector<RoutePoint>& route : routes) {
+        route.push_back({1, Direction::DIRECTION_IDLE, 0, 0});
+    }
+}
+
+/**
+ * Rebuilds one car's route from its committed stops
+ * @param car The car
+ * @param stops The car's committed stops
+ * @param floor The floor the car is at, or last left
+ * @param sweep The direction the car is sweeping in
+ * @param isMoving Whether the car is between floors
+ */
+void EtaModel::update(int car, const Itinerary& stops, int floor, Direction sweep, bool isMoving) {
+    std::vector<RoutePoint>& route = routes[car];
+    route.clear();
+    route.push_back({floor, sweep, 0, 0});
+    moving[car] = isMoving ? 1 : 0;
+
+    // Serve the stops the way the car will, timing each leg and stop
+    Itinerary remaining = stops;
+    int32_t time = 0;
+    int stop;
+    while (remaining.nextStop(floor, sweep, stop)) {
+        time += travelTimes.at(floor, stop);
+        size_t transfers = std::count(remaining.dropoffs.begin(), remaining.dropoffs.end(), stop);
+        size_t waiting = remaining.pickups.size();
+        remaining.serve(stop, sweep);
+        transfers += waiting - remaining.pickups.size();
+
+        int32_t depart = time + ETA_DOOR_CYCLE_MS + static_cast<int32_t>(transfers) * ETA_TRANSFER_MS;
+        route.push_back({stop, sweep, time, depart});
+        time = depart;
+        floor = stop;
+    }
+}
+
+/**
+ * Estimates when a car can reach a hall call: the first stop on its route where it sets
+ * off the caller's way from the caller's floor, or a leg that passes the floor going that
+ * way, or else after the last stop. The time the car has spent on its route since it
+ * last reported is taken off, down to the end of its last stop, after which it waits idle.
+ * @param car The car
+ * @param call The hall call
+ * @param nowMs The current time on the scheduler's clock
+ * @param later Set to the number of stops the car makes after picking the caller up
+ * @param newStop Set to true if the car does not stop at the caller's floor already
+ * @return Milliseconds from now until it stops for the caller
+ */
+int32_t EtaModel::locate(int car, const Itinerary::Pickup& call, int64_t nowMs, size_t& later, bool& newStop) const {
+    const std::vector<RoutePoint>& route = routes[car];
+    int origin = call.origin;
+    Direction direction = call.direction;
+    int32_t elapsed = static_cast<int32_t>(std::clamp<int64_t>(nowMs - reportMs[car], 0,
+                                                               std::numeric_limits<int32_t>::max()));
+    auto remaining = [elapsed](int32_t at) { return std::max(at - elapsed, 0); };
+
+    // A car standing at the caller's floor takes them unless it is about to leave the other way
+    if (!moving[car] && route[0].floor == origin) {
+        if (route.size() == 1 || route[1].floor == origin
+            || (route[1].floor > origin) == (direction == Direction::DIRECTION_UP)) {
+            later = route.size() - 1;
+            newStop = route.size() == 1 || route[1].floor != origin;
+            return 0;
+        }
+    }
+
+    for (size_t i = 1; i < route.size(); i++) {
+        const RoutePoint& from = route[i - 1];
+        const RoutePoint& to = route[i];
+        if (to.floor == origin && (to.leaving == direction || i + 1 == route.size())) {
+            // Stopping there anyway, and either leaving the caller's way or free afterwards
+            later = route.size() - 1 - i;
+            newStop = false;
+            return remaining(to.arriveMs);
+        }
+        // The leg the car is on when it reports cannot be broken to stop on the way
+        if (i == 1 && moving[car]) {
+            continue;
+        }
+        bool passes = (direction == Direction::DIRECTION_UP)
+            ? (from.floor < origin && origin < to.floor)
+            : (from.floor > origin && origin > to.floor);
+        // Only while the car has yet to go by
+        if (passes && from.departMs + travelTimes.at(from.floor, origin) >= elapsed) {
+            later = route.size() - i;
+            newStop = true;
+            return from.departMs + travelTimes.at(from.floor, origin) - elapsed;
+        }
+    }
+
+    const RoutePoint& last = route.back();
+    later = 0;
+    newStop = true;
+    return remaining(last.departMs) + travelTimes.at(last.floor, origin);
+}
+
+/**
+ * Estimates when a car can reach a hall call
+ * @param car The car
+ * @param call The hall call
+ * @param nowMs The current time on the scheduler's clock
+ * @return Milliseconds from now until it stops for the caller
+ */
+int32_t EtaModel::eta(int car, const Itinerary::Pickup& call, int64_t nowMs) const {
+    size_t later;
+    bool newStop;
+    return locate(car, call, nowMs, later, newStop);
+}
+
+/**
+ * Costs giving a hall call to a car: the caller's wait plus the time the extra stop
+ * adds to every stop the car makes after it
+ * @param car The car
+ * @param call The hall call
+ * @param nowMs The current time on the scheduler's clock
+ * @return Milliseconds of waiting and delay
+ */
+int64_t EtaModel::cost(int car, const Itinerary::Pickup& call, int64_t nowMs) const {
+    size_t later;
+    bool newStop;
+    int64_t wait = locate(car, call, nowMs, later, newStop);
+    int64_t delay = (newStop ? ETA_DOOR_CYCLE_MS : 0) + ETA_TRANSFER_MS;
+    return wait + delay * static_cast<int64_t>(later);
+}
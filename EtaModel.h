@@ -0,0 +1,108 @@
+#ifndef ETA_MODEL_H
+#define ETA_MODEL_H
+
+#include <cstdint>
+#include <vector>
+#include "Itinerary.h"
+#include "TravelTime.h"
+
+// Time a car spends at a stop besides moving passengers: doors opening and closing
+#define ETA_DOOR_CYCLE_MS (2 * TIME_TO_OPEN_CLOSE_DOOR * 1000)
+#define ETA_TRANSFER_MS (TIME_TO_LOAD_UNLOAD_1_PASSENGER * 1000)
+
+/**
+ * Estimated time for each car to reach a hall call. Every car keeps its route: the stops
+ * it has committed to in LOOK order, each with the time the car arrives and leaves after
+ * its door cycle and passenger transfers. A route is rebuilt only when its car reports a
+ * move or is given a call, so costing a new call is a scan of the routes without
+ * replaying any itinerary. Routes are timed from the car's last report, so a call is
+ * costed at the time the car has already spent on its route since then.
+ */
+class EtaModel {
+public:
+    // One stop on a car's route, times in milliseconds from the car's last report
+    struct RoutePoint {
+        int floor;
+        Direction leaving;  // Way the car sets off from the stop
+        int32_t arriveMs;
+        int32_t departMs;
+    };
+
+    /**
+     * Constructor for the EtaModel class
+     * @param cars The number of cars
+     */
+    explicit EtaModel(int cars);
+
+    /**
+     * Rebuilds one car's route from its committed stops
+     * @param car The car
+     * @param stops The car's committed stops
+     * @param floor The floor the car is at, or last left
+     * @param sweep The direction the car is sweeping in
+     * @param moving Whether the car is between floors
+     */
+    void update(int car, const Itinerary& stops, int floor, Direction sweep, bool moving);
+
+    /**
+     * Forgets a car's route, as for a car taken out of service
+     * @param car The car
+     */
+    void clear(int car) { routes[car].clear(); }
+
+    /**
+     * Notes when a car reported its position, the time its route is measured from
+     * @param car The car
+     * @param nowMs The time of the report on the scheduler's clock
+     */
+    void setReportTime(int car, int64_t nowMs) { reportMs[car] = nowMs; }
+
+    /**
+     * Get when a car last reported its position
+     * @param car The car
+     * @return The time on the scheduler's clock
+     */
+    int64_t getReportTime(int car) const { return reportMs[car]; }
+
+    /**
+     * Estimates when a car can reach a hall call
+     * @param car The car
+     * @param call The hall call
+     * @param nowMs The current time on the scheduler's clock
+     * @return Milliseconds from now until it stops for the caller
+     */
+    int32_t eta(int car, const Itinerary::Pickup& call, int64_t nowMs) const;
+
+    /**
+     * Costs giving a hall call to a car: the caller's wait plus the time the extra stop
+     * adds to every stop the car makes after it
+     * @param car The car
+     * @param call The hall call
+     * @param nowMs The current time on the scheduler's clock
+     * @return Milliseconds of waiting and delay
+     */
+    int64_t cost(int car, const Itinerary::Pickup& call, int64_t nowMs) const;
+
+    /**
+     * Get a car's route
+     * @param car The car
+     * @return The car's position followed by its stops in visiting order
+     */
+    const std::vector<RoutePoint>& getRoute(int car) const { return routes[car]; }
+
+    /**
+     * Get the travel times the routes are costed with
+     * @return The floor by floor table
+     */
+    const TravelTimeTable& getTravelTimes() const { return travelTimes; }
+
+private:
+    TravelTimeTable travelTimes;
+    std::vector<std::vector<RoutePoint>> routes;    // Per car: its position, then its stops
+    std::vector<uint8_t> moving;                    // 1 if the car was between floors at its last update
+    std::vector<int64_t> reportMs;                  // When each car last reported, which its route is timed from
+
+    int32_t locate(int car, const Itinerary::Pickup& call, int64_t nowMs, size_t& later, bool& newStop) const;
+};
+
+#endif // ETA_MODEL_H
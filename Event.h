@@ -4,9 +4,20 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <cstdint>
 #include "Datagram.h"
 #include "ElevatorEnums.h"
 
+// Binary wire format: first byte marks a binary record, second byte is the layout version
+#define EVENT_WIRE_MAGIC 0xEB
+#define EVENT_WIRE_VERSION 2
+#define EVENT_WIRE_SIZE 28
+
+// How the source field is spelled, so a binary record decodes to the same string
+#define SOURCE_FLOOR 0              // "<floor>"
+#define SOURCE_ELEVATOR_STATUS 1    // "Elevator: <id>", sent while moving or arriving
+#define SOURCE_ELEVATOR 2           // "Elevator<id>", sent when a trip completes
+
 /**
  * Structure to represent elevator events.
  * This includes the time of the event, the source (floor or elevator), 
@@ -23,21 +34,184 @@ struct Event {
     int riders;             // number of riders in the elevator
     bool isComplete;        // indicates if the request has been completed
     int fault;              // fault in system
+    long long callMs;       // when the hall button was pressed, in ms on the driving clock, -1 until stamped
+    Direction answering;    // on an arrival sent to the floor, the hall call the car answers there
 
     // Default constructor
     Event() : time(""), source(""), floorButton(""), elevatorButton(0), 
               isFromFloor(false), assignedElevator(0), currentFloor(0),
-              riders(0), isComplete(false), fault(0) {}
+              riders(0), isComplete(false), fault(0), callMs(-1), answering(DIRECTION_IDLE) {}
     
     // Constructor with parameters
     Event(const std::string& t, const std::string& src, const std::string& fb, 
           int eb, bool isFF, int ae = 0, int cf = 0, int r = 0, bool ic = false, int f = 0) 
         : time(t), source(src), floorButton(fb), elevatorButton(eb),
           isFromFloor(isFF), assignedElevator(ae), currentFloor(cf),
-          riders(r), isComplete(ic), fault(f) {}
+          riders(r), isComplete(ic), fault(f), callMs(-1), answering(DIRECTION_IDLE) {}
+
+    /**
+     * Converts an input file timestamp (hh:mm:ss or hh:mm:ss.mmm) into milliseconds since midnight
+     * @param t The timestamp string
+     * @return The number of milliseconds, or -1 if the timestamp is malformed
+     */
+    static long long timeToMillis(const std::string& t) {
+        return timeToMillis(t.data(), t.size());
+    }
+
+    /**
+     * Converts a timestamp that is not null terminated, such as a token in a mapped file
+     * @param t The first character of the timestamp
+     * @param length The number of characters
+     * @return The number of milliseconds, or -1 if the timestamp is malformed
+     */
+    static long long timeToMillis(const char* t, size_t length) {
+        // Fields are hours, minutes, seconds and an optional fraction of a second
+        long long fields[3] = {0, 0, 0};
+        size_t i = 0;
+        for (int field = 0; field < 3; field++) {
+            if (field > 0) {
+                if (i >= length || t[i] != ':') return -1;
+                i++;
+            }
+            if (i >= length || t[i] < '0' || t[i] > '9') return -1;
+            while (i < length && t[i] >= '0' && t[i] <= '9') {
+                fields[field] = fields[field] * 10 + (t[i++] - '0');
+            }
+        }
+        long long millis = (fields[0] * 3600 + fields[1] * 60 + fields[2]) * 1000;
+        if (i < length && t[i] == '.') {
+            int scale = 100;
+            for (i++; i < length && t[i] >= '0' && t[i] <= '9'; i++, scale /= 10) {
+                millis += (t[i] - '0') * scale;
+            }
+        }
+        return i == length ? millis : -1;
+    }
+
+    /**
+     * Gets the encoding used by event_to_bytes. Decoding detects the format on its own.
+     * @return A reference to the process wide wire format
+     */
+    static WireFormat& wireFormat() {
+        static WireFormat format = WIRE_BINARY;
+        return format;
+    }
+
+    /**
+     * Reads the direction of the floor button, ignoring case
+     * @return DIRECTION_UP, DIRECTION_DOWN, or DIRECTION_IDLE if no direction is given
+     */
+    Direction direction() const {
+        if (floorButton.size() == 2 && (floorButton[0] | 0x20) == 'u' && (floorButton[1] | 0x20) == 'p') {
+            return DIRECTION_UP;
+        }
+        if (floorButton.size() == 4 && (floorButton[0] | 0x20) == 'd' && (floorButton[1] | 0x20) == 'o'
+            && (floorButton[2] | 0x20) == 'w' && (floorButton[3] | 0x20) == 'n') {
+            return DIRECTION_DOWN;
+        }
+        return DIRECTION_IDLE;
+    }
+
+    /**
+     * Encodes the event as a fixed-layout binary record without allocating
+     * @param buffer Destination of at least EVENT_WIRE_SIZE bytes
+     * @param capacity Size of the destination
+     * @return Number of bytes written, or 0 if the buffer is too small
+     */
+    size_t encode(uint8_t* buffer, size_t capacity) const {
+        if (capacity < EVENT_WIRE_SIZE) return 0;
+
+        int sourceKind = SOURCE_FLOOR;
+        size_t digits = 0;
+        if (source.compare(0, 9, "Elevator:") == 0) {
+            sourceKind = SOURCE_ELEVATOR_STATUS;
+            digits = 9;
+        } else if (source.compare(0, 8, "Elevator") == 0) {
+            sourceKind = SOURCE_ELEVATOR;
+            digits = 8;
+        }
+
+        buffer[0] = EVENT_WIRE_MAGIC;
+        buffer[1] = EVENT_WIRE_VERSION;
+        buffer[2] = (isFromFloor ? 0x01 : 0) | (isComplete ? 0x02 : 0)
+                  | (answering == DIRECTION_UP ? 0x04 : 0) | (answering == DIRECTION_DOWN ? 0x08 : 0);
+        buffer[3] = static_cast<uint8_t>(sourceKind);
+        buffer[4] = static_cast<uint8_t>(direction());
+        buffer[5] = static_cast<uint8_t>(fault);
+        putInt16(buffer + 6, parseNumber(source, digits));
+        putInt32(buffer + 8, static_cast<int32_t>(timeToMillis(time)));
+        putInt16(buffer + 12, elevatorButton);
+        putInt16(buffer + 14, assignedElevator);
+        putInt16(buffer + 16, currentFloor);
+        putInt16(buffer + 18, riders);
+        putInt64(buffer + 20, callMs);
+        return EVENT_WIRE_SIZE;
+    }
+
+    /**
+     * Decodes a binary record into an existing event. The rebuilt strings are short
+     * enough to stay in the small string buffer, so no memory is allocated.
+     * @param data The received bytes
+     * @param length Number of valid bytes
+     * @param event The event to fill in
+     * @return False if the bytes are not a binary record of a known version
+     */
+    static bool decode(const uint8_t* data, size_t length, Event& event) {
+        if (length < EVENT_WIRE_SIZE || data[0] != EVENT_WIRE_MAGIC || data[1] != EVENT_WIRE_VERSION) {
+            return false;
+        }
+
+        char text[16];
+        size_t textLength = 0;
+        if (data[3] == SOURCE_ELEVATOR_STATUS) {
+            textLength = copyText(text, "Elevator: ");
+        } else if (data[3] == SOURCE_ELEVATOR) {
+            textLength = copyText(text, "Elevator");
+        }
+        textLength += writeNumber(text + textLength, getInt16(data + 6));
+        event.source.assign(text, textLength);
+
+        int32_t millis = getInt32(data + 8);
+        if (millis < 0) {
+            event.time.clear();
+        } else {
+            // hh:mm:ss.mmm
+            writeDigits(text, millis / 3600000 % 100, 2);
+            text[2] = ':';
+            writeDigits(text + 3, millis / 60000 % 60, 2);
+            text[5] = ':';
+            writeDigits(text + 6, millis / 1000 % 60, 2);
+            text[8] = '.';
+            writeDigits(text + 9, millis % 1000, 3);
+            event.time.assign(text, 12);
+        }
+
+        switch (data[4]) {
+            case DIRECTION_UP: event.floorButton.assign("UP", 2); break;
+            case DIRECTION_DOWN: event.floorButton.assign("DOWN", 4); break;
+            default: event.floorButton.clear(); break;
+        }
+
+        event.isFromFloor = (data[2] & 0x01) != 0;
+        event.isComplete = (data[2] & 0x02) != 0;
+        event.answering = (data[2] & 0x04) ? DIRECTION_UP : (data[2] & 0x08) ? DIRECTION_DOWN : DIRECTION_IDLE;
+        event.fault = data[5];
+        event.elevatorButton = getInt16(data + 12);
+        event.assignedElevator = getInt16(data + 14);
+        event.currentFloor = getInt16(data + 16);
+        event.riders = getInt16(data + 18);
+        event.callMs = getInt64(data + 20);
+        return true;
+    }
 
     //Turns an event into a vector of bytes so that it can be sent via UDP to other processes
     std::vector<uint8_t> event_to_bytes() const {
+        if (wireFormat() == WIRE_BINARY) {
+            std::vector<uint8_t> result(EVENT_WIRE_SIZE);
+            encode(result.data(), result.size());
+            return result;
+        }
+
         // Create the data string including isComplete
         std::string data = time + "," + source + "," + floorButton + "," 
                          + std::to_string(elevatorButton) + ","
@@ -46,18 +220,45 @@ struct Event {
                          + std::to_string(currentFloor) + ","
                          + std::to_string(riders) + ","
                          + (isComplete ? "1" : "0") + ","
-                         + std::to_string(fault);
+                         + std::to_string(fault) + ","
+                         + std::to_string(callMs) + ","
+                         + std::to_string(answering);
                          
         std::vector<uint8_t> result(data.begin(), data.end());
         return result;
     }
     
+    /**
+     * Writes the event into a caller buffer in the selected wire format
+     * @param buffer Destination buffer
+     * @param capacity Size of the destination
+     * @return Number of bytes written, or 0 if the buffer is too small
+     */
+    size_t event_to_bytes(uint8_t* buffer, size_t capacity) const {
+        if (wireFormat() == WIRE_BINARY) {
+            return encode(buffer, capacity);
+        }
+        std::vector<uint8_t> text = event_to_bytes();
+        if (text.size() > capacity) return 0;
+        std::copy(text.begin(), text.end(), buffer);
+        return text.size();
+    }
+
     static Event bytes_to_event(const std::vector<uint8_t>& data) {
+        return bytes_to_event(data.data(), data.size());
+    }
+
+    static Event bytes_to_event(const uint8_t* data, size_t length) {
         Event event; // event to be returned
+
+        // Binary records are recognised by their first byte, anything else is text
+        if (decode(data, length, event)) {
+            return event;
+        }
         
         // Convert the data to a string, trimming any null bytes or extra whitespace
         std::string str;
-        for (size_t i = 0; i < data.size(); i++) {
+        for (size_t i = 0; i < length; i++) {
             if (data[i] == 0) break; // Stop at null terminator
             str.push_back(static_cast<char>(data[i]));
         }
@@ -122,12 +323,104 @@ struct Event {
 
         // Parse fault
         std::string faultStr;
-        if (std::getline(stream, faultStr)) {
+        if (std::getline(stream, faultStr, ',')) {
             event.fault = std::stoi(faultStr);
         }
+
+        // Parse the time of the hall call, which older senders leave out
+        std::string callStr;
+        if (std::getline(stream, callStr, ',') && !callStr.empty()) {
+            event.callMs = std::stoll(callStr);
+        }
+        std::string answeringStr;
+        if (std::getline(stream, answeringStr) && !answeringStr.empty()) {
+            event.answering = static_cast<Direction>(std::stoi(answeringStr));
+        }
         
         return event;
     }
+
+private:
+    // Little-endian helpers for the binary record
+    static void putInt16(uint8_t* out, int value) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    static void putInt32(uint8_t* out, int32_t value) {
+        uint32_t bits = static_cast<uint32_t>(value);
+        out[0] = static_cast<uint8_t>(bits);
+        out[1] = static_cast<uint8_t>(bits >> 8);
+        out[2] = static_cast<uint8_t>(bits >> 16);
+        out[3] = static_cast<uint8_t>(bits >> 24);
+    }
+
+    static void putInt64(uint8_t* out, int64_t value) {
+        uint64_t bits = static_cast<uint64_t>(value);
+        for (int i = 0; i < 8; i++) {
+            out[i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+    }
+
+    static int64_t getInt64(const uint8_t* in) {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++) {
+            bits |= static_cast<uint64_t>(in[i]) << (8 * i);
+        }
+        return static_cast<int64_t>(bits);
+    }
+
+    static int getInt16(const uint8_t* in) {
+        return static_cast<int16_t>(in[0] | (in[1] << 8));
+    }
+
+    static int32_t getInt32(const uint8_t* in) {
+        return static_cast<int32_t>(in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24));
+    }
+
+    // Writes a fixed number of digits, zero padded
+    static void writeDigits(char* out, int value, int width) {
+        for (int i = width - 1; i >= 0; i--) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    // Writes a signed integer and returns the number of characters written
+    static size_t writeNumber(char* out, int value) {
+        size_t length = 0;
+        unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+        if (value < 0) out[length++] = '-';
+        char reversed[10];
+        int count = 0;
+        do {
+            reversed[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        while (count > 0) out[length++] = reversed[--count];
+        return length;
+    }
+
+    // Copies a string literal without its terminator and returns its length
+    static size_t copyText(char* out, const char* text) {
+        size_t length = 0;
+        while (text[length] != '\0') {
+            out[length] = text[length];
+            length++;
+        }
+        return length;
+    }
+
+    // Reads the integer that starts at the given offset, skipping spaces; -1 if there is none
+    static int parseNumber(const std::string& text, size_t from) {
+        while (from < text.size() && text[from] == ' ') from++;
+        if (from >= text.size() || text[from] < '0' || text[from] > '9') return -1;
+        int value = 0;
+        while (from < text.size() && text[from] >= '0' && text[from] <= '9') {
+            value = value * 10 + (text[from++] - '0');
+        }
+        return value;
+    }
 };
 
 #endif
\ No newline at end of file
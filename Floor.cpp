@@ -1,48 +1,139 @@
 #include "Floor.h"
-#include <sstream>
+#include "Logger.h"
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
+namespace {
+
+long long steadyMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 /**
  * Prints out the responses from the scheduler of floor events
  *
  */
 void Floor::handleResponses() {
-    while (!done) {
-        try {
-            //create a datagram packet to receive 
-            std::vector<uint8_t> data(100);
-            DatagramPacket receivePacket(data, data.size());
-            // Block until a datagram is received via receiveSchedulerSocket. 
-            receiveSchedulerSocket.receive(receivePacket);
-
-            Event response = Event::bytes_to_event(data);
-            std::cout << "Floor received response: Time=" << response.time 
-                      << ", Source=" << response.source 
-                      << ", Floor Button=" << response.floorButton 
-                      << ", Elevator Button=" << response.elevatorButton 
-                      << ", Complete=" << (response.isComplete ? "true" : "false") 
-                      << ", Fault=" << response.fault << std::endl;
-            
-            // Only count completions, not intermediate updates
-            if (response.isComplete) {
-                completedEvents++;
-                std::cout << "Event completed! Completed " << completedEvents << " of " << totalEvents << " events" << std::endl;
-            }
+    Reactor reactor;
+    scheduler.addReactor(&reactor);
+    registerWith(reactor);
+    if (!done) {
+        reactor.run();
+    }
+    scheduler.removeReactor(&reactor);
+}
 
-            if (totalEvents == completedEvents) { break;}
+/**
+ * Registers the floor endpoint with an event loop
+ * @param reactor The event loop to run on
+ */
+void Floor::registerWith(Reactor& reactor) {
+    reactor.addReadable(endpoint->fd(), [this]() { drainResponses(); });
+}
 
-        } catch(const std::runtime_error& e) {
-            if (!done){
-                std::cerr << "Error in receiving response from the scheduler" << e.what() << std::endl;
-                exit(1);
-            }
-        }       
+/**
+ * Handles every response waiting at the endpoint and finishes once all events are complete
+ */
+void Floor::drainResponses() {
+    try {
+        endpoint->receive(responses);
+    } catch(const std::runtime_error& e) {
+        if (!done){
+            LOG_ERROR("Error in receiving response from the scheduler" << e.what());
+            exit(1);
+        }
     }
 
-    std::cout << "Finishing up ..." << std::endl;
-    scheduler.finish(); 
+    for (const Event& response : responses) {
+        LOG_INFO("Floor received response: Time=" << response.time 
+                  << ", Source=" << response.source 
+                  << ", Floor Button=" << response.floorButton 
+                  << ", Elevator Button=" << response.elevatorButton 
+                  << ", Complete=" << (response.isComplete ? "true" : "false") 
+                  << ", Fault=" << response.fault);
+        
+        // Only count completions, not intermediate updates
+        if (response.isComplete) {
+            completedEvents++;
+            LOG_INFO("Event completed! Completed " << completedEvents << " of " << totalEvents << " events");
+        } else if (response.floorButton.empty() && response.source.find("Elevator:") != std::string::npos
+                   && response.answering != DIRECTION_IDLE) {
+            // The car answering a hall call has arrived, so the passengers waiting on it step forward
+            releaseJoined(response.currentFloor, response.answering);
+        }
+
+        finishIfComplete();
+        if (done) {
+            return;
+        }
+    }
+}
+
+/**
+ * Finishes once the whole input file has been sent and every event is complete.
+ * The response handler and run() can both get here, so only the first one finishes.
+ */
+void Floor::finishIfComplete() {
+    if (sendingDone && totalEvents == completedEvents && !done.exchange(true)) {
+        LOG_INFO("Finishing up ...");
+        scheduler.finish();
+    }
+}
+
+/**
+ * Presses the hall button for a passenger. If it is already lit the passenger joins the
+ * hall call and nothing is sent. The event carries the time of the press, so the passenger's
+ * wait is counted from here however long the call then spends in transit or held.
+ * @param event The passenger's hall call
+ * @return True if the call was queued on the endpoint
+ */
+bool Floor::press(Event&& event) {
+    int floor = std::stoi(event.source);
+    Direction direction = Itinerary::travelDirection(floor, event.elevatorButton, event.direction());
+    event.callMs = steadyMillis();
+    std::lock_guard<std::mutex> lock(sendMtx);
+    HallCall& hallCall = hallCalls[{floor, direction}];
+    if (hallCall.lit) {
+        LOG_INFO("Floor " << floor << " button already lit, passenger to floor " << event.elevatorButton << " waits");
+        hallCall.joined.push_back(std::move(event));
+        joinedPresses++;
+        return false;
+    }
+    hallCall.lit = true;
+    endpoint->send(SCHEDULER_PORT, std::move(event));
+    return true;
+}
+
+/**
+ * Sends the passengers waiting on a hall call when the car answering it arrives, and turns
+ * the button off. The scheduler gives them to that car, which boards them while it is at the
+ * floor. Each keeps the time of its own press, so its wait counts from then.
+ * @param floor The floor the car arrived at
+ * @param direction The hall call the car answers there
+ */
+void Floor::releaseJoined(int floor, Direction direction) {
+    std::lock_guard<std::mutex> lock(sendMtx);
+    try {
+        auto hallCall = hallCalls.find({floor, direction});
+        if (hallCall == hallCalls.end() || !hallCall->second.lit) {
+            return;
+        }
+        hallCall->second.lit = false;
+        for (Event& joined : hallCall->second.joined) {
+            endpoint->send(SCHEDULER_PORT, std::move(joined));
+        }
+        if (!hallCall->second.joined.empty()) {
+            hallCall->second.joined.clear();
+            endpoint->flush();
+        }
+    } catch (const std::runtime_error& e) {
+        LOG_ERROR("Error sending waiting passengers to the scheduler: " << e.what());
+    }
 }
 
 /**
@@ -50,9 +141,16 @@ void Floor::handleResponses() {
  *
  * @param s Reference to the Scheduler object
  * @param fileName Name of the input file containing floor events
+ * @param reactor Event loop to handle responses on; without one a response thread is started
  */
-Floor::Floor(Scheduler& s, const std::string& fileName) : scheduler(s), inputFileName(fileName), receiveSchedulerSocket(FLOOR_PORT) {
-    resThread = std::thread(&Floor::handleResponses, this);
+Floor::Floor(Scheduler& s, const std::string& fileName, Reactor* reactor)
+    : scheduler(s), inputFileName(fileName), endpoint(s.getTransport().open(FLOOR_PORT, SENDERS_ONE)), replaySpeed(0),
+      driftSamples(0), driftTotalUs(0), driftMaxUs(0), joinedPresses(0) {
+    if (reactor) {
+        registerWith(*reactor);
+    } else {
+        resThread = std::thread(&Floor::handleResponses, this);
+    }
 }
 
 /**
@@ -65,47 +163,118 @@ Floor::~Floor() {
     }
 }
 
+/**
+ * Notes how late a paced event was sent
+ * @param lateUs Microseconds between when the event was due and when it was sent
+ */
+void Floor::recordDrift(long long lateUs) {
+    driftSamples++;
+    driftTotalUs += lateUs;
+    driftMaxUs = std::max(driftMaxUs, lateUs);
+}
+
 /**
  * Reads floor event data from a file and sends events to the scheduler
+ * Sending is driven by a reactor timer, which fires as soon as events are due.
+ * Each event is due at its offset from the first event's time, divided by the replay speed.
+ * The file is parsed a batch at a time while it is being sent.
  * 
  */
 void Floor::run() {
+    TraceReader reader(inputFileName);
+    if (!reader.isOpen()) {
+        LOG_ERROR("Could not open " << inputFileName);
+        return;
+    }
+    TraceRecord records[DATAGRAM_BATCH_SIZE];
+    size_t count = reader.next(records, DATAGRAM_BATCH_SIZE);
+    size_t next = 0;
+    if (count == 0) {
+        return;
+    }
 
-    std::ifstream inFile(inputFileName);
-    std::string line;
-    int lineNumber = 0;
-
-    while (std::getline(inFile, line)) {
-        // Skip first two lines
-        lineNumber += 1;
-        if (lineNumber <= 2) {
-            continue;
-        }
+    Reactor reactor;
+    scheduler.addReactor(&reactor);
+    Event event;
+    long long firstTime = records[0].timeMs;
+    long long offset = 0;
+    auto start = std::chrono::steady_clock::now();
+    int timer = -1;
 
-        Event event;
-        std::stringstream extract(line);
-        // Extract values into the event struct
-        if (!(extract >> event.time >> event.source >> event.floorButton >> event.elevatorButton >> event.fault)) {
-            std::cerr << "Error with line: " << line << std::endl;
+    // Sends whatever has been queued; events are counted as they are queued so a fast
+    // response can never finish early
+    size_t queued = 0;
+    auto flush = [&]() {
+        if (queued == 0) {
+            return;
         }
-        // Mark the event as originating from a floor
-        event.isFromFloor = true;
-        std::cout << "Floor created event: Time=" << event.time << ", Source=" << event.source << ", Floor Button=" << event.floorButton << ", Elevator Button=" << event.elevatorButton << ", Fault=" << event.fault << std::endl;
-        totalEvents++; 
-        
-        //create a datagram packet with the event information
-        std::vector<uint8_t> event_data = event.event_to_bytes();
-        DatagramPacket sendPacket(event_data, event_data.size(), InetAddress::getLocalHost(), SCHEDULER_PORT);
-
-        //send it on the sendSchedulerSocket
+        queued = 0;
         try {
-            sendSchedulerSocket.send(sendPacket);
+            std::lock_guard<std::mutex> lock(sendMtx);
+            endpoint->flush();
         } catch (const std::runtime_error& e) {
-            std::cerr << e.what();
+            LOG_ERROR(e.what());
             exit(1);
         }
-        
-        // Add some delay
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+
+    timer = reactor.addTimer(0, 0, [&]() {
+        // Send every event that is due, a batch at a time, then sleep until the next one
+        while (count > 0) {
+            // Times that go backwards keep the previous offset
+            offset = std::max(offset, records[next].timeMs - firstTime);
+            if (replaySpeed > 0) {
+                long long dueUs = static_cast<long long>(offset * 1000 / replaySpeed);
+                long long nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                if (dueUs > nowUs) {
+                    flush();
+                    reactor.rearmTimer(timer, (dueUs - nowUs + 999) / 1000);
+                    return;
+                }
+                recordDrift(nowUs - dueUs);
+            }
+
+            records[next].toEvent(event);
+            LOG_INFO("Floor created event: Time=" << event.time << ", Source=" << event.source << ", Floor Button=" << event.floorButton << ", Elevator Button=" << event.elevatorButton << ", Fault=" << event.fault);
+            totalEvents++;
+            bool sent = false;
+            try {
+                sent = press(std::move(event));
+            } catch (const std::runtime_error& e) {
+                LOG_ERROR(e.what());
+                exit(1);
+            }
+            if (sent && ++queued == DATAGRAM_BATCH_SIZE) {
+                flush();
+            }
+
+            if (++next == count) {
+                count = reader.next(records, DATAGRAM_BATCH_SIZE);
+                next = 0;
+            }
+        }
+        flush();
+        reactor.stop();
+    });
+
+    if (!done) {
+        reactor.run();
+    }
+    scheduler.removeReactor(&reactor);
+
+    if (reader.getMalformedLines() > 0) {
+        LOG_WARN("Skipped " << reader.getMalformedLines() << " malformed lines in " << inputFileName);
+    }
+    if (joinedPresses > 0) {
+        LOG_INFO("Sent " << totalEvents - joinedPresses << " hall calls; " << joinedPresses
+                 << " presses of a lit button waited for a car instead");
     }
-}
\ No newline at end of file
+    if (driftSamples > 0) {
+        LOG_INFO("Replayed " << driftSamples << " events at " << replaySpeed << "x real time, sent on average "
+                 << getMeanDriftUs() << "us and at most " << getMaxDriftUs() << "us after they were due");
+    }
+    // Responses may all have arrived while the last batch was going out
+    sendingDone = true;
+    finishIfComplete();
+}
@@ -6,7 +6,12 @@
 #include <thread>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "Scheduler.h"
+#include "TraceReader.h"
 
 class Floor {
 private:
@@ -16,8 +21,29 @@ private:
     std::thread resThread;
     std::atomic<int> totalEvents{0};    // Total events received
     std::atomic<int> completedEvents{0}; // Processed events count
-    DatagramSocket sendSchedulerSocket;
-    DatagramSocket receiveSchedulerSocket;
+    std::atomic<bool> sendingDone{false}; // Set once the whole input file has been sent
+    std::unique_ptr<Endpoint> endpoint;  // Sends hall calls to the scheduler and receives its responses
+    std::vector<Event> responses;        // Responses drained on each wakeup
+    double replaySpeed;                  // Times real time the input is replayed at, 0 for as fast as possible
+    long long driftSamples;              // Events sent while pacing
+    long long driftTotalUs;              // Sum of how late each paced event was sent
+    long long driftMaxUs;                // Latest any paced event was sent
+
+    // Passengers waiting at one floor to go one way. The first to press the button sends the
+    // hall call; anyone pressing it while it is lit waits here until a car arrives at the floor.
+    struct HallCall {
+        bool lit = false;
+        std::vector<Event> joined;
+    };
+    std::map<std::pair<int, Direction>, HallCall> hallCalls;
+    std::mutex sendMtx;                  // Guards hallCalls and sends, made by run() and the response handler
+    long long joinedPresses;             // Presses that joined a lit hall call
+
+    bool press(Event&& event);
+    void releaseJoined(int floor, Direction direction);
+    void drainResponses();
+    void finishIfComplete();
+    void recordDrift(long long lateUs);
 
 public:
     /**
@@ -25,13 +51,20 @@ public:
      * 
      * @param s The scheduler instance.
      * @param fileName The input file containing event data.
+     * @param reactor Event loop to handle responses on; without one a response thread is started.
      */
-    Floor(Scheduler& s, const std::string& fileName);
+    Floor(Scheduler& s, const std::string& fileName, Reactor* reactor = nullptr);
 
     /**
      * Handle the responses from the scheduler and print them to the console.
      */
     void handleResponses();
+
+    /**
+     * Registers the floor endpoint with an event loop so responses are handled as soon as they arrive
+     * @param reactor The event loop to run on
+     */
+    void registerWith(Reactor& reactor);
     
     /**
      * Destructor for the Floor class, ensures the response thread is joined.
@@ -43,6 +76,34 @@ public:
     */
    void run();
 
+    /**
+     * Sets how fast run() replays the input. Each hall call is sent at its offset from
+     * the first line's Time divided by the speed, so 1 is real time and 10 is ten times faster.
+     * @param speed Times real time, 0 sends every event as fast as possible
+     */
+    void setReplaySpeed(double speed) { replaySpeed = speed; }
+
+    /**
+     * Gets the average time paced events were sent after they were due
+     * @return Microseconds, 0 if nothing was paced
+     */
+    long long getMeanDriftUs() const { return driftSamples > 0 ? driftTotalUs / driftSamples : 0; }
+
+    /**
+     * Gets the longest time a paced event was sent after it was due
+     * @return Microseconds, 0 if nothing was paced
+     */
+    long long getMaxDriftUs() const { return driftMaxUs; }
+
+    /**
+     * Gets the number of passengers who pressed a hall button that was already lit
+     * @return The number of hall calls not sent on their own
+     */
+    long long getJoinedPresses() {
+        std::lock_guard<std::mutex> lock(sendMtx);
+        return joinedPresses;
+    }
+
     int getCompletedEvents() { return completedEvents.load(); }
 
     int getTotalEvents() { return totalEvents.load(); }
@@ -0,0 +1,210 @@
+#ifndef ITINERARY_H
+#define ITINERARY_H
+
+#include <vector>
+#include <cstdlib>
+#include "ElevatorEnums.h"
+
+#define ELEVATOR_CAPACITY 10    // Passengers a car carries at once
+
+/**
+ * Ordered stop list for one elevator, built from the hall and car calls assigned to it.
+ * Stops are served in sweeps: the car keeps going in its direction while it has stops
+ * ahead, picking up passengers travelling the same way, then turns around. A full car
+ * only stops to let passengers off, and boards no more than it has room for.
+ */
+struct Itinerary {
+    struct Pickup {
+        int origin;             // Floor the passenger is waiting on
+        int destination;        // Floor the passenger wants to go to
+        Direction direction;    // Direction the passenger travels
+    };
+
+    std::vector<Pickup> pickups;    // Passengers waiting for this car
+    std::vector<int> dropoffs;      // Destinations of passengers on board
+
+    /**
+     * Works out which way a passenger travels
+     * @param origin The floor the passenger boards on
+     * @param destination The floor the passenger leaves on
+     * @param button The hall button pressed, used when origin and destination match
+     * @return DIRECTION_UP or DIRECTION_DOWN
+     */
+    static Direction travelDirection(int origin, int destination, Direction button) {
+        if (destination > origin) return DIRECTION_UP;
+        if (destination < origin) return DIRECTION_DOWN;
+        return button == DIRECTION_DOWN ? DIRECTION_DOWN : DIRECTION_UP;
+    }
+
+    static bool isAhead(int stop, int floor, Direction sweep) {
+        return sweep == DIRECTION_UP ? stop > floor : stop < floor;
+    }
+
+    static Direction reverse(Direction sweep) {
+        return sweep == DIRECTION_UP ? DIRECTION_DOWN : DIRECTION_UP;
+    }
+
+    bool empty() const { return pickups.empty() && dropoffs.empty(); }
+
+    bool isFull() const { return dropoffs.size() >= ELEVATOR_CAPACITY; }
+
+    /**
+     * Counts the passengers the car has taken on: those riding and those waiting for it
+     * @return The number of passengers
+     */
+    int load() const { return static_cast<int>(dropoffs.size() + pickups.size()); }
+
+    /**
+     * Checks for any stop strictly ahead of the car
+     * @param floor The car's floor
+     * @param sweep The car's sweep direction
+     * @return True if a drop-off or pickup lies ahead
+     */
+    bool hasStopAhead(int floor, Direction sweep) const {
+        for (int stop : dropoffs) {
+            if (isAhead(stop, floor, sweep)) return true;
+        }
+        for (const Pickup& pickup : pickups) {
+            if (isAhead(pickup.origin, floor, sweep)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Picks the next stop. Drop-offs and same-direction pickups ahead come first, then the
+     * farthest opposite-direction pickup ahead (where the car turns), then the same two
+     * searches behind the car. Passengers waiting on the car's floor come last.
+     * @param floor The car's floor
+     * @param sweep The car's sweep direction, updated to the direction of travel to the stop
+     * @param stop Set to the chosen floor
+     * @return False if there are no stops
+     */
+    bool nextStop(int floor, Direction& sweep, int& stop) const {
+        if (empty()) return false;
+        // Nobody can board a full car until someone gets off, so only drop-offs count
+        static const std::vector<Pickup> none;
+        const std::vector<Pickup>& boardable = isFull() ? none : pickups;
+
+        if (sweep == DIRECTION_IDLE) {
+            // Head for the nearest stop
+            int best = -1;
+            for (int candidate : dropoffs) {
+                if (best < 0 || std::abs(candidate - floor) < std::abs(best - floor)) best = candidate;
+            }
+            for (const Pickup& pickup : boardable) {
+                if (best < 0 || std::abs(pickup.origin - floor) < std::abs(best - floor)) best = pickup.origin;
+            }
+            sweep = best < floor ? DIRECTION_DOWN : DIRECTION_UP;
+        }
+
+        Direction directions[2] = {sweep, reverse(sweep)};
+        for (int pass = 0; pass < 2; pass++) {
+            Direction d = directions[pass];
+            int nearest = -1;
+            for (int candidate : dropoffs) {
+                if (isAhead(candidate, floor, d) && (nearest < 0 || std::abs(candidate - floor) < std::abs(nearest - floor))) {
+                    nearest = candidate;
+                }
+            }
+            for (const Pickup& pickup : boardable) {
+                // Passengers already on the car's floor going its way count on the first pass
+                bool reachable = isAhead(pickup.origin, floor, d) || (pass == 0 && pickup.origin == floor);
+                if (reachable && pickup.direction == d
+                    && (nearest < 0 || std::abs(pickup.origin - floor) < std::abs(nearest - floor))) {
+                    nearest = pickup.origin;
+                }
+            }
+            if (nearest >= 0) {
+                sweep = d;
+                stop = nearest;
+                return true;
+            }
+
+            int farthest = -1;
+            for (const Pickup& pickup : boardable) {
+                if (isAhead(pickup.origin, floor, d) && (farthest < 0 || std::abs(pickup.origin - floor) > std::abs(farthest - floor))) {
+                    farthest = pickup.origin;
+                }
+            }
+            if (farthest >= 0) {
+                sweep = d;
+                stop = farthest;
+                return true;
+            }
+        }
+
+        // Only work on the car's own floor is left
+        for (const Pickup& pickup : boardable) {
+            if (pickup.origin == floor) {
+                sweep = pickup.direction;
+                stop = floor;
+                return true;
+            }
+        }
+        stop = floor;
+        return true;
+    }
+
+    /**
+     * Decides which way the car leaves a stop, which decides who boards there
+     * @param floor The stop
+     * @param sweep The car's sweep direction on arrival
+     * @return The direction of passengers that should board
+     */
+    Direction leavingDirection(int floor, Direction sweep) const {
+        if (hasStopAhead(floor, sweep)) return sweep;
+        for (const Pickup& pickup : pickups) {
+            if (pickup.origin == floor && pickup.direction == sweep) return sweep;
+        }
+        for (const Pickup& pickup : pickups) {
+            if (pickup.origin == floor) return pickup.direction;
+        }
+        return sweep;
+    }
+
+    /**
+     * Lists the stops in the order the car will serve them if no more calls arrive
+     * @param floor The car's floor
+     * @param sweep The car's sweep direction
+     * @return Floors in visiting order
+     */
+    std::vector<int> plan(int floor, Direction sweep) const {
+        std::vector<int> order;
+        Itinerary remaining = *this;
+        int stop;
+        // Each stop serves at least one drop-off or pickup, so this always ends
+        while (remaining.nextStop(floor, sweep, stop)) {
+            order.push_back(stop);
+            floor = stop;
+            remaining.serve(floor, sweep);
+        }
+        return order;
+    }
+
+    /**
+     * Drops off and boards passengers at a stop, as the car does. Passengers are boarded
+     * in the order they were assigned until the car is full; the rest are left waiting.
+     * @param floor The stop
+     * @param sweep The car's sweep direction, updated to the direction it leaves in
+     */
+    void serve(int floor, Direction& sweep) {
+        for (size_t i = 0; i < dropoffs.size();) {
+            if (dropoffs[i] == floor) {
+                dropoffs.erase(dropoffs.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        sweep = leavingDirection(floor, sweep);
+        for (size_t i = 0; i < pickups.size();) {
+            if (pickups[i].origin == floor && pickups[i].direction == sweep && !isFull()) {
+                dropoffs.push_back(pickups[i].destination);
+                pickups.erase(pickups.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+};
+
+#endif // ITINERARY_H
@@ -0,0 +1,192 @@
+#include "Journal.h"
+#include "Logger.h"
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// Records are little-endian whatever the host, so a journal can be replayed on another machine
+void putLittle(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint64_t getLittle(const uint8_t* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool hasTime(JournalType type) {
+    return type == JOURNAL_ASSIGN || type == JOURNAL_HOLD || type == JOURNAL_WINDOW || type == JOURNAL_UPDATE;
+}
+
+bool hasEvent(JournalType type) {
+    return type == JOURNAL_ASSIGN || type == JOURNAL_HOLD || type == JOURNAL_WINDOW_SENT
+        || type == JOURNAL_UPDATE || type == JOURNAL_RELEASE || type == JOURNAL_SEND;
+}
+
+} // namespace
+
+/**
+ * Creates the journal file and starts its writer
+ * @param fileName The file, replaced if it exists
+ */
+Journal::Journal(const std::string& fileName) : file(std::fopen(fileName.c_str(), "wb")) {
+    if (!file) {
+        LOG_ERROR("Could not create journal " << fileName << ": " << std::strerror(errno));
+        return;
+    }
+    filling.reserve(2 * JOURNAL_FLUSH_BYTES);
+    writing.reserve(2 * JOURNAL_FLUSH_BYTES);
+    filling.insert(filling.end(), JOURNAL_MAGIC, JOURNAL_MAGIC + 4);
+    filling.push_back(JOURNAL_VERSION);
+    writer = std::thread(&Journal::writeLoop, this);
+}
+
+/**
+ * Writes everything recorded and closes the file
+ */
+Journal::~Journal() {
+    close();
+}
+
+/**
+ * Appends a record
+ * @param type What happened
+ * @param value The car, port, count or setting the type calls for
+ * @param event The event the type calls for, or null
+ * @param timeMs The time the type calls for
+ */
+void Journal::record(JournalType type, int32_t value, const Event* event, long long timeMs) {
+    uint8_t encoded[EVENT_WIRE_SIZE] = {};
+    if (hasEvent(type) && event) {
+        event->encode(encoded, sizeof(encoded));
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!file || stopping) {
+        return;
+    }
+    filling.push_back(type);
+    putLittle(filling, static_cast<uint32_t>(value), 4);
+    if (hasTime(type)) {
+        putLittle(filling, static_cast<uint64_t>(timeMs), 8);
+    }
+    if (hasEvent(type)) {
+        filling.insert(filling.end(), encoded, encoded + EVENT_WIRE_SIZE);
+    }
+    records++;
+    if (filling.size() >= JOURNAL_FLUSH_BYTES) {
+        wake.notify_one();
+    }
+}
+
+/**
+ * Gets the number of records appended
+ * @return The count
+ */
+uint64_t Journal::getRecords() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return records;
+}
+
+/**
+ * Writes everything recorded so far, stops the writer and closes the file
+ */
+void Journal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file || stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+/**
+ * Writer thread: takes the filled buffer whenever it is large enough or JOURNAL_FLUSH_MS
+ * has passed, and writes it out while recording carries on into the other buffer
+ */
+void Journal::writeLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait_for(lock, std::chrono::milliseconds(JOURNAL_FLUSH_MS),
+                      [this]() { return stopping || filling.size() >= JOURNAL_FLUSH_BYTES; });
+        bool last = stopping;
+        writing.swap(filling);
+        lock.unlock();
+        if (!writing.empty()) {
+            if (std::fwrite(writing.data(), 1, writing.size(), file) != writing.size()) {
+                LOG_ERROR("Error writing journal: " << std::strerror(errno));
+            }
+            std::fflush(file);
+            writing.clear();
+        }
+        if (last) {
+            return;
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Reads a whole journal
+ * @param fileName The journal file
+ * @param entries Output, every record in order
+ * @return False if the file is missing, is not a journal, or ends inside a record
+ */
+bool Journal::read(const std::string& fileName, std::vector<JournalEntry>& entries) {
+    FILE* in = std::fopen(fileName.c_str(), "rb");
+    if (!in) {
+        LOG_ERROR("Could not open journal " << fileName << ": " << std::strerror(errno));
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[JOURNAL_FLUSH_BYTES];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    std::fclose(in);
+
+    if (data.size() < JOURNAL_HEADER_SIZE || std::memcmp(data.data(), JOURNAL_MAGIC, 4) != 0
+        || data[4] != JOURNAL_VERSION) {
+        LOG_ERROR(fileName << " is not a journal of version " << JOURNAL_VERSION);
+        return false;
+    }
+    size_t position = JOURNAL_HEADER_SIZE;
+    while (position < data.size()) {
+        JournalEntry entry;
+        entry.type = static_cast<JournalType>(data[position]);
+        size_t length = 5 + (hasTime(entry.type) ? 8 : 0) + (hasEvent(entry.type) ? EVENT_WIRE_SIZE : 0);
+        if (entry.type < JOURNAL_CARS || entry.type > JOURNAL_SEND || position + length > data.size()) {
+            LOG_ERROR("Journal " << fileName << " is cut off or corrupt at byte " << position);
+            return false;
+        }
+        const uint8_t* record = &data[position + 1];
+        entry.value = static_cast<int32_t>(getLittle(record, 4));
+        record += 4;
+        entry.timeMs = 0;
+        if (hasTime(entry.type)) {
+            entry.timeMs = static_cast<long long>(getLittle(record, 8));
+            record += 8;
+        }
+        entry.hasEvent = hasEvent(entry.type);
+        if (entry.hasEvent && !Event::decode(record, EVENT_WIRE_SIZE, entry.event)) {
+            LOG_ERROR("Journal " << fileName << " has a bad event at byte " << position);
+            return false;
+        }
+        entries.push_back(std::move(entry));
+        position += length;
+    }
+    return true;
+}
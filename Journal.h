@@ -0,0 +1,130 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Event.h"
+
+#define JOURNAL_MAGIC "ELVJ"            // First bytes of every journal file
+#define JOURNAL_VERSION 3
+#define JOURNAL_HEADER_SIZE 5           // Magic and version
+#define JOURNAL_FLUSH_BYTES 65536       // The writer is woken once this much is waiting
+#define JOURNAL_FLUSH_MS 100            // and otherwise writes whatever is waiting this often
+
+// What a journal record holds. Every record starts with its type and a 32-bit value;
+// ASSIGN, HOLD, WINDOW and UPDATE add a 64-bit time, and the records about an event add
+// it in the binary wire format.
+enum JournalType : uint8_t {
+    JOURNAL_CARS = 1,       // value: number of cars
+    JOURNAL_POLICY,         // value: dispatch policy
+    JOURNAL_BATCH_WINDOW,   // value: batch window in milliseconds
+    JOURNAL_ASSIGN,         // value: car chosen; time: when it was assigned; event: the hall call
+    JOURNAL_HOLD,           // time: when the call was held; event: the hall call
+    JOURNAL_WINDOW,         // value: calls sent on; time: when the window closed
+    JOURNAL_WINDOW_SENT,    // value: car chosen; event: a call sent on by the window before it
+    JOURNAL_UPDATE,         // time: when it came in; event: a response from a car
+    JOURNAL_REMOVE,         // value: car taken out of service
+    JOURNAL_RESTORE,        // value: car back in service
+    JOURNAL_RELEASE,        // value: car; event: the hall call it handed back
+    JOURNAL_SEND,           // value: port; event: sent to the floor or a car
+};
+
+/**
+ * One record read back from a journal
+ */
+struct JournalEntry {
+    JournalType type;
+    int32_t value;
+    long long timeMs;       // 0 unless the type carries a time
+    bool hasEvent;
+    Event event;
+};
+
+/**
+ * What a replay did, and where it first decided differently from the journal
+ */
+struct ReplayResult {
+    bool ok = false;                // False if the journal could not be read
+    uint64_t records = 0;
+    uint64_t decisions = 0;         // Assignments made again and compared
+    uint64_t mismatches = 0;
+    long long firstMismatch = -1;   // Index of the first record that came out differently
+    uint64_t sends = 0;             // Events the recorded run sent, which a replay does not
+};
+
+/**
+ * Append-only binary log of what the scheduler took in, sent and decided. Recording
+ * copies a few dozen bytes into a buffer under a short lock; a writer thread of the
+ * journal's own swaps the buffer out and writes it to the file, so the thread making
+ * decisions never waits for the disk.
+ */
+class Journal {
+public:
+    /**
+     * Creates the journal file and starts its writer
+     * @param fileName The file, replaced if it exists
+     */
+    explicit Journal(const std::string& fileName);
+
+    /**
+     * Writes everything recorded and closes the file
+     */
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * Checks if the file could be created
+     * @return True if records are being written
+     */
+    bool isOpen() const { return file != nullptr; }
+
+    /**
+     * Appends a record
+     * @param type What happened
+     * @param value The car, port, count or setting the type calls for
+     * @param event The event the type calls for, or null
+     * @param timeMs The time the type calls for
+     */
+    void record(JournalType type, int32_t value, const Event* event = nullptr, long long timeMs = 0);
+
+    /**
+     * Writes everything recorded so far, stops the writer and closes the file.
+     * Later records are dropped.
+     */
+    void close();
+
+    /**
+     * Gets the number of records appended
+     * @return The count
+     */
+    uint64_t getRecords();
+
+    /**
+     * Reads a whole journal
+     * @param fileName The journal file
+     * @param entries Output, every record in order
+     * @return False if the file is missing, is not a journal, or ends inside a record
+     */
+    static bool read(const std::string& fileName, std::vector<JournalEntry>& entries);
+
+private:
+    FILE* file;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::vector<uint8_t> filling;       // Records not yet handed to the writer
+    std::vector<uint8_t> writing;       // Records the writer is writing out
+    uint64_t records = 0;
+    bool stopping = false;
+    std::thread writer;
+
+    void writeLoop();
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,153 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#define QUEUE_CACHE_LINE 64     // Keeps producer and consumer indices on separate cache lines
+
+/**
+ * Bounded single-producer, single-consumer queue. One thread pushes and one thread pops;
+ * neither ever locks or waits for the other.
+ */
+template <typename T>
+class SpscQueue {
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+    alignas(QUEUE_CACHE_LINE) std::atomic<size_t> head{0};     // Next slot the producer fills
+    size_t cachedTail = 0;                                      // Producer's last view of tail
+    alignas(QUEUE_CACHE_LINE) std::atomic<size_t> tail{0};     // Next slot the consumer takes
+    size_t cachedHead = 0;                                      // Consumer's last view of head
+
+public:
+    /**
+     * Constructor for the SpscQueue class
+     * @param capacity Slots in the queue, a power of two
+     */
+    explicit SpscQueue(size_t capacity) : slots(new T[capacity]), mask(capacity - 1) {}
+
+    /**
+     * Moves a value into the queue. Producer only.
+     * @param value The value
+     * @return False if the queue is full, leaving the value untouched
+     */
+    bool push(T&& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position - cachedTail > mask) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position - cachedTail > mask) return false;
+        }
+        slots[position & mask] = std::move(value);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Moves the oldest value out of the queue. Consumer only.
+     * @param value Receives the value
+     * @return False if the queue is empty
+     */
+    bool pop(T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position == cachedHead) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position == cachedHead) return false;
+        }
+        value = std::move(slots[position & mask]);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Checks for waiting values. Consumer only.
+     * @return True if nothing is waiting
+     */
+    bool empty() const {
+        return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+};
+
+/**
+ * Bounded multi-producer, single-consumer queue. Each slot carries a sequence number
+ * telling producers when it is free and the consumer when it is filled, so producers
+ * only contend on one compare-and-swap and never lock.
+ */
+template <typename T>
+class MpscQueue {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(QUEUE_CACHE_LINE) std::atomic<size_t> head{0};     // Next slot a producer claims
+    alignas(QUEUE_CACHE_LINE) size_t tail = 0;                  // Next slot the consumer takes
+
+public:
+    /**
+     * Constructor for the MpscQueue class
+     * @param capacity Slots in the queue, a power of two
+     */
+    explicit MpscQueue(size_t capacity) : slots(new Slot[capacity]), mask(capacity - 1) {
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Moves a value into the queue. Any thread.
+     * @param value The value
+     * @return False if the queue is full, leaving the value untouched
+     */
+    bool push(T&& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Moves the oldest value out of the queue. Consumer only.
+     * @param value Receives the value
+     * @return False if the queue is empty or the oldest value is still being written
+     */
+    bool pop(T& value) {
+        Slot& slot = slots[tail & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+            return false;
+        }
+        value = std::move(slot.value);
+        slot.sequence.store(tail + mask + 1, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+    /**
+     * Checks for waiting values. Consumer only.
+     * @return True if nothing is ready to pop
+     */
+    bool empty() const {
+        return slots[tail & mask].sequence.load(std::memory_order_acquire) != tail + 1;
+    }
+};
+
+#endif // LOCK_FREE_QUEUE_H
@@ -0,0 +1,222 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define LOG_WRITER_IDLE_US 500  // How long the writer sleeps when every ring is empty
+
+namespace {
+
+/**
+ * Single-producer, single-consumer ring owned by one logging thread
+ */
+struct Ring {
+    LogRecord records[LOG_RING_SIZE];
+    std::atomic<uint64_t> head{0};          // Next record the owner fills
+    std::atomic<uint64_t> tail{0};          // Next record the writer takes
+    std::atomic<bool> abandoned{false};     // Set when the owning thread exits
+};
+
+/**
+ * Shared logger state. It is never destroyed so threads still running while the
+ * process exits can keep logging.
+ */
+struct LoggerState {
+    std::mutex registryMtx;                 // Guards rings; taken once per thread, not per message
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::mutex drainMtx;                    // Only one thread drains at a time
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<bool> running{false};
+    std::thread writer;
+};
+
+LoggerState& state();
+
+/**
+ * Writes everything buffered in every ring, merged into the order it was logged
+ */
+void drainAll() {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> drainLock(s.drainMtx);
+
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(s.registryMtx);
+        rings = s.rings;
+    }
+    std::vector<uint64_t> cursor(rings.size()), end(rings.size());
+    for (size_t i = 0; i < rings.size(); i++) {
+        cursor[i] = rings[i]->tail.load(std::memory_order_relaxed);
+        end[i] = rings[i]->head.load(std::memory_order_acquire);
+    }
+
+    bool wroteOut = false, wroteErr = false;
+    while (true) {
+        // Each ring is already in order, so take the oldest record at the front of any ring
+        int oldest = -1;
+        for (size_t i = 0; i < rings.size(); i++) {
+            if (cursor[i] == end[i]) continue;
+            const LogRecord& candidate = rings[i]->records[cursor[i] & (LOG_RING_SIZE - 1)];
+            if (oldest < 0 || candidate.sequence < rings[oldest]->records[cursor[oldest] & (LOG_RING_SIZE - 1)].sequence) {
+                oldest = static_cast<int>(i);
+            }
+        }
+        if (oldest < 0) break;
+
+        const LogRecord& record = rings[oldest]->records[cursor[oldest] & (LOG_RING_SIZE - 1)];
+        FILE* stream = record.level >= LOG_LEVEL_ERROR ? stderr : stdout;
+        fwrite(record.text, 1, record.length, stream);
+        fputc('\n', stream);
+        (stream == stderr ? wroteErr : wroteOut) = true;
+        cursor[oldest]++;
+    }
+    if (wroteOut) fflush(stdout);
+    if (wroteErr) fflush(stderr);
+
+    for (size_t i = 0; i < rings.size(); i++) {
+        rings[i]->tail.store(cursor[i], std::memory_order_release);
+    }
+
+    // Forget rings whose threads have gone and whose records are all written
+    std::lock_guard<std::mutex> lock(s.registryMtx);
+    for (size_t i = 0; i < s.rings.size();) {
+        Ring& ring = *s.rings[i];
+        if (ring.abandoned && ring.tail.load() == ring.head.load()) {
+            s.rings.erase(s.rings.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Background writer loop
+ */
+void writeLoop() {
+    LoggerState& s = state();
+    while (s.running.load(std::memory_order_acquire)) {
+        drainAll();
+        std::this_thread::sleep_for(std::chrono::microseconds(LOG_WRITER_IDLE_US));
+    }
+}
+
+/**
+ * Stops the writer and writes what is left, run when the process exits
+ */
+void shutdown() {
+    LoggerState& s = state();
+    s.running.store(false, std::memory_order_release);
+    if (s.writer.joinable()) {
+        s.writer.join();
+    }
+    drainAll();
+}
+
+LoggerState& state() {
+    static LoggerState* instance = [] {
+        LoggerState* created = new LoggerState();
+        created->running = true;
+        created->writer = std::thread(writeLoop);
+        std::atexit(shutdown);
+        return created;
+    }();
+    return *instance;
+}
+
+/**
+ * The calling thread's ring, registered on first use
+ */
+struct RingHandle {
+    std::shared_ptr<Ring> ring;
+
+    Ring& get() {
+        if (!ring) {
+            ring = std::make_shared<Ring>();
+            LoggerState& s = state();
+            std::lock_guard<std::mutex> lock(s.registryMtx);
+            s.rings.push_back(ring);
+        }
+        return *ring;
+    }
+
+    ~RingHandle() {
+        if (ring) ring->abandoned = true;
+    }
+};
+
+thread_local RingHandle localRing;
+
+} // namespace
+
+/**
+ * Parses a level name
+ * @param name debug, info, warn, error or off
+ * @return The level, or -1 if the name is unknown
+ */
+int Logger::levelFromName(const std::string& name) {
+    if (name == "debug") return LOG_LEVEL_DEBUG;
+    if (name == "info") return LOG_LEVEL_INFO;
+    if (name == "warn") return LOG_LEVEL_WARN;
+    if (name == "error") return LOG_LEVEL_ERROR;
+    if (name == "off") return LOG_LEVEL_OFF;
+    return -1;
+}
+
+/**
+ * Claims the next record in the calling thread's ring, waiting if it is full
+ * @param level The level of the message
+ * @return The record to format the message into
+ */
+LogRecord& Logger::reserve(int level) {
+    Ring& ring = localRing.get();
+    LoggerState& s = state();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    while (head - ring.tail.load(std::memory_order_acquire) >= LOG_RING_SIZE) {
+        if (s.running.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        } else {
+            drainAll();
+        }
+    }
+    LogRecord& record = ring.records[head & (LOG_RING_SIZE - 1)];
+    record.sequence = s.sequence.fetch_add(1, std::memory_order_relaxed);
+    record.level = level;
+    record.length = 0;
+    return record;
+}
+
+/**
+ * Hands the record claimed by reserve to the writer
+ */
+void Logger::commit() {
+    Ring& ring = localRing.get();
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Once the writer has stopped at exit, write straight away
+    if (!state().running.load(std::memory_order_acquire)) {
+        drainAll();
+    }
+}
+
+/**
+ * Blocks until every message logged so far has been written
+ */
+void Logger::flush() {
+    drainAll();
+}
+
+/**
+ * Appends a floating point number the way an ostream does by default
+ * @param value The number
+ * @return This line
+ */
+LogLine& LogLine::operator<<(double value) {
+    char digits[32];
+    int length = snprintf(digits, sizeof(digits), "%g", value);
+    append(digits, length > 0 ? static_cast<size_t>(length) : 0);
+    return *this;
+}
@@ -0,0 +1,183 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+// Levels below this are compiled out, for example -DLOG_MIN_LEVEL=LOG_LEVEL_INFO
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_SIZE 4096      // Records buffered per thread, a power of two
+#define LOG_RECORD_TEXT 240     // Longest message kept, longer ones are cut short
+
+/**
+ * One formatted message waiting in a thread's ring
+ */
+struct LogRecord {
+    uint64_t sequence;          // Global order the messages were started in
+    int32_t level;
+    uint32_t length;
+    char text[LOG_RECORD_TEXT];
+};
+
+/**
+ * Asynchronous logger. Each thread formats its messages straight into its own
+ * single-producer ring without taking a lock; a background writer merges the rings
+ * in the order the messages were made and writes them out, errors to stderr and the
+ * rest to stdout. If a ring fills up its thread waits for the writer rather than
+ * dropping messages. Whatever is still buffered is written when the process exits.
+ */
+class Logger {
+public:
+    /**
+     * Checks if messages at a level are written
+     * @param level The level
+     * @return True if the level is at or above the runtime level
+     */
+    static bool enabled(int level) {
+        return level >= runtimeLevel().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the lowest level written. Levels compiled out by LOG_MIN_LEVEL stay out.
+     * @param level The level
+     */
+    static void setLevel(int level) { runtimeLevel().store(level, std::memory_order_relaxed); }
+
+    /**
+     * Gets the lowest level written
+     * @return The level
+     */
+    static int getLevel() { return runtimeLevel().load(std::memory_order_relaxed); }
+
+    /**
+     * Parses a level name
+     * @param name debug, info, warn, error or off
+     * @return The level, or -1 if the name is unknown
+     */
+    static int levelFromName(const std::string& name);
+
+    /**
+     * Claims the next record in the calling thread's ring, waiting if it is full
+     * @param level The level of the message
+     * @return The record to format the message into
+     */
+    static LogRecord& reserve(int level);
+
+    /**
+     * Hands the record claimed by reserve to the writer
+     */
+    static void commit();
+
+    /**
+     * Blocks until every message logged so far has been written
+     */
+    static void flush();
+
+private:
+    static std::atomic<int>& runtimeLevel() {
+        static std::atomic<int> level{LOG_LEVEL_INFO};
+        return level;
+    }
+};
+
+/**
+ * Builds one log message in place with stream syntax, committing it when it goes out of scope
+ */
+class LogLine {
+private:
+    LogRecord& record;
+
+    void append(const char* text, size_t length) {
+        size_t room = LOG_RECORD_TEXT - record.length;
+        if (length > room) length = room;
+        memcpy(record.text + record.length, text, length);
+        record.length += static_cast<uint32_t>(length);
+    }
+
+    template <typename T>
+    void appendNumber(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(digits, result.ptr - digits);
+    }
+
+public:
+    explicit LogLine(int level) : record(Logger::reserve(level)) {}
+    ~LogLine() { Logger::commit(); }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& operator<<(const char* text) { append(text, strlen(text)); return *this; }
+    LogLine& operator<<(const std::string& text) { append(text.data(), text.size()); return *this; }
+    LogLine& operator<<(char c) { append(&c, 1); return *this; }
+    LogLine& operator<<(bool value) { appendNumber(static_cast<int>(value)); return *this; }
+    LogLine& operator<<(double value);
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    LogLine& operator<<(T value) { appendNumber(value); return *this; }
+
+    template <typename T>
+    LogLine& operator<<(const std::atomic<T>& value) { return *this << value.load(); }
+
+    template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+    LogLine& operator<<(T value) { appendNumber(static_cast<typename std::underlying_type<T>::type>(value)); return *this; }
+};
+
+// Formats and queues a message if its level is enabled, for example
+// LOG_INFO("Elevator " << id << " is moving");
+#define LOG_AT(level, message) \
+    do { \
+        if (Logger::enabled(level)) { \
+            LogLine logLine(level); \
+            logLine << message; \
+        } \
+    } while (0)
+
+// Levels below LOG_MIN_LEVEL become dead code: still type checked, never run
+#define LOG_REMOVED(level, message) \
+    do { \
+        if (false) { \
+            LogLine logLine(level); \
+            logLine << message; \
+        } \
+    } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(message) LOG_AT(LOG_LEVEL_DEBUG, message)
+#else
+#define LOG_DEBUG(message) LOG_REMOVED(LOG_LEVEL_DEBUG, message)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(message) LOG_AT(LOG_LEVEL_INFO, message)
+#else
+#define LOG_INFO(message) LOG_REMOVED(LOG_LEVEL_INFO, message)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(message) LOG_AT(LOG_LEVEL_WARN, message)
+#else
+#define LOG_WARN(message) LOG_REMOVED(LOG_LEVEL_WARN, message)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(message) LOG_AT(LOG_LEVEL_ERROR, message)
+#else
+#define LOG_ERROR(message) LOG_REMOVED(LOG_LEVEL_ERROR, message)
+#endif
+
+#endif // LOGGER_H
@@ -10,8 +10,15 @@
 #include <thread>
 #include <vector>
 #include <memory>
+#include <csignal>
+#include <sys/signalfd.h>
+#include <unistd.h>
 #include "Floor.h"
 #include "ElevatorSubsystem.h"
+#include "ElevatorBank.h"
+#include "Simulation.h"
+#include "SweepRunner.h"
+#include "Logger.h"
 
 // Default number of elevators if not specified
 #define DEFAULT_NUM_ELEVATORS 4
@@ -19,45 +26,322 @@
 // Base port for elevator subsystems
 #define ELEVATOR_PORT_BASE 9000
 
+/**
+ * Reads a dispatch policy name
+ * @param name look, eta or heuristic
+ * @param policy Set to the policy named
+ * @return False if the name is unknown
+ */
+static bool parsePolicy(const std::string& name, DispatchPolicy& policy) {
+    if (name == "look") {
+        policy = DispatchPolicy::DISPATCH_LOOK;
+    } else if (name == "eta") {
+        policy = DispatchPolicy::DISPATCH_ETA;
+    } else if (name == "heuristic") {
+        policy = DispatchPolicy::DISPATCH_HEURISTIC;
+    } else {
+        LOG_ERROR("Unknown dispatch policy: " << name);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Splits a comma separated list
+ * @param list The text, such as "2,4,6"
+ * @return The items, in order
+ */
+static std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
 int main(int argc, char* argv[]) {
+    // SIGUSR1 reports passenger metrics so far. It is blocked before any thread starts,
+    // including the logger's, so every thread inherits the mask and it is only read from the signalfd.
+    sigset_t reportSignal;
+    sigemptyset(&reportSignal);
+    sigaddset(&reportSignal, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &reportSignal, nullptr);
+
     // Get filename and number of elevators
     std::string filename = argv[1];
-    int numElevators = (argc > 2) ? std::stoi(argv[2]) : DEFAULT_NUM_ELEVATORS;
+    int numElevators = (argc > 2 && argv[2][0] != '-') ? std::stoi(argv[2]) : DEFAULT_NUM_ELEVATORS;
+
+    // Optional flags: --simulate runs on a virtual clock, --speed N replays the input at N times
+    // real time (as fast as possible if left out or 0),
+    // --thread-per-car runs every elevator on its own thread instead of coroutines on a worker pool,
+    // --udp passes events between the subsystems as UDP datagrams instead of in-process queues,
+    // --shm passes them through shared-memory rings, the transport for subsystems in separate processes,
+    // --text-wire sends those datagrams as readable text instead of binary records,
+    // --policy look|eta|heuristic chooses how hall calls are assigned,
+    // --batch-window MS holds hall calls for MS milliseconds and assigns them together,
+    // --log-level debug|info|warn|error|off sets the lowest level logged,
+    // --sweep SEEDS replays the input SEEDS times for every combination of --cars LIST,
+    // --policies LIST and --batch-windows LIST (comma separated, each defaulting to the single run's value),
+    // moving each hall call by up to --jitter MS per run, on --threads N workers (one per core if 0),
+    // --journal FILE records the scheduler's inputs, sends and assignments,
+    // --replay re-runs the journal given in place of the input file and checks every assignment,
+    // --checkpoint FILE with --checkpoint-at MS saves a simulation's whole state once it reaches MS,
+    // --restore carries on a simulation from the checkpoint given in place of the input file
+    bool simulate = false;
+    bool udp = false;
+    bool sharedMemory = false;
+    bool threadPerCar = false;
+    DispatchPolicy policy = DispatchPolicy::DISPATCH_HEURISTIC;
+    double speed = 0;
+    int batchWindow = 0;
+    int sweepSeeds = 0;
+    long long jitter = SWEEP_DEFAULT_JITTER_MS;
+    int sweepThreads = 0;
+    std::string carList, policyList, windowList;
+    std::string journalFile;
+    bool replay = false;
+    std::string checkpointFile;
+    long long checkpointAt = -1;
+    bool restore = false;
+    bool policyGiven = false;
+    bool windowGiven = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--simulate") {
+            simulate = true;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        } else if (arg == "--udp") {
+            udp = true;
+        } else if (arg == "--thread-per-car") {
+            threadPerCar = true;
+        } else if (arg == "--shm") {
+            sharedMemory = true;
+        } else if (arg == "--text-wire") {
+            Event::wireFormat() = WIRE_TEXT;
+        } else if (arg == "--policy" && i + 1 < argc) {
+            if (!parsePolicy(argv[++i], policy)) {
+                return 1;
+            }
+            policyGiven = true;
+        } else if (arg == "--batch-window" && i + 1 < argc) {
+            batchWindow = std::stoi(argv[++i]);
+            windowGiven = true;
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            int level = Logger::levelFromName(argv[++i]);
+            if (level < 0) {
+                LOG_ERROR("Unknown log level: " << argv[i]);
+                return 1;
+            }
+            Logger::setLevel(level);
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            sweepSeeds = std::stoi(argv[++i]);
+        } else if (arg == "--cars" && i + 1 < argc) {
+            carList = argv[++i];
+        } else if (arg == "--policies" && i + 1 < argc) {
+            policyList = argv[++i];
+        } else if (arg == "--batch-windows" && i + 1 < argc) {
+            windowList = argv[++i];
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            jitter = std::stoll(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            sweepThreads = std::stoi(argv[++i]);
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalFile = argv[++i];
+        } else if (arg == "--replay") {
+            replay = true;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        } else if (arg == "--checkpoint-at" && i + 1 < argc) {
+            checkpointAt = std::stoll(argv[++i]);
+        } else if (arg == "--restore") {
+            restore = true;
+        }
+    }
+
+    if (replay) {
+        auto start = std::chrono::steady_clock::now();
+        ReplayResult result = Scheduler::replay(filename);
+        if (!result.ok) {
+            return 1;
+        }
+        long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Replayed " << result.records << " records in " << millis << " ms: " << result.decisions
+                 << " assignments made again, " << result.mismatches << " different from the journal, "
+                 << result.sends << " sends skipped");
+        if (result.mismatches > 0) {
+            LOG_ERROR("First difference at record " << result.firstMismatch);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Opened before the scheduler so it outlives it
+    std::unique_ptr<Journal> journal;
+    if (!journalFile.empty()) {
+        journal = std::make_unique<Journal>(journalFile);
+        if (!journal->isOpen()) {
+            return 1;
+        }
+    }
+
+    if (sweepSeeds > 0) {
+        std::vector<std::pair<long long, Event>> calls;
+        if (!Simulation::readFile(filename, calls)) {
+            return 1;
+        }
+        std::vector<int> cars;
+        for (const std::string& item : splitList(carList)) {
+            cars.push_back(std::stoi(item));
+        }
+        if (cars.empty()) {
+            cars.push_back(numElevators);
+        }
+        std::vector<DispatchPolicy> policies;
+        for (const std::string& item : splitList(policyList)) {
+            DispatchPolicy named;
+            if (!parsePolicy(item, named)) {
+                return 1;
+            }
+            policies.push_back(named);
+        }
+        if (policies.empty()) {
+            policies.push_back(policy);
+        }
+        std::vector<int> windows;
+        for (const std::string& item : splitList(windowList)) {
+            windows.push_back(std::stoi(item));
+        }
+        if (windows.empty()) {
+            windows.push_back(batchWindow);
+        }
+
+        SweepRunner sweep(std::move(calls));
+        sweep.setJitter(jitter);
+        sweep.setThreads(sweepThreads);
+        for (int count : cars) {
+            for (DispatchPolicy named : policies) {
+                for (int window : windows) {
+                    sweep.add({count, named, window});
+                }
+            }
+        }
+        LOG_INFO("Sweeping " << cars.size() * policies.size() * windows.size() << " configurations, "
+                 << sweepSeeds << " runs each");
+        sweep.run(sweepSeeds);
+        sweep.printTable();
+        return 0;
+    }
+
+    if (simulate || restore) {
+        std::unique_ptr<Simulation> restored;
+        if (restore) {
+            restored = Simulation::restoreCheckpoint(filename, speed);
+            if (!restored) {
+                return 1;
+            }
+        } else {
+            LOG_INFO("Simulating elevator system with " << numElevators << " elevators");
+            restored = std::make_unique<Simulation>(numElevators, speed);
+        }
+        Simulation& simulation = *restored;
+
+        // A restored scheduler keeps the policy and window it was saved with unless others are asked for
+        if (!restore || policyGiven) {
+            simulation.getScheduler().setDispatchPolicy(policy);
+        }
+        if (!restore || windowGiven) {
+            simulation.getScheduler().setBatchWindow(batchWindow);
+        }
+        simulation.getScheduler().setJournal(journal.get());
+        if (!restore && !simulation.loadFile(filename)) {
+            return 1;
+        }
+        if (!checkpointFile.empty()) {
+            simulation.runUntil(std::max(checkpointAt, 0LL));
+            if (!simulation.saveCheckpoint(checkpointFile)) {
+                return 1;
+            }
+        }
+        simulation.run();
+        LOG_INFO("Simulation finished at t=" << simulation.now() << "ms, completed "
+                  << simulation.getCompletedEvents() << " of " << simulation.getTotalEvents() << " events");
+        simulation.getScheduler().getMetrics().report();
+        simulation.getScheduler().reportDispatch();
+        return 0;
+    }
     
-    std::cout << "Starting elevator system with " << numElevators << " elevators" << std::endl;
+    LOG_INFO("Starting elevator system with " << numElevators << " elevators");
+
+    // The subsystems share this process, so unless asked for UDP they hand events over in memory
+    std::unique_ptr<Transport> transport;
+    if (sharedMemory) {
+        // Every subsystem starts here, so events left by an earlier run are stale
+        auto rings = std::make_unique<SharedMemoryTransport>();
+        rings->remove(SCHEDULER_PORT);
+        rings->remove(FLOOR_PORT);
+        rings->remove(ELEVATOR_PORT);
+        for (int i = 0; threadPerCar && i < numElevators; i++) {
+            rings->remove(ELEVATOR_PORT_BASE + i);
+        }
+        transport = std::move(rings);
+    } else if (!udp) {
+        transport = std::make_unique<InProcessTransport>();
+    }
 
     // Create scheduler with specified number of elevators
-    Scheduler scheduler(numElevators);
+    Scheduler scheduler(numElevators, true, transport.get());
+    scheduler.setDispatchPolicy(policy);
+    scheduler.setBatchWindow(batchWindow);
+    scheduler.setJournal(journal.get());
+
+    // One event loop serves the scheduler, the elevator subsystems and the floor responses
+    Reactor reactor;
+    scheduler.registerWith(reactor);
+    int reportFd = signalfd(-1, &reportSignal, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (reportFd >= 0) {
+        reactor.addReadable(reportFd, [&scheduler, reportFd]() {
+            struct signalfd_siginfo info;
+            while (read(reportFd, &info, sizeof(info)) == sizeof(info)) {
+                scheduler.getMetrics().report();
+                scheduler.reportDispatch();
+            }
+        });
+    }
 
     // Create floor instance
-    Floor floor(scheduler, filename);
+    Floor floor(scheduler, filename, &reactor);
+    floor.setReplaySpeed(speed);
 
-    // Use a vector to store all the elevatorSubsystems, each with its own port
+    // The elevators run as coroutines on one worker per core and share one port,
+    // or with --thread-per-car each has its own thread and port
+    std::unique_ptr<ElevatorBank> bank;
     std::vector<std::unique_ptr<ElevatorSubsystem>> elevatorSubsystems;
-    std::vector<std::thread> elevatorSubsystemThreads;
-    
-    for (int i = 0; i < numElevators; i++) {
-        int port = ELEVATOR_PORT_BASE + i;
-        elevatorSubsystems.push_back(std::make_unique<ElevatorSubsystem>(scheduler, i, port));
-        elevatorSubsystemThreads.push_back(std::thread(&ElevatorSubsystem::run, elevatorSubsystems[i].get()));
+    if (threadPerCar) {
+        for (int i = 0; i < numElevators; i++) {
+            int port = ELEVATOR_PORT_BASE + i;
+            elevatorSubsystems.push_back(std::make_unique<ElevatorSubsystem>(scheduler, i, port));
+            elevatorSubsystems[i]->registerWith(reactor);
+        }
+    } else {
+        bank = std::make_unique<ElevatorBank>(scheduler, numElevators);
+        bank->registerWith(reactor);
     }
 
-    // Create scheduler and floor threads
-    std::thread schedulerThread(&Scheduler::run, &scheduler);
+    // Create event loop and floor threads
+    std::thread reactorThread(&Reactor::run, &reactor);
     std::thread floorThread(&Floor::run, &floor);
 
     // Wait for floor thread to complete
     floorThread.join();
 
-    // Wait for scheduler thread to complete
-    schedulerThread.join();
-    
-    // Wait for all elevator subsystem threads to complete
-    for (auto& thread : elevatorSubsystemThreads) {
-        if (thread.joinable()) {
-            thread.join();
-        }
-    }
+    // Wait for the event loop to complete
+    reactorThread.join();
     
     return 0;
-}
\ No newline at end of file
+}
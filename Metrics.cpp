@@ -0,0 +1,368 @@
+#include "Metrics.h"
+#include "Logger.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#define HISTOGRAM_HALF (1 << (HISTOGRAM_SUB_BITS - 1))
+#define HISTOGRAM_LARGEST ((int64_t(1) << HISTOGRAM_MAX_BITS) - 1)
+
+/**
+ * Constructor for the HdrHistogram class
+ */
+HdrHistogram::HdrHistogram() : total(0), sum(0), largest(0), negative(0) {
+    for (auto& bucket : counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Finds the bucket a value is counted in
+ * @param value The value, clamped to [0, 2^HISTOGRAM_MAX_BITS)
+ * @return The bucket index
+ */
+size_t HdrHistogram::bucketOf(int64_t value) {
+    value = std::min(std::max(value, int64_t(0)), HISTOGRAM_LARGEST);
+    if (value < (1 << HISTOGRAM_SUB_BITS)) {
+        return static_cast<size_t>(value);
+    }
+    // Keep the top HISTOGRAM_SUB_BITS bits of the value
+    int shift = (63 - __builtin_clzll(static_cast<uint64_t>(value))) - (HISTOGRAM_SUB_BITS - 1);
+    return static_cast<size_t>(shift) * HISTOGRAM_HALF + static_cast<size_t>(value >> shift);
+}
+
+/**
+ * Gets the largest value counted in a bucket
+ * @param bucket The bucket index
+ * @return The value
+ */
+int64_t HdrHistogram::highestInBucket(size_t bucket) {
+    if (bucket < (1 << HISTOGRAM_SUB_BITS)) {
+        return static_cast<int64_t>(bucket);
+    }
+    int shift = static_cast<int>(bucket / HISTOGRAM_HALF) - 1;
+    int64_t top = static_cast<int64_t>(bucket - static_cast<size_t>(shift) * HISTOGRAM_HALF);
+    return ((top + 1) << shift) - 1;
+}
+
+/**
+ * Counts one value
+ * @param value The value; negative values are left out and counted as errors
+ */
+void HdrHistogram::record(int64_t value) {
+    if (value < 0) {
+        negative.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    value = std::min(value, HISTOGRAM_LARGEST);
+    counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    int64_t seen = largest.load(std::memory_order_relaxed);
+    while (value > seen && !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+    total.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Counts every value recorded in another histogram
+ * @param other The histogram to merge in
+ */
+void HdrHistogram::add(const HdrHistogram& other) {
+    uint64_t added = 0;
+    for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        uint64_t n = other.counts[bucket].load(std::memory_order_relaxed);
+        if (n > 0) {
+            counts[bucket].fetch_add(n, std::memory_order_relaxed);
+            added += n;
+        }
+    }
+    sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    negative.fetch_add(other.negatives(), std::memory_order_relaxed);
+    int64_t value = other.maximum();
+    int64_t seen = largest.load(std::memory_order_relaxed);
+    while (value > seen && !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+    total.fetch_add(added, std::memory_order_release);
+}
+
+/**
+ * Gets the exact mean of the values recorded
+ * @return The mean, 0 if nothing was recorded
+ */
+double HdrHistogram::mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+}
+
+/**
+ * Gets the value at a percentile, rounded up to the end of its bucket
+ * @param percent The percentile, from 0 to 100
+ * @return The value, 0 if nothing was recorded
+ */
+int64_t HdrHistogram::percentile(double percent) const {
+    uint64_t n = total.load(std::memory_order_acquire);
+    if (n == 0) {
+        return 0;
+    }
+    // Rank of the value wanted, counting from 1
+    uint64_t rank = static_cast<uint64_t>(std::max(1.0, percent / 100.0 * n + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += counts[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(highestInBucket(bucket), maximum());
+        }
+    }
+    return maximum();
+}
+
+/**
+ * Writes the counts to a checkpoint, leaving out empty buckets
+ * @param out The checkpoint
+ */
+void HdrHistogram::save(CheckpointWriter& out) const {
+    std::vector<size_t> used;
+    for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        if (counts[bucket].load(std::memory_order_relaxed) > 0) used.push_back(bucket);
+    }
+    out.putInt(static_cast<int64_t>(used.size()));
+    for (size_t bucket : used) {
+        out.putInt(static_cast<int64_t>(bucket));
+        out.putInt(static_cast<int64_t>(counts[bucket].load(std::memory_order_relaxed)));
+    }
+    out.putInt(sum.load(std::memory_order_relaxed));
+    out.putInt(largest.load(std::memory_order_relaxed));
+    out.putInt(static_cast<int64_t>(negatives()));
+}
+
+/**
+ * Replaces the counts with ones saved by save
+ * @param in The checkpoint
+ */
+void HdrHistogram::restore(CheckpointReader& in) {
+    for (auto& bucket : counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    uint64_t restored = 0;
+    size_t used = in.getCount();
+    for (size_t i = 0; i < used; i++) {
+        int64_t bucket = in.getInt();
+        int64_t n = in.getInt();
+        if (bucket < 0 || bucket >= static_cast<int64_t>(HISTOGRAM_BUCKETS) || n < 0) {
+            throw std::runtime_error("checkpoint has a bad histogram bucket");
+        }
+        counts[bucket].store(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        restored += static_cast<uint64_t>(n);
+    }
+    sum.store(in.getInt(), std::memory_order_relaxed);
+    largest.store(in.getInt(), std::memory_order_relaxed);
+    negative.store(static_cast<uint64_t>(in.getInt()), std::memory_order_relaxed);
+    total.store(restored, std::memory_order_release);
+}
+
+/**
+ * Constructor for the PassengerMetrics class
+ * @param carCount The number of cars, of which the first METRICS_MAX_CARS get their own histograms
+ */
+PassengerMetrics::PassengerMetrics(int carCount)
+    : cars(std::min(std::max(carCount, 0), METRICS_MAX_CARS)), floorHistograms(new std::atomic<TripHistograms*>[METRICS_MAX_FLOORS]),
+      carHistograms(new std::atomic<TripHistograms*>[std::max(cars, 1)]), reassigned(0) {
+    for (int i = 0; i < METRICS_MAX_FLOORS; i++) {
+        floorHistograms[i].store(nullptr, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < std::max(cars, 1); i++) {
+        carHistograms[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructor frees the floor and car histograms
+ */
+PassengerMetrics::~PassengerMetrics() {
+    for (int i = 0; i < METRICS_MAX_FLOORS; i++) {
+        delete floorHistograms[i].load();
+    }
+    for (int i = 0; i < cars; i++) {
+        delete carHistograms[i].load();
+    }
+}
+
+/**
+ * Gets the histograms in a slot, creating them if this is the first trip for it.
+ * If two threads race, the loser frees its copy and uses the winner's.
+ * @param slot The floor or car slot
+ * @return The histograms
+ */
+PassengerMetrics::TripHistograms& PassengerMetrics::histogramsAt(std::atomic<TripHistograms*>& slot) {
+    TripHistograms* histograms = slot.load(std::memory_order_acquire);
+    if (histograms) {
+        return *histograms;
+    }
+    TripHistograms* created = new TripHistograms();
+    if (slot.compare_exchange_strong(histograms, created, std::memory_order_acq_rel)) {
+        return *created;
+    }
+    delete created;
+    return *histograms;
+}
+
+/**
+ * Adds a trip's times to a set of histograms
+ * @param histograms The histograms
+ * @param times When each step of the trip happened
+ */
+void PassengerMetrics::record(TripHistograms& histograms, const TripTimes& times) {
+    histograms.wait.record(times.arrivalMs - times.callMs);
+    histograms.ride.record(times.destinationMs - times.boardMs);
+    histograms.journey.record(times.destinationMs - times.callMs);
+}
+
+/**
+ * Records a finished trip
+ * @param car The car that served it
+ * @param floor The floor the hall call was made on
+ * @param times When each step happened
+ */
+void PassengerMetrics::recordTrip(int car, int floor, const TripTimes& times) {
+    record(overall, times);
+    if (floor >= 0 && floor < METRICS_MAX_FLOORS) {
+        record(histogramsAt(floorHistograms[floor]), times);
+    }
+    if (car >= 0 && car < cars) {
+        record(histogramsAt(carHistograms[car]), times);
+    }
+}
+
+/**
+ * Gets the histograms of trips called from a floor
+ * @param floor The floor
+ * @return The histograms, or null if no trip has started there
+ */
+const PassengerMetrics::TripHistograms* PassengerMetrics::getFloor(int floor) const {
+    if (floor < 0 || floor >= METRICS_MAX_FLOORS) {
+        return nullptr;
+    }
+    return floorHistograms[floor].load(std::memory_order_acquire);
+}
+
+/**
+ * Gets the histograms of trips served by a car
+ * @param car The car
+ * @return The histograms, or null if the car has not finished a trip
+ */
+const PassengerMetrics::TripHistograms* PassengerMetrics::getCar(int car) const {
+    if (car < 0 || car >= cars) {
+        return nullptr;
+    }
+    return carHistograms[car].load(std::memory_order_acquire);
+}
+
+namespace {
+
+/**
+ * Logs one line of a report: trip count, then mean and percentiles of each time in seconds
+ * @param scope What the line covers, such as "floor"
+ * @param index The floor or car number, -1 for none
+ * @param histograms The histograms
+ */
+void reportLine(const char* scope, int index, const PassengerMetrics::TripHistograms& histograms) {
+    auto seconds = [](int64_t ms) { return ms / 1000.0; };
+    const HdrHistogram* columns[3] = {&histograms.wait, &histograms.ride, &histograms.journey};
+    const char* names[3] = {"wait", "ride", "journey"};
+    LogLine line(LOG_LEVEL_INFO);
+    line << scope;
+    if (index >= 0) line << ' ' << index;
+    line << ": " << histograms.journey.count() << " trips";
+    for (int i = 0; i < 3; i++) {
+        const HdrHistogram& h = *columns[i];
+        line << ", " << names[i] << " avg " << h.mean() / 1000.0 << " p50 " << seconds(h.percentile(50))
+             << " p90 " << seconds(h.percentile(90)) << " p99 " << seconds(h.percentile(99))
+             << " max " << seconds(h.maximum());
+    }
+}
+
+} // namespace
+
+/**
+ * Logs a summary line for every trip, each floor and each car
+ */
+void PassengerMetrics::report() const {
+    uint64_t negative = overall.wait.negatives() + overall.ride.negatives() + overall.journey.negatives();
+    if (negative > 0) {
+        LOG_WARN(negative << " trip time(s) came out negative and were left out; the clocks disagree");
+    }
+    if (LOG_MIN_LEVEL > LOG_LEVEL_INFO || !Logger::enabled(LOG_LEVEL_INFO)) {
+        return;
+    }
+    LOG_INFO("Passenger metrics in seconds, " << overall.journey.count() << " trips finished, "
+             << getReassigned() << " handed back for another car");
+    reportLine("overall", -1, overall);
+    for (int floor = 0; floor < METRICS_MAX_FLOORS; floor++) {
+        if (const TripHistograms* histograms = getFloor(floor)) {
+            reportLine("floor", floor, *histograms);
+        }
+    }
+    for (int car = 0; car < cars; car++) {
+        if (const TripHistograms* histograms = getCar(car)) {
+            reportLine("car", car, *histograms);
+        }
+    }
+}
+
+/**
+ * Writes every histogram and the hand-back count to a checkpoint
+ * @param out The checkpoint
+ */
+void PassengerMetrics::save(CheckpointWriter& out) const {
+    auto saveTrips = [&out](const TripHistograms& histograms) {
+        histograms.wait.save(out);
+        histograms.ride.save(out);
+        histograms.journey.save(out);
+    };
+    auto saveSlots = [&](const std::atomic<TripHistograms*>* slots, int count) {
+        std::vector<int> present;
+        for (int i = 0; i < count; i++) {
+            if (slots[i].load(std::memory_order_acquire)) present.push_back(i);
+        }
+        out.putInt(static_cast<int64_t>(present.size()));
+        for (int i : present) {
+            out.putInt(i);
+            saveTrips(*slots[i].load(std::memory_order_acquire));
+        }
+    };
+    saveTrips(overall);
+    saveSlots(floorHistograms.get(), METRICS_MAX_FLOORS);
+    saveSlots(carHistograms.get(), cars);
+    out.putInt(static_cast<int64_t>(reassigned.load(std::memory_order_relaxed)));
+}
+
+/**
+ * Replaces every histogram and the hand-back count with ones saved by save
+ * @param in The checkpoint
+ */
+void PassengerMetrics::restore(CheckpointReader& in) {
+    auto restoreTrips = [&in](TripHistograms& histograms) {
+        histograms.wait.restore(in);
+        histograms.ride.restore(in);
+        histograms.journey.restore(in);
+    };
+    auto restoreSlots = [&](std::atomic<TripHistograms*>* slots, int count) {
+        // Floors and cars without trips in the checkpoint start again without histograms
+        for (int i = 0; i < count; i++) {
+            delete slots[i].exchange(nullptr);
+        }
+        size_t present = in.getCount();
+        for (size_t n = 0; n < present; n++) {
+            int64_t i = in.getInt();
+            if (i < 0 || i >= count) {
+                throw std::runtime_error("checkpoint has trips for a floor or car out of range");
+            }
+            restoreTrips(histogramsAt(slots[i]));
+        }
+    };
+    restoreTrips(overall);
+    restoreSlots(floorHistograms.get(), METRICS_MAX_FLOORS);
+    restoreSlots(carHistograms.get(), cars);
+    reassigned.store(static_cast<uint64_t>(in.getInt()), std::memory_order_relaxed);
+}
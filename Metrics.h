@@ -0,0 +1,215 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#define HISTOGRAM_SUB_BITS 7        // 128 sub-buckets per power of two, under 1% error
+#define HISTOGRAM_MAX_BITS 32       // Largest value kept is 2^32 - 1, larger ones are clamped
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) << (HISTOGRAM_SUB_BITS - 1))
+#define METRICS_MAX_FLOORS 256      // Floors given their own histograms; all floors count overall
+#define METRICS_MAX_CARS 256        // Cars given their own histograms; all cars count overall
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/**
+ * High dynamic range histogram of non-negative values. Values below 2^HISTOGRAM_SUB_BITS
+ * are counted exactly and larger ones in log-linear buckets, so every percentile is within
+ * 1% of the true value. Recording is a few relaxed atomic adds and never locks, so any
+ * number of threads can record into the same histogram while another reads it.
+ */
+class HdrHistogram {
+private:
+    std::atomic<uint64_t> counts[HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<int64_t> sum;
+    std::atomic<int64_t> largest;
+    std::atomic<uint64_t> negative;     // Negative values given to record, which are not counted
+
+public:
+    HdrHistogram();
+
+    HdrHistogram(const HdrHistogram&) = delete;
+    HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+    /**
+     * Finds the bucket a value is counted in
+     * @param value The value, clamped to [0, 2^HISTOGRAM_MAX_BITS)
+     * @return The bucket index
+     */
+    static size_t bucketOf(int64_t value);
+
+    /**
+     * Gets the largest value counted in a bucket
+     * @param bucket The bucket index
+     * @return The value
+     */
+    static int64_t highestInBucket(size_t bucket);
+
+    /**
+     * Counts one value
+     * @param value The value; a negative value is a timing error, so it is left out and
+     *              counted by negatives() instead
+     */
+    void record(int64_t value);
+
+    /**
+     * Counts every value recorded in another histogram, as if each had been recorded here
+     * @param other The histogram to merge in; it may still be recording
+     */
+    void add(const HdrHistogram& other);
+
+    /**
+     * Gets the number of values recorded
+     * @return The count
+     */
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+    /**
+     * Gets the number of negative values that were left out
+     * @return The count
+     */
+    uint64_t negatives() const { return negative.load(std::memory_order_relaxed); }
+
+    /**
+     * Gets the exact mean of the values recorded
+     * @return The mean, 0 if nothing was recorded
+     */
+    double mean() const;
+
+    /**
+     * Gets the exact largest value recorded
+     * @return The value, 0 if nothing was recorded
+     */
+    int64_t maximum() const { return largest.load(std::memory_order_relaxed); }
+
+    /**
+     * Gets the value at a percentile, rounded up to the end of its bucket
+     * @param percent The percentile, from 0 to 100
+     * @return The value, 0 if nothing was recorded
+     */
+    int64_t percentile(double percent) const;
+
+    /**
+     * Writes the counts to a checkpoint, leaving out empty buckets
+     * @param out The checkpoint
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * Replaces the counts with ones saved by save. Nothing may record while this runs.
+     * @param in The checkpoint
+     */
+    void restore(CheckpointReader& in);
+};
+
+/**
+ * When each step of a passenger's trip happened, in milliseconds on the driving clock
+ */
+struct TripTimes {
+    long long callMs = -1;          // Hall button pressed, as stamped on the event by the floor or scheduler
+    long long arrivalMs = -1;       // Car reached the caller's floor
+    long long boardMs = -1;         // Passenger on board
+    long long destinationMs = -1;   // Car reached the passenger's destination
+};
+
+/**
+ * Wait, ride and journey times of finished trips, kept overall, per origin floor and per car.
+ * Waiting time is from the hall call until the car reaches the caller, ride time from
+ * boarding until the car reaches the destination, and journey time from the hall call until
+ * the car reaches the destination. Recording never locks; the histograms for a floor or car
+ * are created the first time a trip needs them.
+ */
+class PassengerMetrics {
+public:
+    struct TripHistograms {
+        HdrHistogram wait;
+        HdrHistogram ride;
+        HdrHistogram journey;
+    };
+
+    /**
+     * Constructor for the PassengerMetrics class
+     * @param carCount The number of cars, of which the first METRICS_MAX_CARS get their own histograms
+     */
+    explicit PassengerMetrics(int carCount);
+
+    ~PassengerMetrics();
+
+    PassengerMetrics(const PassengerMetrics&) = delete;
+    PassengerMetrics& operator=(const PassengerMetrics&) = delete;
+
+    /**
+     * Records a finished trip
+     * @param car The car that served it
+     * @param floor The floor the hall call was made on
+     * @param times When each step happened
+     */
+    void recordTrip(int car, int floor, const TripTimes& times);
+
+    /**
+     * Counts a waiting request handed back for another car, after its car went out of
+     * service or came by too full to board it. The caller's wait still runs from their
+     * button press until the new car arrives.
+     */
+    void recordReassigned() { reassigned.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * Gets the histograms of every trip
+     * @return The histograms
+     */
+    const TripHistograms& getOverall() const { return overall; }
+
+    /**
+     * Gets the histograms of trips called from a floor
+     * @param floor The floor
+     * @return The histograms, or null if no trip has started there
+     */
+    const TripHistograms* getFloor(int floor) const;
+
+    /**
+     * Gets the histograms of trips served by a car
+     * @param car The car
+     * @return The histograms, or null if the car has not finished a trip
+     */
+    const TripHistograms* getCar(int car) const;
+
+    /**
+     * Gets the number of requests handed back for another car
+     * @return The count
+     */
+    uint64_t getReassigned() const { return reassigned.load(std::memory_order_relaxed); }
+
+    /**
+     * Logs a summary line for every trip, each floor and each car
+     */
+    void report() const;
+
+    /**
+     * Writes every histogram and the hand-back count to a checkpoint
+     * @param out The checkpoint
+     */
+    void save(CheckpointWriter& out) const;
+
+    /**
+     * Replaces every histogram and the hand-back count with ones saved by save.
+     * Nothing may record while this runs.
+     * @param in The checkpoint
+     */
+    void restore(CheckpointReader& in);
+
+private:
+    TripHistograms overall;
+    int cars;
+    std::unique_ptr<std::atomic<TripHistograms*>[]> floorHistograms;
+    std::unique_ptr<std::atomic<TripHistograms*>[]> carHistograms;
+    std::atomic<uint64_t> reassigned;
+
+    static TripHistograms& histogramsAt(std::atomic<TripHistograms*>& slot);
+    static void record(TripHistograms& histograms, const TripTimes& times);
+};
+
+#endif // METRICS_H
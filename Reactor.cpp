@@ -0,0 +1,218 @@
+#include "Reactor.h"
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define REACTOR_MAX_EVENTS 64
+
+/**
+ * Constructor for the Reactor class
+ */
+Reactor::Reactor()
+    : epollFd(epoll_create1(EPOLL_CLOEXEC)), wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+      started(std::chrono::steady_clock::now()), nextTimerId(1) {
+    if (epollFd < 0 || wakeFd < 0 || timerFd < 0) {
+        throw std::runtime_error(std::string("reactor creation failed: ") + strerror(errno));
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    // Every timer is run from here when the wheel's next expiry comes round
+    watch(timerFd, [this]() {
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        wheel.advance(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+        armTimerFd();
+    }, true);
+}
+
+/**
+ * Destructor closes the epoll descriptor, the eventfd and the timerfd
+ */
+Reactor::~Reactor() {
+    for (auto& entry : registrations) {
+        if (entry.second->isTimer) {
+            close(entry.first);
+        }
+    }
+    close(wakeFd);
+    close(epollFd);
+}
+
+/**
+ * Adds a descriptor to the epoll set
+ * @param fd The descriptor
+ * @param handler The work to run when it is ready
+ * @param isTimer Whether the descriptor is a timerfd
+ */
+void Reactor::watch(int fd, std::function<void()> handler, bool isTimer) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+    registrations[fd] = std::make_shared<Registration>(Registration{std::move(handler), isTimer});
+}
+
+/**
+ * Calls the handler each time the descriptor has data to read
+ * @param fd The descriptor to watch
+ * @param handler The work to run on the reactor thread
+ */
+void Reactor::addReadable(int fd, std::function<void()> handler) {
+    watch(fd, std::move(handler), false);
+}
+
+/**
+ * Stops watching a descriptor added with addReadable
+ * @param fd The descriptor
+ */
+void Reactor::remove(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    registrations.erase(fd);
+}
+
+/**
+ * Creates a timer that calls the handler after a delay
+ * @param delayMs Milliseconds until the first expiry
+ * @param intervalMs Milliseconds between later expiries, 0 for a one-shot timer
+ * @param handler The work to run on the reactor thread
+ * @return An id for rearmTimer and cancelTimer
+ */
+int Reactor::addTimer(long long delayMs, long long intervalMs, std::function<void()> handler) {
+    int timerId = nextTimerId++;
+    timers[timerId] = Timer{std::make_shared<std::function<void()>>(std::move(handler)), intervalMs, 0};
+    rearmTimer(timerId, delayMs);
+    return timerId;
+}
+
+/**
+ * Sets a timer to fire once more after a delay, keeping its interval
+ * @param timerId The id returned by addTimer
+ * @param delayMs Milliseconds until the expiry
+ */
+void Reactor::rearmTimer(int timerId, long long delayMs) {
+    auto found = timers.find(timerId);
+    if (found == timers.end()) {
+        return;
+    }
+    wheel.cancel(found->second.wheelId);
+    found->second.wheelId = wheel.scheduleAt(dueAfter(delayMs), [this, timerId]() { fireTimer(timerId); });
+    armTimerFd();
+}
+
+/**
+ * Stops and releases a timer
+ * @param timerId The id returned by addTimer
+ */
+void Reactor::cancelTimer(int timerId) {
+    auto found = timers.find(timerId);
+    if (found == timers.end()) {
+        return;
+    }
+    wheel.cancel(found->second.wheelId);
+    timers.erase(found);
+}
+
+/**
+ * Runs a timer's handler, first setting up its next expiry if it repeats
+ * @param timerId The timer
+ */
+void Reactor::fireTimer(int timerId) {
+    auto found = timers.find(timerId);
+    if (found == timers.end()) {
+        return;
+    }
+    Timer& timer = found->second;
+    timer.wheelId = 0;
+    if (timer.intervalMs > 0) {
+        // From when it was due, so a late expiry does not push the rest back
+        timer.wheelId = wheel.schedule(timer.intervalMs, [this, timerId]() { fireTimer(timerId); });
+    }
+    // Held so the handler can cancel its own timer
+    std::shared_ptr<std::function<void()>> handler = timer.handler;
+    (*handler)();
+}
+
+/**
+ * Converts a delay to the wheel tick it ends on, rounded up so a timer never fires early
+ * @param delayMs Milliseconds from now; 0 or less is due on the next loop
+ * @return The tick
+ */
+long long Reactor::dueAfter(long long delayMs) const {
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    if (delayMs <= 0) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    }
+    long long elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    return (elapsedUs + delayMs * 1000 + 999) / 1000;
+}
+
+/**
+ * Sets the timerfd to go off at the wheel's next expiry, or disarms it if nothing is pending
+ */
+void Reactor::armTimerFd() {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    long long next = wheel.nextExpiry();
+    if (next >= 0) {
+        auto due = started + std::chrono::milliseconds(next);
+        long long delayNs = std::chrono::duration_cast<std::chrono::nanoseconds>(due - std::chrono::steady_clock::now()).count();
+        // A zero it_value disarms a timerfd, so "now" is one nanosecond away
+        delayNs = delayNs > 0 ? delayNs : 1;
+        spec.it_value.tv_sec = delayNs / 1000000000;
+        spec.it_value.tv_nsec = delayNs % 1000000000;
+    }
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+/**
+ * Waits for ready descriptors and runs their handlers until stop() is called
+ */
+void Reactor::run() {
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    while (!stopped) {
+        int ready = epoll_wait(epollFd, events, REACTOR_MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("epoll_wait failed: ") + strerror(errno));
+        }
+        for (int i = 0; i < ready && !stopped; i++) {
+            int fd = events[i].data.fd;
+            auto found = registrations.find(fd);
+            if (found == registrations.end()) {
+                continue; // Wake-up, or removed by an earlier handler
+            }
+            // Hold the registration so a handler can remove itself safely
+            std::shared_ptr<Registration> registration = found->second;
+            if (registration->isTimer) {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) < 0) {
+                    continue; // Already cleared by a rearm
+                }
+            }
+            registration->handler();
+        }
+    }
+}
+
+/**
+ * Makes run() return. Safe to call from any thread.
+ */
+void Reactor::stop() {
+    stopped = true;
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
@@ -0,0 +1,111 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include "TimingWheel.h"
+
+/**
+ * Event loop built on epoll. Sockets and timers register a handler that runs on the
+ * reactor thread as soon as they become ready, so no subsystem has to poll or sleep.
+ * Timers are kept in a timing wheel behind a single timerfd, armed for the wheel's next
+ * expiry, and stop() wakes the loop through an eventfd.
+ *
+ * Handlers are added and removed from the reactor thread, or before run() is called.
+ * stop() may be called from any thread.
+ */
+class Reactor {
+private:
+    struct Registration {
+        std::function<void()> handler;  // Work to run when the descriptor is ready
+        bool isTimer;                   // Timer descriptors are read to clear their expiry count
+    };
+
+    struct Timer {
+        std::shared_ptr<std::function<void()>> handler;
+        long long intervalMs;           // 0 for a one-shot timer
+        TimingWheel::TimerId wheelId;   // Pending expiry, 0 when not armed
+    };
+
+    int epollFd;
+    int wakeFd;                          // eventfd written by stop()
+    int timerFd;                         // Goes off when the wheel has work
+    std::atomic<bool> stopped{false};
+    std::map<int, std::shared_ptr<Registration>> registrations;
+    TimingWheel wheel;                   // In milliseconds since the reactor was created
+    std::chrono::steady_clock::time_point started;
+    std::map<int, Timer> timers;
+    int nextTimerId;
+
+    void watch(int fd, std::function<void()> handler, bool isTimer);
+    void fireTimer(int timerId);
+    void armTimerFd();
+    long long dueAfter(long long delayMs) const;
+
+public:
+    /**
+     * Constructor for the Reactor class
+     */
+    Reactor();
+
+    /**
+     * Destructor closes the epoll descriptor, the eventfd and the timerfd
+     */
+    ~Reactor();
+
+    /**
+     * Calls the handler each time the descriptor has data to read
+     * @param fd The descriptor to watch, usually a socket
+     * @param handler The work to run on the reactor thread
+     */
+    void addReadable(int fd, std::function<void()> handler);
+
+    /**
+     * Stops watching a descriptor added with addReadable
+     * @param fd The descriptor
+     */
+    void remove(int fd);
+
+    /**
+     * Creates a timer that calls the handler after a delay
+     * @param delayMs Milliseconds until the first expiry, 0 fires on the next loop
+     * @param intervalMs Milliseconds between later expiries, 0 for a one-shot timer
+     * @param handler The work to run on the reactor thread
+     * @return An id for rearmTimer and cancelTimer
+     */
+    int addTimer(long long delayMs, long long intervalMs, std::function<void()> handler);
+
+    /**
+     * Sets a timer to fire once more after a delay
+     * @param timerId The id returned by addTimer
+     * @param delayMs Milliseconds until the expiry, 0 fires on the next loop
+     */
+    void rearmTimer(int timerId, long long delayMs);
+
+    /**
+     * Stops and releases a timer
+     * @param timerId The id returned by addTimer
+     */
+    void cancelTimer(int timerId);
+
+    /**
+     * Waits for ready descriptors and runs their handlers until stop() is called
+     */
+    void run();
+
+    /**
+     * Makes run() return. Safe to call from any thread.
+     */
+    void stop();
+
+    /**
+     * Checks if the reactor has been stopped
+     * @return True if stop() has been called
+     */
+    bool isStopped() const { return stopped; }
+};
+
+#endif // REACTOR_H
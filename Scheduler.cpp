@@ -1,24 +1,38 @@
 #include "Scheduler.h"
+#include "Logger.h"
 #include <chrono>
 #include <thread>
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+
+namespace {
+
+long long steadyMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
 
 /**
  * Constructor for the Scheduler class
  * @param elevatorCount The number of elevators in the system
+ * @param networked Whether to open the scheduler endpoint (false for in-process simulation)
+ * @param transport How the subsystems talk to each other; null sends UDP datagrams
  */
-Scheduler::Scheduler(int elevatorCount) 
-    : floorMtx(), elevatorMtx(), stateMtx(), elevatorInfoMtx(),
+Scheduler::Scheduler(int elevatorCount, bool networked, Transport* transport) 
+    : ownedTransport(transport ? nullptr : new UdpTransport()), transport(transport ? transport : ownedTransport.get()),
+      floorMtx(), elevatorMtx(), stateMtx(), elevatorInfoMtx(),
       floorCV(), elevatorCV(), 
-      receiveSocket(SCHEDULER_PORT), floorSendSocket(), elevatorSendSocket(),
-      numElevators(elevatorCount) {
-    
-    // Initialize elevator info map
-    // Using 0-based indexing to be consistent with the ElevatorSubsystem
-    for (int i = 0; i < numElevators; ++i) {
-        elevatorInfoMap[i] = {i, 1, elevatorState::ELEVATOR_REST, 0, 0, false}; // Start at floor 1
+      numElevators(elevatorCount), fleet(elevatorCount), scores(elevatorCount), etas(elevatorCount), metrics(elevatorCount) {
+    // Cars use 0-based ids to be consistent with the ElevatorSubsystem, and start at floor 1
+    if (networked) {
+        // The floor and every elevator send here
+        endpoint = this->transport->open(SCHEDULER_PORT, SENDERS_MANY);
     }
 }
 
@@ -27,10 +41,84 @@ void Scheduler::updateState(schedulerState newState) {
     state = newState;
 }
 
+/**
+ * Takes a car out of service after a fault
+ * @param elevatorId The car
+ */
 void Scheduler::removeElevator(int elevatorId) {
-    std::unique_lock<std::mutex> lock(stateMtx);
-    elevatorInfoMap.erase(elevatorId);
-    removedElevators.push_back(elevatorId);
+    std::unique_lock<std::mutex> lock(elevatorInfoMtx);
+    if (journal) journal->record(JOURNAL_REMOVE, elevatorId);
+    fleet.remove(elevatorId);
+    fleet.stops[elevatorId].pickups.clear();
+    refreshCar(elevatorId);
+}
+
+/**
+ * Takes a hall call off a car that could not board the caller
+ * @param elevatorId The car
+ * @param event The floor request
+ */
+void Scheduler::releaseCall(int elevatorId, const Event& event) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    if (journal) journal->record(JOURNAL_RELEASE, elevatorId, &event);
+    if (elevatorId < 0 || elevatorId >= fleet.size()) {
+        return;
+    }
+    int originFloor = std::stoi(event.source);
+    Direction direction = Itinerary::travelDirection(originFloor, event.elevatorButton, event.direction());
+    std::vector<Itinerary::Pickup>& pickups = fleet.stops[elevatorId].pickups;
+    auto pickup = std::find_if(pickups.begin(), pickups.end(), [&](const Itinerary::Pickup& waiting) {
+        return waiting.origin == originFloor && waiting.destination == event.elevatorButton
+            && waiting.direction == direction;
+    });
+    if (pickup != pickups.end()) {
+        pickups.erase(pickup);
+    }
+    refreshCar(elevatorId);
+}
+
+/**
+ * Returns a recovered car to service
+ * @param elevatorId The car
+ */
+void Scheduler::restoreElevator(int elevatorId) {
+    std::unique_lock<std::mutex> lock(elevatorInfoMtx);
+    if (journal) journal->record(JOURNAL_RESTORE, elevatorId);
+    fleet.restore(elevatorId);
+    fleet.state[elevatorId] = elevatorState::ELEVATOR_REST;
+    fleet.moving[elevatorId] = 0;
+    refreshCar(elevatorId);
+}
+
+/**
+ * Get the list of elevators out of service, read from the fleet's liveness bitset
+ * @return The removed elevators in id order
+ */
+std::vector<int> Scheduler::getRemovedElevators() {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    std::vector<int> removed;
+    for (int car = 0; car < fleet.size(); car++) {
+        if (!fleet.isLive(car)) {
+            removed.push_back(car);
+        }
+    }
+    return removed;
+}
+
+/**
+ * Get the information map of the elevators in service
+ * @return  The infomap of the elevator
+ */
+std::map<int, Scheduler::ElevatorInfo> Scheduler::getInfoMap() {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    std::map<int, ElevatorInfo> infoMap;
+    for (int i = 0; i < fleet.size(); i++) {
+        if (fleet.isLive(i)) {
+            infoMap[i] = {i, fleet.currentFloor[i], static_cast<elevatorState>(fleet.state[i]), fleet.passengers[i],
+                          fleet.totalPassengers[i], fleet.busy[i] != 0, fleet.stops[i], fleet.sweep[i], fleet.moving[i] != 0};
+        }
+    }
+    return infoMap;
 }
 
 /**
@@ -42,159 +130,583 @@ schedulerState Scheduler::getState() const {
 }
 
 void Scheduler::sendToFloor(const Event& event) {
+    if (journal) journal->record(JOURNAL_SEND, FLOOR_PORT, &event);
     try {
-        std::vector<uint8_t> data = event.event_to_bytes();
-        DatagramPacket packet(data, data.size(), InetAddress::getLocalHost(), FLOOR_PORT);
-        floorSendSocket.send(packet);
-        std::cout << "Sent message to floor" << std::endl;
+        endpoint->send(FLOOR_PORT, event);
+        endpoint->flush();
+        LOG_INFO("Sent message to floor");
     } catch (const std::exception& e) {
-        std::cerr << "Error sending to floor: " << e.what() << std::endl;
+        LOG_ERROR("Error sending to floor: " << e.what());
     }
 }
 
 void Scheduler::sendToElevator(const Event& event) {
     try {
         // Calculate the correct port for the assigned elevator
-        int elevatorPort = ELEVATOR_PORT_BASE + event.assignedElevator; // This works because the ports have a "Base + offset which is the id"
-        
-        std::vector<uint8_t> data = event.event_to_bytes();
-        DatagramPacket packet(data, data.size(), InetAddress::getLocalHost(), elevatorPort);
-        elevatorSendSocket.send(packet);
-        std::cout << "Sent message to elevator " << event.assignedElevator 
-                  << " on port " << elevatorPort << std::endl;
+        int elevatorPort = elevatorAddress(event.assignedElevator);
+        if (journal) journal->record(JOURNAL_SEND, elevatorPort, &event);
+
+        endpoint->send(elevatorPort, event);
+        endpoint->flush();
+        LOG_INFO("Sent message to elevator " << event.assignedElevator 
+                  << " on port " << elevatorPort);
     } catch (const std::exception& e) {
-        std::cerr << "Error sending to elevator: " << e.what() << std::endl;
+        LOG_ERROR("Error sending to elevator: " << e.what());
     }
 }
 
 bool Scheduler::receiveEvent(Event& event) {
     try {
-        std::vector<uint8_t> data(100);
-        DatagramPacket packet(data, data.size());
-        
         //because there are no more events left to receive
         if (done) return false;
-        
-        // Receive the packet
-        receiveSocket.receive(packet);
-        
-        // Deserialize the event
-        event = Event::bytes_to_event(data);
+
+        // Wait for the endpoint unless events are left from the last receive
+        while (inboundNext == inbound.size()) {
+            struct pollfd ready = {endpoint->fd(), POLLIN, 0};
+            if (poll(&ready, 1, -1) < 0 && errno != EINTR) {
+                throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+            }
+            endpoint->receive(inbound);
+            inboundNext = 0;
+        }
+        event = std::move(inbound[inboundNext++]);
 
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error receiving event: " << e.what() << std::endl;
+        LOG_ERROR("Error receiving event: " << e.what());
         return false;
     }
 }
 
-void Scheduler::updateElevatorInfo(const Event& event) {
+void Scheduler::updateElevatorInfo(const Event& event, long long nowMs) {
     std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    if (journal) journal->record(JOURNAL_UPDATE, 0, &event, nowMs);
     
     int elevatorId = event.assignedElevator; //Get associated ID
+    if (elevatorId < 0 || elevatorId >= fleet.size()) {
+        return;
+    }
+    etas.setReportTime(elevatorId, nowMs);
  
     // Update the elevator's current floor
-    elevatorInfoMap[elevatorId].currentFloor = event.currentFloor;
+    fleet.currentFloor[elevatorId] = event.currentFloor;
     
     // Update passengers 
     if (event.riders >= 0) {
-        elevatorInfoMap[elevatorId].passengers = event.riders;
+        fleet.passengers[elevatorId] = event.riders;
     }
     
     // Determine elevator direction based on the floorButton field
     if (event.floorButton == "UP") {
-        elevatorInfoMap[elevatorId].state = elevatorState::ELEVATOR_MOVING_UP;
+        fleet.state[elevatorId] = elevatorState::ELEVATOR_MOVING_UP;
     } else if (event.floorButton == "DOWN") {
-        elevatorInfoMap[elevatorId].state = elevatorState::ELEVATOR_MOVING_DOWN;
+        fleet.state[elevatorId] = elevatorState::ELEVATOR_MOVING_DOWN;
     } else if (event.floorButton.empty() && event.source.find("Elevator:") != std::string::npos) {
         // when no direction given, assume it's at REST
-        elevatorInfoMap[elevatorId].state = elevatorState::ELEVATOR_REST;
+        fleet.state[elevatorId] = elevatorState::ELEVATOR_REST;
     }
     
     // MARK ELEVATOR AS NOT BUSY IF THE REQUEST IS COMPLETE
-    if (event.isComplete) { elevatorInfoMap[elevatorId].isBusy = false;}
-    
+    if (event.isComplete) { fleet.busy[elevatorId] = 0;}
+
+    // Follow the car through its committed stops, serving them the way the car does
+    Itinerary& stops = fleet.stops[elevatorId];
+    Direction& sweep = fleet.sweep[elevatorId];
+    if (event.isComplete) {
+        // The passenger got off
+        std::vector<int>& dropoffs = stops.dropoffs;
+        auto dropoff = std::find(dropoffs.begin(), dropoffs.end(), event.elevatorButton);
+        if (dropoff != dropoffs.end()) {
+            dropoffs.erase(dropoff);
+        }
+    } else if (event.floorButton == "UP" || event.floorButton == "DOWN") {
+        // Leaving a floor: anyone going this way there has boarded
+        sweep = (event.floorButton == "UP") ? Direction::DIRECTION_UP : Direction::DIRECTION_DOWN;
+        fleet.moving[elevatorId] = 1;
+        Direction leaving = sweep;
+        stops.serve(event.currentFloor, leaving);
+    } else if (event.floorButton.empty() && event.source.find("Elevator:") != std::string::npos) {
+        // Arrived at a stop
+        fleet.moving[elevatorId] = 0;
+        stops.serve(event.currentFloor, sweep);
+    }
+    if (stops.empty()) {
+        sweep = Direction::DIRECTION_IDLE;
+    }
+    refreshCar(elevatorId);
 }
 
-int Scheduler::assignOptimalElevator(const Event& event) {
+/**
+ * Finds the hall call a car arriving at a floor is there to answer: the floor's call for
+ * the way the car leaves, if it is the car answering that call
+ * @param elevatorId The car
+ * @param floor The floor it arrived at
+ * @return The direction of the call, or DIRECTION_IDLE if the car answers neither
+ */
+Direction Scheduler::answeredAt(int elevatorId, int floor) {
     std::lock_guard<std::mutex> lock(elevatorInfoMtx);
-    
+    if (elevatorId < 0 || elevatorId >= fleet.size()) {
+        return DIRECTION_IDLE;
+    }
+    Direction leaving = fleet.sweep[elevatorId];
+    auto answered = answeringCars.find({floor, leaving});
+    return (answered != answeringCars.end() && answered->second == elevatorId) ? leaving : DIRECTION_IDLE;
+}
+
+/**
+ * Chooses how hall calls are assigned to elevators
+ * @param newPolicy The dispatch policy
+ */
+void Scheduler::setDispatchPolicy(DispatchPolicy newPolicy) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    policy = newPolicy;
+    if (journal) journal->record(JOURNAL_POLICY, policy);
+    // Routes are not kept under the other policies, so they are rebuilt on switching
+    for (int i = 0; i < numElevators; i++) {
+        refreshCar(i);
+    }
+}
+
+/**
+ * Holds hall calls for a window and assigns them together instead of one at a time
+ * @param windowMs Milliseconds to collect calls for, 0 to assign each as it arrives
+ */
+void Scheduler::setBatchWindow(int windowMs) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    batchWindowMs = std::max(windowMs, 0);
+    if (journal) journal->record(JOURNAL_BATCH_WINDOW, batchWindowMs);
+}
+
+/**
+ * Records everything the scheduler takes in and sends, and every assignment it makes
+ * @param newJournal The journal to append to, or null to stop recording
+ */
+void Scheduler::setJournal(Journal* newJournal) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    journal = newJournal;
+    if (journal) {
+        // The settings come first so a replay starts from the same scheduler
+        journal->record(JOURNAL_CARS, numElevators);
+        journal->record(JOURNAL_POLICY, policy);
+        journal->record(JOURNAL_BATCH_WINDOW, batchWindowMs);
+    }
+}
+
+/**
+ * Brings a car's load and timed route up to date after its stops or position changed
+ * @param elevatorId The car
+ */
+void Scheduler::refreshCar(int elevatorId) {
+    fleet.load[elevatorId] = fleet.stops[elevatorId].load();
+    if (policy == DispatchPolicy::DISPATCH_ETA) {
+        etas.update(elevatorId, fleet.stops[elevatorId], fleet.currentFloor[elevatorId], fleet.sweep[elevatorId],
+                    fleet.moving[elevatorId] != 0);
+    }
+}
+
+/**
+ * Scores every elevator by distance, direction and whether it is busy, in one pass over the fleet
+ * @param event The floor request
+ * @return The elevator with the lowest score, or -1 if none is in service
+ */
+int Scheduler::assignByHeuristic(const Event& event) {
     // Parse request details
     int originFloor = std::stoi(event.source);
-    bool isGoingUp = (event.floorButton == "UP");
-    
-    // Find the best elevator for this request
+    bool isGoingUp = (event.direction() == Direction::DIRECTION_UP);
+
+    fleet.scoreHeuristic(originFloor, isGoingUp, scores.data());
+    if (numElevators <= SCORE_LOG_LIMIT && Logger::enabled(LOG_LEVEL_DEBUG)) {
+        for (int i = 0; i < numElevators; i++) {
+            if (fleet.isLive(i)) {
+                LOG_DEBUG("  Elevator " << i << " score: " << scores[i]);
+            }
+        }
+    }
+    return fleet.lowestScore(scores.data());
+}
+
+/**
+ * Collective control: the call goes to the car that reaches it soonest while travelling
+ * the caller's way, following the car's committed stops in LOOK order. A car sweeping
+ * past the call in the right direction picks it up on the way; any other car only gets
+ * it after serving what it already has and turning around.
+ * @param event The floor request
+ * @return The elevator with the lowest cost, or -1 if none is in service
+ */
+int Scheduler::assignByLook(const Event& event) {
+    int originFloor = std::stoi(event.source);
+    Itinerary::Pickup call{originFloor, event.elevatorButton,
+                           Itinerary::travelDirection(originFloor, event.elevatorButton, event.direction())};
+
     int bestElevator = -1;
-    int bestScore = 1000000000; // A very big number
-    
+    int bestCost = std::numeric_limits<int>::max();
+    bool bestFull = true;
     for (int i = 0; i < numElevators; i++) {
-        if (std::find(removedElevators.begin(), removedElevators.end(), i) != removedElevators.end()) {
+        if (!fleet.isLive(i)) {
             continue;
         }
-        auto& info = elevatorInfoMap[i];
-        
-        // Calculate a score for this elevator (lower is better)
-        int score = 1000;  // Base score
-        
-        // Add a lot of points if the elevator is in use, makes it unlikely to be chosen to service a request
-        if (info.isBusy) {
-            score += 5000; 
+        int cost = lookCost(i, call);
+        bool full = fleet.isFull(i);
+        if (numElevators <= SCORE_LOG_LIMIT) {
+            LOG_DEBUG("  Elevator " << i << " cost: " << cost << (full ? " (full)" : ""));
         }
-      
-        // Check position relative to request
-        int distance = abs(info.currentFloor - originFloor);
-        score += distance * 10;  // weighted calculation for the score, the further it is the worse
-        
-        bool elevatorGoingUp = (info.state == elevatorState::ELEVATOR_MOVING_UP);
-        bool elevatorGoingDown = (info.state == elevatorState::ELEVATOR_MOVING_DOWN);
-        bool elevatorAtRest = (info.state == elevatorState::ELEVATOR_REST || info.state == elevatorState::ELEVATOR_DOOR_OPEN || info.state == elevatorState::ELEVATOR_DOOR_CLOSE);
-        
-        // change the score based on the elevator's direction
-        if (isGoingUp) {
-            if (elevatorGoingUp && info.currentFloor <= originFloor) { // if passenger going up and elevator is below him and going up 
-                score -= 500;
-            }
-            else if (elevatorAtRest) {// Elevator at rest can be used
-                score -= 300;
-            }
-        } 
-        else {
-            // Passenger going DOWN - elevators above are good
-            if (elevatorGoingDown && info.currentFloor >= originFloor) { // if passenger is going down and there's an elevator above him and going down
-                score -= 500;
-            }
-            else if (info.currentFloor > originFloor) {// ANY elevator above the passenger going down gets priority
-                score -= 400;
-            }
-            else if (elevatorAtRest) {
-                // Elevator at rest can be used
-                score -= 300;
-            }
+        // A full car only gets the call when every car is full
+        if (full != bestFull ? !full : cost < bestCost) {
+            bestCost = cost;
+            bestElevator = i;
+            bestFull = full;
+        }
+    }
+    return bestElevator;
+}
+
+/**
+ * Gives the call to the car that can reach it soonest, counting the delay its stop adds
+ * for the passengers the car already has. Each estimate follows the car's committed stops
+ * with their travel, door and transfer times, read from the routes the ETA model keeps
+ * instead of being worked out again for every call.
+ * @param event The floor request
+ * @param nowMs The current time on the driving clock, to take off what the cars have travelled since they reported
+ * @return The elevator with the lowest cost, or -1 if none is in service
+ */
+int Scheduler::assignByEta(const Event& event, long long nowMs) {
+    int originFloor = std::stoi(event.source);
+    Itinerary::Pickup call{originFloor, event.elevatorButton,
+                           Itinerary::travelDirection(originFloor, event.elevatorButton, event.direction())};
+
+    int bestElevator = -1;
+    int64_t bestCost = std::numeric_limits<int64_t>::max();
+    bool bestFull = true;
+    for (int i = 0; i < numElevators; i++) {
+        if (!fleet.isLive(i)) {
+            continue;
         }
-        
-      
-        std::cout << "  Elevator " << i << " score: " << score << std::endl;
-        
-        // Update best elevator if this one has a better score
-        if (score < bestScore) {
-            bestScore = score;
+        int64_t cost = etas.cost(i, call, nowMs);
+        bool full = fleet.isFull(i);
+        if (numElevators <= SCORE_LOG_LIMIT) {
+            LOG_DEBUG("  Elevator " << i << " ETA cost: " << cost << "ms" << (full ? " (full)" : ""));
+        }
+        if (full != bestFull ? !full : cost < bestCost) {
+            bestCost = cost;
             bestElevator = i;
+            bestFull = full;
         }
     }
+    return bestElevator;
+}
+
+/**
+ * Walks a car's stops in LOOK order with the call added, until the car boards the caller
+ * @param elevatorId The car
+ * @param call The hall call
+ * @return Floors travelled plus LOOK_STOP_COST for every stop made first
+ */
+int Scheduler::lookCost(int elevatorId, const Itinerary::Pickup& call) const {
+    return lookCost(fleet.stops[elevatorId], fleet.currentFloor[elevatorId], fleet.sweep[elevatorId],
+                    fleet.moving[elevatorId] != 0, call);
+}
+
+/**
+ * Walks a set of stops in LOOK order with the call added, until the car boards the caller
+ * @param stops The car's stops
+ * @param floor The floor the car is at, or last left
+ * @param sweep The direction the car is sweeping in
+ * @param moving Whether the car is between floors
+ * @param call The hall call
+ * @param stopsFirst If given, set to the number of stops made before the caller's
+ * @return Floors travelled plus LOOK_STOP_COST for every stop made first
+ */
+int Scheduler::lookCost(Itinerary stops, int floor, Direction sweep, bool moving, const Itinerary::Pickup& call,
+                        int* stopsFirst) {
+    int stop;
+    int cost = 0;
+    if (stopsFirst) *stopsFirst = 0;
+
+    // A moving car finishes the leg it is on before it can take the call
+    bool committed = moving && stops.nextStop(floor, sweep, stop);
+    stops.pickups.push_back(call);
+    while (committed || stops.nextStop(floor, sweep, stop)) {
+        committed = false;
+        cost += std::abs(stop - floor);
+        floor = stop;
+        stops.serve(floor, sweep);
+        // Passengers on one floor going the same way board together, so the call has
+        // boarded once no pickup like it is left
+        bool boarded = std::none_of(stops.pickups.begin(), stops.pickups.end(), [&call](const Itinerary::Pickup& pickup) {
+            return pickup.origin == call.origin && pickup.direction == call.direction;
+        });
+        if (boarded) {
+            return cost;
+        }
+        cost += LOOK_STOP_COST;
+        if (stopsFirst) (*stopsFirst)++;
+    }
+    return cost;
+}
+
+/**
+ * Finds the car answering a hall call, so a passenger pressing a lit button can join it.
+ * The car answers it until it leaves the floor the caller's way: while the call is one of
+ * its pickups, and while it stands at the floor about to leave that way.
+ * @param call The hall call
+ * @return The car, or -1 if no car in service with room is answering the call
+ */
+int Scheduler::answeringCar(const Itinerary::Pickup& call) const {
+    auto answered = answeringCars.find({call.origin, call.direction});
+    if (answered == answeringCars.end()) {
+        return -1;
+    }
+    int car = answered->second;
+    if (!fleet.isLive(car) || fleet.isFull(car)) {
+        return -1;
+    }
+    const std::vector<Itinerary::Pickup>& pickups = fleet.stops[car].pickups;
+    bool coming = std::any_of(pickups.begin(), pickups.end(), [&call](const Itinerary::Pickup& pickup) {
+        return pickup.origin == call.origin && pickup.direction == call.direction;
+    });
+    bool boarding = !fleet.moving[car] && fleet.currentFloor[car] == call.origin && fleet.sweep[car] == call.direction;
+    return (coming || boarding) ? car : -1;
+}
+
+int Scheduler::assignOptimalElevator(const Event& event, long long nowMs) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    int originFloor = std::stoi(event.source);
+    Itinerary::Pickup call{originFloor, event.elevatorButton,
+                           Itinerary::travelDirection(originFloor, event.elevatorButton, event.direction())};
+
+    int bestElevator = answeringCar(call);
+    if (bestElevator >= 0) {
+        joinedCalls++;
+        LOG_DEBUG("  Joins the hall call answered by elevator " << bestElevator);
+    } else if (policy == DispatchPolicy::DISPATCH_ETA) {
+        bestElevator = assignByEta(event, nowMs);
+    } else if (policy == DispatchPolicy::DISPATCH_LOOK) {
+        bestElevator = assignByLook(event);
+    } else {
+        bestElevator = assignByHeuristic(event);
+    }
     
     // If we couldn't find a suitable elevator use the next one
     if (bestElevator == -1) {
-        static int lastAssigned = -1;
         bestElevator = (lastAssigned + 1) % numElevators;
         lastAssigned = bestElevator;
     }
     
-    // Mark the chosen elevators as busy
-    elevatorInfoMap[bestElevator].isBusy = true;
+    // Mark the chosen elevators as busy and remember the stop it now has to make
+    fleet.busy[bestElevator] = 1;
+    fleet.stops[bestElevator].pickups.push_back(call);
+    answeringCars[{call.origin, call.direction}] = bestElevator;
+    refreshCar(bestElevator);
+    if (journal) journal->record(JOURNAL_ASSIGN, bestElevator, &event, nowMs);
     
     return bestElevator;
 }
 
+/**
+ * Holds a hall call until the next window is solved
+ * @param event The floor request
+ * @param nowMs The current time on the driving clock
+ */
+void Scheduler::holdCall(const Event& event, long long nowMs) {
+    int originFloor = std::stoi(event.source);
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    if (journal) journal->record(JOURNAL_HOLD, 0, &event, nowMs);
+    heldCalls.push_back({event, {originFloor, event.elevatorButton,
+                         Itinerary::travelDirection(originFloor, event.elevatorButton, event.direction())}, -1, nowMs});
+}
+
+/**
+ * Get the number of hall calls still held
+ * @return The number of calls not yet sent to a car
+ */
+size_t Scheduler::getHeldCallCount() {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    return heldCalls.size();
+}
+
+/**
+ * Solves one window: matches the held calls to the cars, then sends on the calls whose
+ * car is ready to commit to them
+ * @param nowMs The current time on the driving clock
+ * @return The calls sent on, each with its assigned elevator set
+ */
+std::vector<Event> Scheduler::assignHeldCalls(long long nowMs) {
+    std::vector<Event> sent;
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    if (heldCalls.empty()) {
+        return sent;
+    }
+    auto solveStart = std::chrono::steady_clock::now();
+
+    std::vector<int> liveCars;
+    for (int i = 0; i < numElevators; i++) {
+        if (fleet.isLive(i)) liveCars.push_back(i);
+    }
+    int rows = static_cast<int>(heldCalls.size());
+    int cols = static_cast<int>(liveCars.size());
+
+    // Passengers waiting on one floor to go the same way board the same car, so the held
+    // calls are matched as hall calls: one row per floor and direction
+    std::vector<int> hallCallOf(rows);
+    std::vector<int> hallCalls;     // First held call of each hall call
+    for (int r = 0; r < rows; r++) {
+        const Itinerary::Pickup& call = heldCalls[r].call;
+        auto same = std::find_if(hallCalls.begin(), hallCalls.end(), [&](int first) {
+            return heldCalls[first].call.origin == call.origin && heldCalls[first].call.direction == call.direction;
+        });
+        hallCallOf[r] = static_cast<int>(same - hallCalls.begin());
+        if (same == hallCalls.end()) hallCalls.push_back(r);
+    }
+
+    // Each round matches the hall calls still unmatched to the cars, costed against the stops
+    // each car already has plus the hall calls pencilled in for it by earlier rounds. A hall
+    // call may instead take its own "defer" column, priced at its best car plus one stop, so
+    // no car is forced to take a call it is poor for; deferred calls are costed again next round.
+    std::vector<int> choice(hallCalls.size(), -1);
+    std::vector<uint8_t> joined(hallCalls.size(), 0);
+    std::vector<int> unmatched;
+    plannedStops.assign(fleet.stops.begin(), fleet.stops.end());
+    auto pencilIn = [&](int hallCall, int car) {
+        choice[hallCall] = car;
+        // Every passenger in the hall call counts against the car's room
+        for (int held = 0; held < rows; held++) {
+            if (hallCallOf[held] == hallCall) plannedStops[car].pickups.push_back(heldCalls[held].call);
+        }
+    };
+    for (int h = 0; h < static_cast<int>(hallCalls.size()); h++) {
+        // A hall call whose button is already lit joins the car answering it
+        int car = answeringCar(heldCalls[hallCalls[h]].call);
+        if (car >= 0) {
+            joined[h] = 1;
+            pencilIn(h, car);
+        } else {
+            unmatched.push_back(h);
+        }
+    }
+    for (int round = 0; round < BATCH_MAX_ROUNDS && !unmatched.empty() && cols > 0; round++) {
+        int pending = static_cast<int>(unmatched.size());
+        int width = cols + pending;
+        costMatrix.assign(static_cast<size_t>(pending) * width, ASSIGNMENT_INFEASIBLE);
+        for (int r = 0; r < pending; r++) {
+            const Itinerary::Pickup& call = heldCalls[hallCalls[unmatched[r]]].call;
+            int64_t* row = &costMatrix[static_cast<size_t>(r) * width];
+            int64_t best = ASSIGNMENT_INFEASIBLE;
+            for (int c = 0; c < cols; c++) {
+                int car = liveCars[c];
+                if (plannedStops[car].load() >= ELEVATOR_CAPACITY) {
+                    continue;   // Full cars are left out and the call waits for room
+                }
+                row[c] = lookCost(plannedStops[car], fleet.currentFloor[car], fleet.sweep[car],
+                                  fleet.moving[car] != 0, call);
+                best = std::min(best, row[c]);
+            }
+            row[cols + r] = (best == ASSIGNMENT_INFEASIBLE) ? 0 : best + LOOK_STOP_COST;
+        }
+        const std::vector<int>& match = solver.solve(costMatrix, pending, width);
+        std::vector<int> deferred;
+        for (int r = 0; r < pending; r++) {
+            if (match[r] >= cols) {
+                deferred.push_back(unmatched[r]);
+                continue;
+            }
+            pencilIn(unmatched[r], liveCars[match[r]]);
+        }
+        unmatched.swap(deferred);
+    }
+
+    // Send on the calls whose car is ready for them; the rest stay held and may move
+    size_t moved = 0;
+    std::vector<HeldCall> kept;
+    for (int r = 0; r < rows; r++) {
+        HeldCall& waiting = heldCalls[r];
+        bool overdue = nowMs - waiting.heldSinceMs >= BATCH_MAX_HOLD_MS;
+        int car = choice[hallCallOf[r]];
+        if (car >= 0) {
+            if (waiting.car >= 0 && waiting.car != car) moved++;
+            waiting.car = car;
+            // Ready once the car is idle, sweeping towards the caller the caller's way, or next
+            // stopping there. A call the car would only reach after turning round is held, since
+            // another car may free up for it first.
+            int stopsFirst;
+            lookCost(fleet.stops[car], fleet.currentFloor[car], fleet.sweep[car], fleet.moving[car] != 0,
+                     waiting.call, &stopsFirst);
+            const Itinerary::Pickup& call = waiting.call;
+            Direction sweep = fleet.sweep[car];
+            int floor = fleet.currentFloor[car];
+            bool ahead = (sweep == DIRECTION_UP) ? call.origin > floor : call.origin < floor;
+            bool onSweep = sweep == DIRECTION_IDLE || (call.direction == sweep && ahead);
+            bool ready = joined[hallCallOf[r]] || onSweep || stopsFirst <= (fleet.moving[car] ? 1 : 0);
+            if (!ready && !overdue) {
+                kept.push_back(std::move(waiting));
+                continue;
+            }
+        } else if (!overdue) {
+            kept.push_back(std::move(waiting));
+            continue;
+        } else {
+            // Held too long without a car, so it is assigned as it would be unbatched
+            car = assignByLook(waiting.event);
+            if (car < 0) {
+                car = lastAssigned = (lastAssigned + 1) % numElevators;
+            }
+        }
+        if (joined[hallCallOf[r]]) {
+            joinedCalls++;
+        }
+        fleet.busy[car] = 1;
+        fleet.stops[car].pickups.push_back(waiting.call);
+        answeringCars[{waiting.call.origin, waiting.call.direction}] = car;
+        refreshCar(car);
+        heldMillis.record(nowMs - waiting.heldSinceMs);
+        waiting.event.assignedElevator = car;
+        sent.push_back(std::move(waiting.event));
+    }
+    heldCalls.swap(kept);
+    reassignments += moved;
+    batchWindows++;
+    if (journal) {
+        journal->record(JOURNAL_WINDOW, static_cast<int32_t>(sent.size()), nullptr, nowMs);
+        for (const Event& event : sent) {
+            journal->record(JOURNAL_WINDOW_SENT, event.assignedElevator, &event);
+        }
+    }
+
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - solveStart).count();
+    solverMicros.record(micros);
+    LOG_INFO("Batch window: " << rows << " call(s) held, " << sent.size() << " sent, " << moved
+              << " reassigned, solved in " << micros << " us");
+    return sent;
+}
+
+/**
+ * Get the number of hall calls that joined a call already answered
+ * @return The number of calls given to a car without assigning them
+ */
+uint64_t Scheduler::getJoinedCalls() {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    return joinedCalls;
+}
+
+/**
+ * Logs how many hall calls joined one already answered, then the solver time per window
+ * and how long calls were held
+ */
+void Scheduler::reportDispatch() const {
+    if (joinedCalls > 0) {
+        LOG_INFO("Hall calls: " << joinedCalls << " joined a call already answered");
+    }
+    if (batchWindowMs <= 0 || batchWindows == 0) {
+        return;
+    }
+    LOG_INFO("Batch assignment, " << batchWindowMs << " ms windows: " << batchWindows << " solved, "
+             << heldMillis.count() << " calls sent, " << reassignments << " reassigned");
+    LOG_INFO("  solver us: mean=" << solverMicros.mean() << " p50=" << solverMicros.percentile(50)
+             << " p99=" << solverMicros.percentile(99) << " max=" << solverMicros.maximum());
+    LOG_INFO("  held ms (included in waits): mean=" << heldMillis.mean() << " p50=" << heldMillis.percentile(50)
+             << " p99=" << heldMillis.percentile(99) << " max=" << heldMillis.maximum());
+}
+
 /**
  * Mark the scheduler as finished and notify all threads
  */
@@ -203,9 +715,39 @@ void Scheduler::finish() {
     done.store(true);
     floorCV.notify_all();
     elevatorCV.notify_all();
+    {
+        std::lock_guard<std::mutex> stateLock(stateMtx);
+        for (Reactor* reactor : reactors) {
+            reactor->stop();
+        }
+    }
+    metrics.report();
+    reportDispatch();
+    if (journal) {
+        // exit skips the destructors, so the journal is written out here
+        journal->close();
+    }
     exit(1);
 }
 
+/**
+ * Adds an event loop to stop when the scheduler finishes
+ * @param reactor The event loop
+ */
+void Scheduler::addReactor(Reactor* reactor) {
+    std::lock_guard<std::mutex> lock(stateMtx);
+    reactors.push_back(reactor);
+}
+
+/**
+ * Forgets an event loop added with addReactor
+ * @param reactor The event loop
+ */
+void Scheduler::removeReactor(Reactor* reactor) {
+    std::lock_guard<std::mutex> lock(stateMtx);
+    reactors.erase(std::remove(reactors.begin(), reactors.end(), reactor), reactors.end());
+}
+
 /**
  * Checks if the scheduler is finished or not 
  * @return True if scheduler is finished, false otherwise
@@ -214,49 +756,379 @@ bool Scheduler::isFinish() {
     return done;
 }
 
+/**
+ * Gets the port an elevator's assignments are sent to
+ * @param elevatorId The elevator
+ * @return The bank's port if there is one, otherwise the car's own port
+ */
+int Scheduler::elevatorAddress(int elevatorId) const {
+    if (elevatorBankPort >= 0) {
+        return elevatorBankPort;
+    }
+    return ELEVATOR_PORT_BASE + elevatorId; // This works because the ports have a "Base + offset which is the id"
+}
+
+/**
+ * Queues an assignment for the elevator subsystem
+ * @param event The event with its assigned elevator
+ */
+void Scheduler::queueToElevator(Event&& event) {
+    // Calculate the correct port for the assigned elevator
+    int elevatorPort = elevatorAddress(event.assignedElevator);
+    if (journal) journal->record(JOURNAL_SEND, elevatorPort, &event);
+    endpoint->send(elevatorPort, std::move(event));
+    elevatorQueued++;
+}
+
+/**
+ * Queues a response for the floor subsystem
+ * @param event The elevator response
+ */
+void Scheduler::queueToFloor(Event&& event) {
+    if (journal) journal->record(JOURNAL_SEND, FLOOR_PORT, &event);
+    endpoint->send(FLOOR_PORT, std::move(event));
+    floorQueued++;
+}
+
+/**
+ * Sends every queued message, in as few system calls as the transport allows
+ */
+void Scheduler::flushBatches() {
+    try {
+        endpoint->flush();
+        if (elevatorQueued > 0) {
+            LOG_INFO("Sent " << elevatorQueued << " message(s) to elevators");
+        }
+        if (floorQueued > 0) {
+            LOG_INFO("Sent " << floorQueued << " message(s) to floor");
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error sending batch: " << e.what());
+    }
+    elevatorQueued = 0;
+    floorQueued = 0;
+}
+
+/**
+ * Registers the scheduler endpoint with an event loop so events are handled as soon as they arrive
+ * @param reactor The event loop to run on
+ */
+void Scheduler::registerWith(Reactor& reactor) {
+    addReactor(&reactor);
+    batchReactor = &reactor;
+    reactor.addReadable(endpoint->fd(), [this]() { handleInbound(); });
+}
+
 /**
  * Main function that continuously processes events from the floor and sends them to the elevator
  */
 void Scheduler::run() {
-    while (!done) {
-        updateState(schedulerState::SCHEDULER_IDLE);
-
-        Event event;
-        if (receiveEvent(event)) {
-            if (event.isFromFloor) {
-                // Process floor request
-                updateState(schedulerState::SCHEDULER_ALLOCATE_ELEVATOR);
-
-                // Select the optimal elevator based on our algorithm
-                int chosenElevator = assignOptimalElevator(event);
-                
-                // Modify the event to include the assigned elevator
-                event.assignedElevator = chosenElevator;
-                
-                std::cout << "Scheduler processing event: Time=" << event.time 
-                          << ", Source=" << event.source 
-                          << ", Floor Button=" << event.floorButton 
-                          << ", Elevator Button=" << event.elevatorButton 
-                          << ", Assigned to Elevator=" << chosenElevator
-                          << ", Fault=" << event.fault << std::endl;
-
-                // Send the event to the elevator subsystem
-                sendToElevator(event);
-            } else {
-                    // This is a response from an elevator
-                    
-                    // Update our internal record of elevator positions and states
-                    updateElevatorInfo(event);
-                    
-                    // Forward to the floor subsystem, especially completion messages
-                    if (event.isComplete) {
-                        std::cout << "Scheduler forwarding completion notification to floor" << std::endl;
-                    }
-                    sendToFloor(event);
+    Reactor reactor;
+    registerWith(reactor);
+    if (!done) {
+        reactor.run();
+    }
+    removeReactor(&reactor);
+}
+
+/**
+ * Handles every event waiting at the scheduler endpoint, then sends what they produced
+ */
+void Scheduler::handleInbound() {
+    updateState(schedulerState::SCHEDULER_IDLE);
+
+    // Take everything already queued without blocking the event loop
+    try {
+        endpoint->receive(inbound);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error receiving event: " << e.what());
+        return;
+    }
+
+    for (Event& event : inbound) {
+        if (event.isFromFloor && event.callMs < 0) {
+            // Sent without the time of the press, so the wait starts on arrival here
+            event.callMs = steadyMillis();
+        }
+        if (event.isFromFloor && batchWindowMs > 0) {
+            // Held until the window closes and solved with the other calls
+            holdCall(event, steadyMillis());
+            armBatchTimer();
+        } else if (event.isFromFloor) {
+            // Process floor request
+            updateState(schedulerState::SCHEDULER_ALLOCATE_ELEVATOR);
+
+            // Select the optimal elevator based on our algorithm
+            int chosenElevator = assignOptimalElevator(event, steadyMillis());
+            
+            // Modify the event to include the assigned elevator
+            event.assignedElevator = chosenElevator;
+            
+            LOG_INFO("Scheduler processing event: Time=" << event.time 
+                      << ", Source=" << event.source 
+                      << ", Floor Button=" << event.floorButton 
+                      << ", Elevator Button=" << event.elevatorButton 
+                      << ", Assigned to Elevator=" << chosenElevator
+                      << ", Fault=" << event.fault);
+
+            // Send the event to the elevator subsystem
+            queueToElevator(std::move(event));
+        } else {
+            // This is a response from an elevator
+            
+            // Update our internal record of elevator positions and states
+            updateElevatorInfo(event, steadyMillis());
+            if (event.floorButton.empty() && event.source.find("Elevator:") != std::string::npos) {
+                // Tells the floor which button the car has come for, so only that one goes out
+                event.answering = answeredAt(event.assignedElevator, event.currentFloor);
+            }
+            
+            // Forward to the floor subsystem, especially completion messages
+            if (event.isComplete) {
+                LOG_INFO("Scheduler forwarding completion notification to floor");
+            }
+            queueToFloor(std::move(event));
+        }
+    }
+
+    // Everything produced by this batch goes out together
+    inbound.clear();
+    inboundNext = 0;
+    flushBatches();
+    updateState(schedulerState::SCHEDULER_IDLE);
+}
+
+/**
+ * Starts the window timer unless it is already running
+ */
+void Scheduler::armBatchTimer() {
+    if (batchArmed || !batchReactor) {
+        return;
+    }
+    if (batchTimer < 0) {
+        batchTimer = batchReactor->addTimer(batchWindowMs, 0, [this]() { handleBatchWindow(); });
+    } else {
+        batchReactor->rearmTimer(batchTimer, batchWindowMs);
+    }
+    batchArmed = true;
+}
+
+/**
+ * Closes a batch window: sends on the calls it assigned and starts the next window if any are still held
+ */
+void Scheduler::handleBatchWindow() {
+    batchArmed = false;
+    updateState(schedulerState::SCHEDULER_ALLOCATE_ELEVATOR);
+    for (Event& event : assignHeldCalls(steadyMillis())) {
+        LOG_INFO("Scheduler processing event: Time=" << event.time
+                  << ", Source=" << event.source
+                  << ", Floor Button=" << event.floorButton
+                  << ", Elevator Button=" << event.elevatorButton
+                  << ", Assigned to Elevator=" << event.assignedElevator
+                  << ", Fault=" << event.fault);
+        queueToElevator(std::move(event));
+    }
+    flushBatches();
+    if (getHeldCallCount() > 0) {
+        armBatchTimer();
+    }
+    updateState(schedulerState::SCHEDULER_IDLE);
+}
+
+/**
+ * Re-runs a journal on a scheduler of its own and checks every assignment against it
+ * @param fileName The journal
+ * @return What was replayed and the first record that came out differently
+ */
+ReplayResult Scheduler::replay(const std::string& fileName) {
+    ReplayResult result;
+    std::vector<JournalEntry> entries;
+    if (!Journal::read(fileName, entries)) {
+        return result;
+    }
+    if (entries.empty() || entries[0].type != JOURNAL_CARS || entries[0].value <= 0) {
+        LOG_ERROR("Journal " << fileName << " does not start with the number of cars");
+        return result;
+    }
+    result.ok = true;
+    result.records = entries.size();
+
+    auto sameEvent = [](const Event& a, const Event& b) {
+        uint8_t left[EVENT_WIRE_SIZE], right[EVENT_WIRE_SIZE];
+        a.encode(left, sizeof(left));
+        b.encode(right, sizeof(right));
+        return std::equal(left, left + EVENT_WIRE_SIZE, right);
+    };
+    auto mismatch = [&result](size_t index) {
+        result.mismatches++;
+        if (result.firstMismatch < 0) {
+            result.firstMismatch = static_cast<long long>(index);
+        }
+    };
+
+    Scheduler scheduler(entries[0].value, false);
+    for (size_t i = 1; i < entries.size(); i++) {
+        const JournalEntry& entry = entries[i];
+        switch (entry.type) {
+            case JOURNAL_POLICY:
+                scheduler.setDispatchPolicy(static_cast<DispatchPolicy>(entry.value));
+                break;
+            case JOURNAL_BATCH_WINDOW:
+                scheduler.setBatchWindow(entry.value);
+                break;
+            case JOURNAL_ASSIGN: {
+                int car = scheduler.assignOptimalElevator(entry.event, entry.timeMs);
+                result.decisions++;
+                if (car != entry.value) {
+                    mismatch(i);
+                    LOG_WARN("Replay record " << i << ": hall call at floor " << entry.event.source << " to "
+                             << entry.event.elevatorButton << " went to elevator " << car
+                             << ", journal has elevator " << entry.value);
                 }
+                break;
             }
+            case JOURNAL_HOLD:
+                scheduler.holdCall(entry.event, entry.timeMs);
+                break;
+            case JOURNAL_WINDOW: {
+                std::vector<Event> sent = scheduler.assignHeldCalls(entry.timeMs);
+                result.decisions++;
+                // The calls the window sent on follow it
+                size_t recorded = 0;
+                bool same = true;
+                while (i + 1 < entries.size() && entries[i + 1].type == JOURNAL_WINDOW_SENT) {
+                    const JournalEntry& call = entries[++i];
+                    same = same && recorded < sent.size() && sent[recorded].assignedElevator == call.value
+                        && sameEvent(sent[recorded], call.event);
+                    recorded++;
+                }
+                if (!same || recorded != sent.size() || static_cast<int32_t>(recorded) != entry.value) {
+                    mismatch(i);
+                    LOG_WARN("Replay record " << i << ": batch window at " << entry.timeMs << " ms sent "
+                             << sent.size() << " call(s) differently from the " << entry.value << " in the journal");
+                }
+                break;
+            }
+            case JOURNAL_UPDATE:
+                scheduler.updateElevatorInfo(entry.event, entry.timeMs);
+                break;
+            case JOURNAL_REMOVE:
+                scheduler.removeElevator(entry.value);
+                break;
+            case JOURNAL_RESTORE:
+                scheduler.restoreElevator(entry.value);
+                break;
+            case JOURNAL_RELEASE:
+                scheduler.releaseCall(entry.value, entry.event);
+                break;
+            case JOURNAL_SEND:
+                result.sends++;
+                break;
+            default:
+                break;
         }
-        
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
     }
+    return result;
+}
+
+/**
+ * Writes the dispatch state to a checkpoint
+ * @param out The checkpoint
+ */
+void Scheduler::saveState(CheckpointWriter& out) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    out.putInt(numElevators);
+    out.putInt(policy);
+    out.putInt(batchWindowMs);
+    for (int i = 0; i < numElevators; i++) {
+        out.putInt(fleet.currentFloor[i]);
+        out.putInt(fleet.state[i]);
+        out.putInt(fleet.busy[i]);
+        out.putInt(fleet.passengers[i]);
+        out.putInt(fleet.totalPassengers[i]);
+        out.putItinerary(fleet.stops[i]);
+        out.putInt(fleet.sweep[i]);
+        out.putInt(fleet.moving[i]);
+        out.putInt(fleet.isLive(i));
+        out.putInt(etas.getReportTime(i));
+    }
+    out.putInt(lastAssigned);
+    out.putInt(static_cast<int64_t>(answeringCars.size()));
+    for (const auto& [hallCall, car] : answeringCars) {
+        out.putInt(hallCall.first);
+        out.putInt(hallCall.second);
+        out.putInt(car);
+    }
+    out.putInt(static_cast<int64_t>(joinedCalls));
+    out.putInt(static_cast<int64_t>(heldCalls.size()));
+    for (const HeldCall& held : heldCalls) {
+        out.putEvent(held.event);
+        out.putInt(held.call.origin);
+        out.putInt(held.call.destination);
+        out.putInt(held.call.direction);
+        out.putInt(held.car);
+        out.putInt(held.heldSinceMs);
+    }
+    solverMicros.save(out);
+    heldMillis.save(out);
+    out.putInt(static_cast<int64_t>(batchWindows));
+    out.putInt(static_cast<int64_t>(reassignments));
+    metrics.save(out);
+}
+
+/**
+ * Replaces the dispatch state with one saved by saveState
+ * @param in The checkpoint
+ */
+void Scheduler::restoreState(CheckpointReader& in) {
+    std::lock_guard<std::mutex> lock(elevatorInfoMtx);
+    int64_t cars = in.getInt();
+    if (cars != numElevators) {
+        throw std::runtime_error("checkpoint is for " + std::to_string(cars) + " elevators, not "
+                                 + std::to_string(numElevators));
+    }
+    policy = static_cast<DispatchPolicy>(in.getInt());
+    batchWindowMs = static_cast<int>(in.getInt());
+    for (int i = 0; i < numElevators; i++) {
+        fleet.currentFloor[i] = static_cast<int32_t>(in.getInt());
+        fleet.state[i] = static_cast<int32_t>(in.getInt());
+        fleet.busy[i] = static_cast<int32_t>(in.getInt());
+        fleet.passengers[i] = static_cast<int32_t>(in.getInt());
+        fleet.totalPassengers[i] = static_cast<int32_t>(in.getInt());
+        fleet.stops[i] = in.getItinerary();
+        fleet.sweep[i] = static_cast<Direction>(in.getInt());
+        fleet.moving[i] = static_cast<uint8_t>(in.getInt());
+        if (in.getInt()) {
+            fleet.restore(i);
+        } else {
+            fleet.remove(i);
+        }
+        etas.setReportTime(i, in.getInt());
+    }
+    lastAssigned = static_cast<int>(in.getInt());
+    answeringCars.clear();
+    size_t answered = in.getCount();
+    for (size_t n = 0; n < answered; n++) {
+        int floor = static_cast<int>(in.getInt());
+        Direction direction = static_cast<Direction>(in.getInt());
+        answeringCars[{floor, direction}] = static_cast<int>(in.getInt());
+    }
+    joinedCalls = static_cast<uint64_t>(in.getInt());
+    heldCalls.resize(in.getCount());
+    for (HeldCall& held : heldCalls) {
+        held.event = in.getEvent();
+        held.call.origin = static_cast<int>(in.getInt());
+        held.call.destination = static_cast<int>(in.getInt());
+        held.call.direction = static_cast<Direction>(in.getInt());
+        held.car = static_cast<int>(in.getInt());
+        held.heldSinceMs = in.getInt();
+    }
+    solverMicros.restore(in);
+    heldMillis.restore(in);
+    batchWindows = static_cast<uint64_t>(in.getInt());
+    reassignments = static_cast<uint64_t>(in.getInt());
+    metrics.restore(in);
+    for (int i = 0; i < numElevators; i++) {
+        refreshCar(i);
+    }
+}
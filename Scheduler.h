@@ -5,33 +5,49 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include "Event.h"
 #include "ElevatorInfo.h"
+#include "Reactor.h"
+#include "Itinerary.h"
+#include "ElevatorFleet.h"
+#include "Metrics.h"
+#include "Transport.h"
+#include "AssignmentSolver.h"
+#include "EtaModel.h"
+#include "Journal.h"
+#include "Checkpoint.h"
 
 #define SCHEDULER_PORT 8000
 #define FLOOR_PORT 8001  
 #define ELEVATOR_PORT 8002  
 #define ELEVATOR_PORT_BASE 9000  // Base port for elevator subsystems
-#define ELEVATOR_CAPACITY 10
+#define LOOK_STOP_COST 2         // Floors of travel a stop on the way is worth under DISPATCH_LOOK
+#define SCORE_LOG_LIMIT 16       // Per-car scores are only printed for fleets up to this size
+#define BATCH_MAX_ROUNDS 8       // Matching rounds per batch window; calls left over wait for the next window
+#define BATCH_MAX_HOLD_MS 5000   // A held hall call goes to its car after this long even if the car is not ready for it
 
 #include "ElevatorEnums.h"
 
 class Scheduler {
 private:
-    DatagramSocket receiveSocket; // for receiving from either the floor or elevatorsubsystem
-    DatagramSocket floorSendSocket;  // for sending responses back to the floor
-    DatagramSocket elevatorSendSocket; // for sending events to the elevator
+    std::unique_ptr<Transport> ownedTransport; // UDP transport made when none is passed in
+    Transport* transport;         // How the scheduler, floor and elevators reach each other
+    std::unique_ptr<Endpoint> endpoint; // receives from the floor and elevators, null when not networked
+    std::vector<Event> inbound;   // events taken from the endpoint on each wakeup
+    size_t inboundNext = 0;       // next event in inbound for receiveEvent
+    size_t floorQueued = 0;       // responses waiting to go to the floor
+    size_t elevatorQueued = 0;    // assignments waiting to go to the elevators
+    int elevatorBankPort = -1;    // port every assignment goes to, or -1 for each car's own port
 
     std::mutex floorMtx, elevatorMtx, stateMtx, elevatorInfoMtx;
     std::condition_variable floorCV, elevatorCV;
     std::atomic<bool> done{false};
     schedulerState state = schedulerState::SCHEDULER_IDLE;
-
-    std::vector<int> removedElevators;
     
-    // Track elevator information
+    // Snapshot of one car, as returned by getInfoMap
     struct ElevatorInfo {
         int id;
         int currentFloor;
@@ -39,21 +55,97 @@ private:
         int passengers;
         int totalPassengers;
         bool isBusy;
+        Itinerary stops;
+        Direction sweep;
+        bool moving;
     };
     
-    std::map<int, ElevatorInfo> elevatorInfoMap;
     int numElevators;
+    ElevatorFleet fleet;            // Car state, one column per field and one row per car
+    std::vector<int32_t> scores;    // Heuristic score of each car for the call being assigned
+    DispatchPolicy policy = DispatchPolicy::DISPATCH_HEURISTIC;
+    EtaModel etas;                  // Timed route of every car, kept up to date under DISPATCH_ETA
+    PassengerMetrics metrics;       // Wait, ride and journey times reported by the cars
+    Journal* journal = nullptr;     // Where inputs, sends and decisions are recorded, if anywhere
+
+    std::vector<Reactor*> reactors;   // Event loops to stop when the scheduler finishes
+
+    // A hall call held for batch assignment, with the car it is pencilled in for
+    struct HeldCall {
+        Event event;
+        Itinerary::Pickup call;
+        int car;                    // Car chosen by the last window, -1 before the first
+        long long heldSinceMs;
+    };
+
+    int lastAssigned = -1;          // Car given the last call that no car in service could take
+
+    // Car answering each floor and direction's hall call. A passenger pressing a button
+    // that is already lit joins that car's call instead of being assigned again.
+    std::map<std::pair<int, Direction>, int> answeringCars;
+    uint64_t joinedCalls = 0;       // Hall calls that joined one already answered
+    int batchWindowMs = 0;          // 0 assigns each hall call as it arrives
+    std::vector<HeldCall> heldCalls;
+    AssignmentSolver solver;
+    std::vector<int64_t> costMatrix;    // Hall calls by live cars and a defer column each, rebuilt each round
+    std::vector<Itinerary> plannedStops; // Each car's stops with the calls pencilled in so far
+    HdrHistogram solverMicros;      // Time each window spent costing and solving
+    HdrHistogram heldMillis;        // Time each call was held before going to its car
+    uint64_t batchWindows = 0;
+    uint64_t reassignments = 0;     // Held calls moved to another car by a later window
+    Reactor* batchReactor = nullptr; // Loop the window timer runs on
+    int batchTimer = -1;
+    bool batchArmed = false;
+
+    void handleInbound();
+    void queueToElevator(Event&& event);
+    void queueToFloor(Event&& event);
+    void flushBatches();
+    int elevatorAddress(int elevatorId) const;
+
+    int assignByHeuristic(const Event& event);
+    int assignByLook(const Event& event);
+    int assignByEta(const Event& event, long long nowMs);
+    void refreshCar(int elevatorId);
+    int answeringCar(const Itinerary::Pickup& call) const;
+    Direction answeredAt(int elevatorId, int floor);
+    int lookCost(int elevatorId, const Itinerary::Pickup& call) const;
+    static int lookCost(Itinerary stops, int floor, Direction sweep, bool moving, const Itinerary::Pickup& call,
+                        int* stopsFirst = nullptr);
+    void handleBatchWindow();
+    void armBatchTimer();
 public:
     /**
      * Constructor for the Scheduler class
      * @param elevatorCount The number of elevators in the system
+     * @param networked Whether to open the scheduler endpoint (false for in-process simulation)
+     * @param transport How the subsystems talk to each other; null sends UDP datagrams
      */
-    Scheduler(int elevatorCount = 4);
+    Scheduler(int elevatorCount = 4, bool networked = true, Transport* transport = nullptr);
     
     ~Scheduler() = default;
 
+    /**
+     * Takes a car out of service after a fault. Its pickups are dropped, as the car hands
+     * those calls back to be assigned again; its dropoffs stay for the riders on board.
+     * @param elevatorId The car
+     */
     void removeElevator(int elevatorId);
 
+    /**
+     * Takes a hall call off a car that was too full to board the caller. The car hands
+     * the call back to be assigned again.
+     * @param elevatorId The car
+     * @param event The floor request
+     */
+    void releaseCall(int elevatorId, const Event& event);
+
+    /**
+     * Returns a recovered car to service, resting at the floor it last reported
+     * @param elevatorId The car
+     */
+    void restoreElevator(int elevatorId);
+
     /**
      * Mark the scheduler as finished and notify all threads
      */
@@ -64,6 +156,24 @@ public:
      */
     void run();
 
+    /**
+     * Registers the scheduler endpoint with an event loop so events are handled as soon as they arrive
+     * @param reactor The event loop to run on
+     */
+    void registerWith(Reactor& reactor);
+
+    /**
+     * Adds an event loop to stop when the scheduler finishes
+     * @param reactor The event loop
+     */
+    void addReactor(Reactor* reactor);
+
+    /**
+     * Forgets an event loop added with addReactor
+     * @param reactor The event loop
+     */
+    void removeReactor(Reactor* reactor);
+
     /**
      * Checks if the scheduler is finished or not 
      * @return True if scheduler is finished, false otherwise
@@ -81,32 +191,157 @@ public:
      * @return The number of elevators
      */
     int getNumElevators() const { return numElevators; }
+
+    /**
+     * Chooses how hall calls are assigned to elevators
+     * @param newPolicy The dispatch policy
+     */
+    void setDispatchPolicy(DispatchPolicy newPolicy);
+
+    /**
+     * Get the dispatch policy in use
+     * @return The dispatch policy
+     */
+    DispatchPolicy getDispatchPolicy() const { return policy; }
+
+    /**
+     * Get the arrival estimates used by DISPATCH_ETA
+     * @return The model; only kept up to date while that policy is in use
+     */
+    const EtaModel& getEtaModel() const { return etas; }
+
+    /**
+     * Holds hall calls for a window and assigns them together instead of one at a time.
+     * Each window solves a minimum-cost matching of the held hall calls (one per floor and
+     * direction) to the cars on LOOK costs, so two calls never both go to the one car that
+     * is best for each of them when another car can take one for little more.
+     * @param windowMs Milliseconds to collect calls for, 0 to assign each as it arrives
+     */
+    void setBatchWindow(int windowMs);
+
+    /**
+     * Get the batch window
+     * @return Milliseconds calls are collected for, 0 if they are assigned as they arrive
+     */
+    int getBatchWindow() const { return batchWindowMs; }
+
+    /**
+     * Holds a hall call until the next window is solved
+     * @param event The floor request
+     * @param nowMs The current time on the driving clock
+     */
+    void holdCall(const Event& event, long long nowMs);
+
+    /**
+     * Solves one window: matches the held calls to the cars, at most one call each, then
+     * sends on the calls whose car is ready to commit to them. Calls whose button is already
+     * lit go to the car answering it without being matched. A call is sent once its car
+     * is idle, is sweeping towards it in the caller's direction, or would make it the next
+     * stop. A call the car would only reach after turning round is held, and a later window
+     * may give it to a different car; after BATCH_MAX_HOLD_MS it is sent anyway.
+     * @param nowMs The current time on the driving clock
+     * @return The calls sent on, each with its assigned elevator set
+     */
+    std::vector<Event> assignHeldCalls(long long nowMs);
+
+    /**
+     * Get the number of hall calls still held
+     * @return The number of calls not yet sent to a car
+     */
+    size_t getHeldCallCount();
+
+    /**
+     * Logs how many hall calls joined one already answered and, when calls are batched,
+     * the solver time per window and how long calls were held
+     */
+    void reportDispatch() const;
+
+    /**
+     * Get the number of hall calls that joined a call already answered
+     * @return The number of calls given to a car without assigning them
+     */
+    uint64_t getJoinedCalls();
+
+    /**
+     * Records everything the scheduler takes in and sends, and every assignment it makes,
+     * so the run can be replayed. Hall calls, car responses, cars leaving and returning to
+     * service and batch windows are recorded in the order they change the scheduler's
+     * state, which is what decides the next assignment.
+     * @param newJournal The journal to append to, or null to stop recording; it must
+     *                   outlive the scheduler or be replaced first
+     */
+    void setJournal(Journal* newJournal);
+
+    /**
+     * Re-runs a journal on a scheduler of its own, without endpoints, timers or elevators,
+     * feeding it the recorded inputs in order and checking that every assignment comes
+     * out as recorded. Each assignment that differs is logged as a warning.
+     * @param fileName The journal
+     * @return What was replayed and the first record that came out differently
+     */
+    static ReplayResult replay(const std::string& fileName);
+
+    /**
+     * Writes the dispatch state to a checkpoint: every car's position, stops and whether
+     * it is in service, the hall calls being answered and held, the policy and batch
+     * window, and the metrics. Endpoints, timers and the journal are not part of it.
+     * @param out The checkpoint
+     */
+    void saveState(CheckpointWriter& out);
+
+    /**
+     * Replaces the dispatch state with one saved by saveState, from a scheduler with
+     * the same number of cars. The ETA routes are rebuilt from the restored stops.
+     * @param in The checkpoint
+     * @throws std::runtime_error if the checkpoint is cut off or for another fleet size
+     */
+    void restoreState(CheckpointReader& in);
+
+    /**
+     * Sends every assignment to one port, where an ElevatorBank hands it to the car
+     * @param port The bank's port, or -1 to send to ELEVATOR_PORT_BASE + the car's id
+     */
+    void setElevatorBankPort(int port) { elevatorBankPort = port; }
+
+    /**
+     * Get the passenger trip times the cars have reported
+     * @return The metrics, which any thread may record into or report
+     */
+    PassengerMetrics& getMetrics() { return metrics; }
+
+    /**
+     * Get how long hall calls were held in batch windows
+     * @return The hold times, which the passenger waits already include
+     */
+    const HdrHistogram& getHeldMillis() const { return heldMillis; }
+
+    /**
+     * Get the transport the floor and elevators open their endpoints on
+     * @return The transport passed to the constructor, or the scheduler's own UDP transport
+     */
+    Transport& getTransport() { return *transport; }
     void updateState(schedulerState newState);
     void sendToFloor(const Event& event);
     void sendToElevator(const Event& event);
     bool receiveEvent(Event& event);
     
-    // Method to assign the optimal elevator based on various factors
-    int assignOptimalElevator(const Event& event);
+    // Method to assign the optimal elevator based on various factors, at nowMs on the driving clock
+    int assignOptimalElevator(const Event& event, long long nowMs);
     
-    // Updates internal elevator information based on received updates
-    void updateElevatorInfo(const Event& event);
+    // Updates internal elevator information based on an update the car sent at nowMs
+    void updateElevatorInfo(const Event& event, long long nowMs);
     
     /**
-     * Get the information map of the elevators
+     * Get the information map of the elevators in service
      * @return  The infomap of the elevator
      */
-    std::map<int, ElevatorInfo> getInfoMap() { 
-        return elevatorInfoMap;
-     } 
+    std::map<int, ElevatorInfo> getInfoMap();
 
     /**
-     * Get the list of removed elevators
+     * Get the list of elevators out of service
      * @return a list of removed elevators
      */
-     std::vector<int> getRemovedElevators(){
-        return removedElevators;
-     }
+     std::vector<int> getRemovedElevators();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "Simulation.h"
+#include "Logger.h"
+#include "TraceReader.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * Constructor for the Simulation class
+ * @param elevatorCount The number of elevators in the building
+ * @param speedFactor Pacing against the wall clock, 0 runs as fast as possible
+ */
+Simulation::Simulation(int elevatorCount, double speedFactor)
+    : currentTime(0), nextSequence(0), speed(speedFactor),
+      scheduler(elevatorCount, false), totalEvents(0), completedEvents(0), batchWindowOpen(false) {
+    for (int i = 0; i < elevatorCount; i++) {
+        elevatorSubsystems.push_back(std::make_unique<ElevatorSubsystem>(scheduler, i, *this));
+    }
+}
+
+/**
+ * Schedules an action on the virtual clock
+ * @param delay Milliseconds from now until the action is due
+ * @param action The work to run
+ */
+void Simulation::schedule(long long delay, std::function<void()> action) {
+    push(delay, ACTION_CALLBACK, -1, Event{}, std::move(action));
+}
+
+/**
+ * Schedules a car's next step of the stop cycle
+ * @param car The car
+ * @param delay Milliseconds from now until the step is due
+ */
+void Simulation::scheduleAdvance(int car, long long delay) {
+    push(delay, ACTION_ADVANCE, car);
+}
+
+/**
+ * Adds an action to the heap
+ * @param delay Milliseconds from now until the action is due
+ * @param kind What the action does
+ * @param car The car, for ACTION_ADVANCE
+ * @param event The hall call, for ACTION_FLOOR_EVENT
+ * @param action The work, for ACTION_CALLBACK
+ */
+void Simulation::push(long long delay, ActionKind kind, int car, const Event& event, std::function<void()> action) {
+    actions.push_back({currentTime + std::max(delay, 0LL), nextSequence++, kind, car, event, std::move(action)});
+    std::push_heap(actions.begin(), actions.end(), LaterFirst());
+}
+
+/**
+ * Runs an action that has come due
+ * @param next The action
+ */
+void Simulation::perform(ScheduledAction& next) {
+    switch (next.kind) {
+        case ACTION_FLOOR_EVENT:
+            handleFloorEvent(std::move(next.event));
+            break;
+        case ACTION_ADVANCE:
+            elevatorSubsystems[next.car]->step();
+            break;
+        case ACTION_BATCH_WINDOW:
+            handleBatchWindow();
+            break;
+        case ACTION_CALLBACK:
+            next.action();
+            break;
+    }
+}
+
+/**
+ * Reads floor events from a file into hall calls timed at their recorded offsets
+ * @param fileName The input file containing event data
+ * @param calls Output, each call with its offset in milliseconds
+ * @return False if the file could not be opened
+ */
+bool Simulation::readFile(const std::string& fileName, std::vector<std::pair<long long, Event>>& calls) {
+    TraceReader reader(fileName);
+    if (!reader.isOpen()) {
+        LOG_ERROR("Could not open " << fileName);
+        return false;
+    }
+
+    TraceRecord records[DATAGRAM_BATCH_SIZE];
+    long long firstTime = -1;
+    long long offset = 0;
+    size_t count;
+    while ((count = reader.next(records, DATAGRAM_BATCH_SIZE)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (firstTime < 0) {
+                firstTime = records[i].timeMs;
+            }
+            offset = std::max(offset, records[i].timeMs - firstTime);
+
+            Event event;
+            records[i].toEvent(event);
+            calls.emplace_back(offset, std::move(event));
+        }
+    }
+    return true;
+}
+
+/**
+ * Reads floor events from a file and schedules them at their recorded offsets
+ * @param fileName The input file containing event data
+ * @return False if the file could not be opened
+ */
+bool Simulation::loadFile(const std::string& fileName) {
+    std::vector<std::pair<long long, Event>> calls;
+    if (!readFile(fileName, calls)) {
+        return false;
+    }
+    for (const auto& [at, event] : calls) {
+        addFloorEvent(at, event);
+    }
+    return true;
+}
+
+/**
+ * Schedules a floor request
+ * @param at Simulated time of the hall call in milliseconds
+ * @param event The floor event
+ */
+void Simulation::addFloorEvent(long long at, const Event& event) {
+    totalEvents++;
+    push(at - currentTime, ACTION_FLOOR_EVENT, -1, event);
+}
+
+/**
+ * Assigns a floor request to an elevator
+ * @param event The floor event
+ */
+void Simulation::handleFloorEvent(Event event) {
+    if (event.callMs < 0) {
+        event.callMs = currentTime;     // The hall call is made now; calls handed back keep theirs
+    }
+    if (scheduler.getBatchWindow() > 0) {
+        scheduler.holdCall(event, currentTime);
+        if (!batchWindowOpen) {
+            batchWindowOpen = true;
+            push(scheduler.getBatchWindow(), ACTION_BATCH_WINDOW);
+        }
+        return;
+    }
+
+    event.assignedElevator = scheduler.assignOptimalElevator(event, currentTime);
+
+    LOG_INFO("[t=" << currentTime << "ms] Scheduler processing event: Time=" << event.time
+              << ", Source=" << event.source
+              << ", Floor Button=" << event.floorButton
+              << ", Elevator Button=" << event.elevatorButton
+              << ", Assigned to Elevator=" << event.assignedElevator
+              << ", Fault=" << event.fault);
+
+    elevatorSubsystems[event.assignedElevator]->dispatch(event);
+}
+
+/**
+ * Closes a batch window: dispatches the calls it assigned and opens the next window if any are still held
+ */
+void Simulation::handleBatchWindow() {
+    batchWindowOpen = false;
+    for (const Event& event : scheduler.assignHeldCalls(currentTime)) {
+        LOG_INFO("[t=" << currentTime << "ms] Scheduler processing event: Time=" << event.time
+                  << ", Source=" << event.source
+                  << ", Floor Button=" << event.floorButton
+                  << ", Elevator Button=" << event.elevatorButton
+                  << ", Assigned to Elevator=" << event.assignedElevator
+                  << ", Fault=" << event.fault);
+        elevatorSubsystems[event.assignedElevator]->dispatch(event);
+    }
+    if (scheduler.getHeldCallCount() > 0) {
+        batchWindowOpen = true;
+        push(scheduler.getBatchWindow(), ACTION_BATCH_WINDOW);
+    }
+}
+
+/**
+ * Feeds an elevator response back to the scheduler and counts completions
+ * @param response The elevator response event
+ */
+void Simulation::handleElevatorResponse(const Event& response) {
+    if (response.isFromFloor) {
+        // Handed back by a car that went out of service
+        handleFloorEvent(response);
+        return;
+    }
+    scheduler.updateElevatorInfo(response, currentTime);
+    if (response.isComplete) {
+        completedEvents++;
+        LOG_INFO("[t=" << currentTime << "ms] Event completed! Completed " << completedEvents
+                  << " of " << totalEvents << " events");
+        if (onComplete) {
+            onComplete(response);
+        }
+    }
+}
+
+/**
+ * Runs scheduled actions in time order until none are left
+ */
+void Simulation::run() {
+    runUntil(std::numeric_limits<long long>::max());
+}
+
+/**
+ * Runs scheduled actions in time order up to a time, then moves the clock to it
+ * @param timeMs The last simulated time to run actions at
+ */
+void Simulation::runUntil(long long timeMs) {
+    auto wallStart = std::chrono::steady_clock::now();
+    long long simStart = currentTime;
+
+    while (!actions.empty() && actions.front().time <= timeMs) {
+        std::pop_heap(actions.begin(), actions.end(), LaterFirst());
+        ScheduledAction next = std::move(actions.back());
+        actions.pop_back();
+
+        // Hold the action back until its paced wall-clock time
+        if (speed > 0) {
+            auto due = wallStart + std::chrono::microseconds(
+                static_cast<long long>((next.time - simStart) * 1000 / speed));
+            std::this_thread::sleep_until(due);
+        }
+
+        currentTime = next.time;
+        perform(next);
+    }
+    if (!actions.empty()) {
+        currentTime = std::max(currentTime, timeMs);
+    }
+}
+
+/**
+ * Writes the whole simulation to a compact binary file
+ * @param fileName The file, replaced if it exists
+ * @return False if the state could not be written
+ */
+bool Simulation::saveCheckpoint(const std::string& fileName) {
+    CheckpointWriter out;
+    out.putInt(static_cast<int64_t>(elevatorSubsystems.size()));
+    out.putInt(currentTime);
+    out.putInt(static_cast<int64_t>(nextSequence));
+    out.putInt(totalEvents);
+    out.putInt(completedEvents);
+    out.putInt(batchWindowOpen);
+
+    // The heap is written in its own order, so it is still a heap when read back
+    out.putInt(static_cast<int64_t>(actions.size()));
+    for (const ScheduledAction& action : actions) {
+        if (action.kind == ACTION_CALLBACK) {
+            LOG_ERROR("Cannot checkpoint at t=" << currentTime << "ms: work passed to schedule() is still pending");
+            return false;
+        }
+        out.putInt(action.time);
+        out.putInt(static_cast<int64_t>(action.sequence));
+        out.putInt(action.kind);
+        if (action.kind == ACTION_ADVANCE) {
+            out.putInt(action.car);
+        } else if (action.kind == ACTION_FLOOR_EVENT) {
+            out.putEvent(action.event);
+        }
+    }
+    for (auto& subsystem : elevatorSubsystems) {
+        subsystem->saveState(out);
+    }
+    scheduler.saveState(out);
+    if (!out.writeFile(fileName)) {
+        return false;
+    }
+    LOG_INFO("Checkpoint at t=" << currentTime << "ms written to " << fileName << ", "
+             << out.bytes().size() << " bytes");
+    return true;
+}
+
+/**
+ * Creates a simulation from a checkpoint
+ * @param fileName The checkpoint
+ * @param speedFactor Pacing against the wall clock, 0 runs as fast as possible
+ * @return The simulation, or null if the file is missing, cut off or not a checkpoint
+ */
+std::unique_ptr<Simulation> Simulation::restoreCheckpoint(const std::string& fileName, double speedFactor) {
+    CheckpointReader in;
+    if (!in.readFile(fileName)) {
+        return nullptr;
+    }
+    try {
+        int64_t cars = in.getInt();
+        if (cars <= 0 || cars > std::numeric_limits<int>::max()) {
+            throw std::runtime_error("checkpoint has no elevators");
+        }
+        auto simulation = std::make_unique<Simulation>(static_cast<int>(cars), speedFactor);
+        simulation->restoreState(in);
+        if (!in.atEnd()) {
+            throw std::runtime_error("checkpoint has data after the scheduler");
+        }
+        LOG_INFO("Restored " << cars << " elevators at t=" << simulation->now() << "ms from " << fileName);
+        return simulation;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Could not restore " << fileName << ": " << e.what());
+        return nullptr;
+    }
+}
+
+/**
+ * Reads everything after the car count back in the order saveCheckpoint wrote it
+ * @param in The checkpoint
+ */
+void Simulation::restoreState(CheckpointReader& in) {
+    currentTime = in.getInt();
+    nextSequence = static_cast<unsigned long long>(in.getInt());
+    totalEvents = static_cast<int>(in.getInt());
+    completedEvents = static_cast<int>(in.getInt());
+    batchWindowOpen = in.getInt() != 0;
+    actions.resize(in.getCount());
+    for (ScheduledAction& action : actions) {
+        action.time = in.getInt();
+        action.sequence = static_cast<unsigned long long>(in.getInt());
+        action.kind = static_cast<ActionKind>(in.getInt());
+        action.car = -1;
+        if (action.kind == ACTION_ADVANCE) {
+            action.car = static_cast<int>(in.getInt());
+            if (action.car < 0 || action.car >= static_cast<int>(elevatorSubsystems.size())) {
+                throw std::runtime_error("checkpoint steps a car that does not exist");
+            }
+        } else if (action.kind == ACTION_FLOOR_EVENT) {
+            action.event = in.getEvent();
+        } else if (action.kind != ACTION_BATCH_WINDOW) {
+            throw std::runtime_error("checkpoint has an unknown action");
+        }
+    }
+    for (auto& subsystem : elevatorSubsystems) {
+        subsystem->restoreState(in);
+    }
+    scheduler.restoreState(in);
+}
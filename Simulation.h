@@ -0,0 +1,171 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scheduler.h"
+#include "ElevatorSubsystem.h"
+
+/**
+ * Discrete-event simulation of the whole elevator system on a virtual clock.
+ * Future actions sit in a priority queue ordered by simulated time and are run
+ * back-to-back, so the elevator state machine advances as fast as the CPU allows.
+ * An optional speed factor paces the run against the wall clock instead.
+ */
+class Simulation {
+private:
+    // What a scheduled action does. All but ACTION_CALLBACK are plain data, so the
+    // actions still to run can be written to a checkpoint.
+    enum ActionKind {
+        ACTION_FLOOR_EVENT,     // A hall call is made
+        ACTION_ADVANCE,         // A car's next step of the stop cycle is due
+        ACTION_BATCH_WINDOW,    // A batch window closes
+        ACTION_CALLBACK         // Work passed to schedule()
+    };
+
+    struct ScheduledAction {
+        long long time;                 // Simulated time the action is due, in milliseconds
+        unsigned long long sequence;    // Insertion order, breaks ties so runs are deterministic
+        ActionKind kind;
+        int car;                        // The car, for ACTION_ADVANCE
+        Event event;                    // The hall call, for ACTION_FLOOR_EVENT
+        std::function<void()> action;   // The work, for ACTION_CALLBACK
+    };
+
+    // Heap comparator so the earliest action sits on top
+    struct LaterFirst {
+        bool operator()(const ScheduledAction& a, const ScheduledAction& b) const {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    std::vector<ScheduledAction> actions;   // Min-heap of future actions
+    long long currentTime;                  // Simulated time in milliseconds
+    unsigned long long nextSequence;
+    double speed;                           // 0 = as fast as possible, 1 = real time, N = N times real time
+
+    Scheduler scheduler;
+    std::vector<std::unique_ptr<ElevatorSubsystem>> elevatorSubsystems;
+    int totalEvents;
+    int completedEvents;
+    bool batchWindowOpen;                   // A batch window is scheduled to close
+    std::function<void(const Event&)> onComplete;   // Told of every finished request
+
+    void handleBatchWindow();
+    void push(long long delay, ActionKind kind, int car = -1, const Event& event = Event{},
+              std::function<void()> action = nullptr);
+    void perform(ScheduledAction& next);
+    void restoreState(CheckpointReader& in);
+
+public:
+    /**
+     * Constructor for the Simulation class
+     * @param elevatorCount The number of elevators in the building
+     * @param speedFactor Pacing against the wall clock, 0 runs as fast as possible
+     */
+    Simulation(int elevatorCount = 4, double speedFactor = 0);
+
+    /**
+     * Gets the current simulated time
+     * @return Milliseconds since the start of the simulation
+     */
+    long long now() const { return currentTime; }
+
+    /**
+     * Schedules an action on the virtual clock
+     * @param delay Milliseconds from now until the action is due
+     * @param action The work to run
+     */
+    void schedule(long long delay, std::function<void()> action);
+
+    /**
+     * Schedules a car's next step of the stop cycle
+     * @param car The car
+     * @param delay Milliseconds from now until the step is due
+     */
+    void scheduleAdvance(int car, long long delay);
+
+    /**
+     * Reads an input file in the Floor format into hall calls, each timed at its
+     * recorded offset from the first event. Times that go backwards keep the previous offset.
+     * @param fileName The input file containing event data
+     * @param calls Output, each call with its offset in milliseconds
+     * @return False if the file could not be opened
+     */
+    static bool readFile(const std::string& fileName, std::vector<std::pair<long long, Event>>& calls);
+
+    /**
+     * Reads an input file in the Floor format and schedules each line at its
+     * recorded offset from the first event
+     * @param fileName The input file containing event data
+     * @return False if the file could not be opened
+     */
+    bool loadFile(const std::string& fileName);
+
+    /**
+     * Schedules a floor request
+     * @param at Simulated time of the hall call in milliseconds
+     * @param event The floor event
+     */
+    void addFloorEvent(long long at, const Event& event);
+
+    /**
+     * Assigns a floor request to an elevator, as Scheduler::run does. With a batch window
+     * set on the scheduler the call is held until the window closes.
+     * @param event The floor event
+     */
+    void handleFloorEvent(Event event);
+
+    /**
+     * Feeds an elevator response back to the scheduler and counts completions. A hall
+     * call handed back by a faulted car is assigned again.
+     * @param response The elevator response event
+     */
+    void handleElevatorResponse(const Event& response);
+
+    /**
+     * Sets a function told of each request as it finishes, at the simulated time it finishes
+     * @param handler Called with the completion message
+     */
+    void setCompletionHandler(std::function<void(const Event&)> handler) { onComplete = std::move(handler); }
+
+    /**
+     * Runs scheduled actions in time order until none are left
+     */
+    void run();
+
+    /**
+     * Runs scheduled actions in time order up to a time, then moves the clock to it
+     * @param timeMs The last simulated time to run actions at
+     */
+    void runUntil(long long timeMs);
+
+    /**
+     * Writes the whole simulation to a compact binary file: the clock, the actions still
+     * to run (hall calls not yet made, car steps and batch windows), every car and the
+     * scheduler with its metrics. It fails while work passed to schedule() is pending,
+     * since that cannot be written out.
+     * @param fileName The file, replaced if it exists
+     * @return False if the state could not be written
+     */
+    bool saveCheckpoint(const std::string& fileName);
+
+    /**
+     * Creates a simulation from a checkpoint, with as many cars as it was saved with.
+     * Running it carries on from where the saved simulation stopped, and gives the same
+     * results; the scheduler's policy and batch window can be changed first to branch off.
+     * @param fileName The checkpoint
+     * @param speedFactor Pacing against the wall clock, 0 runs as fast as possible
+     * @return The simulation, or null if the file is missing, cut off or not a checkpoint
+     */
+    static std::unique_ptr<Simulation> restoreCheckpoint(const std::string& fileName, double speedFactor = 0);
+
+    int getTotalEvents() const { return totalEvents; }
+    int getCompletedEvents() const { return completedEvents; }
+    Scheduler& getScheduler() { return scheduler; }
+    ElevatorSubsystem& getElevatorSubsystem(int id) { return *elevatorSubsystems[id]; }
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,146 @@
+#include "SweepRunner.h"
+#include "Simulation.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+namespace {
+
+const char* policyName(DispatchPolicy policy) {
+    switch (policy) {
+        case DispatchPolicy::DISPATCH_LOOK: return "look";
+        case DispatchPolicy::DISPATCH_ETA: return "eta";
+        default: return "heuristic";
+    }
+}
+
+// Raises the log level for the life of a sweep and puts the caller's level back however it ends
+class QuietLogs {
+public:
+    QuietLogs() : level(Logger::getLevel()) { Logger::setLevel(std::max(level, LOG_LEVEL_WARN)); }
+    ~QuietLogs() { Logger::setLevel(level); }
+    QuietLogs(const QuietLogs&) = delete;
+    QuietLogs& operator=(const QuietLogs&) = delete;
+
+private:
+    int level;
+};
+
+} // namespace
+
+/**
+ * Constructor for the SweepRunner class
+ * @param calls The traffic, each hall call with its time in milliseconds
+ */
+SweepRunner::SweepRunner(std::vector<std::pair<long long, Event>> calls)
+    : traffic(std::move(calls)), jitter(SWEEP_DEFAULT_JITTER_MS), threads(0), nextRun(0) {}
+
+/**
+ * Adds a configuration to run
+ * @param config The fleet size and dispatch settings
+ */
+void SweepRunner::add(const Config& config) {
+    results.push_back(std::make_unique<Result>());
+    results.back()->config = config;
+}
+
+/**
+ * Runs every configuration once per seed, in parallel
+ * @param seeds Runs per configuration, seeded 1 to seeds
+ * @return One result per configuration, in the order they were added
+ */
+const std::vector<std::unique_ptr<SweepRunner::Result>>& SweepRunner::run(int seeds) {
+    size_t total = results.size() * static_cast<size_t>(std::max(seeds, 0));
+    if (total == 0) {
+        return results;
+    }
+    size_t workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, total);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        // Thousands of runs would each log every step, so only warnings get through while they run
+        QuietLogs quiet;
+        nextRun = 0;
+        std::vector<std::thread> pool;
+        for (size_t i = 0; i < workers; i++) {
+            pool.emplace_back([this, total, seeds]() {
+                size_t job;
+                while ((job = nextRun.fetch_add(1, std::memory_order_relaxed)) < total) {
+                    Result& result = *results[job / seeds];
+                    int seed = static_cast<int>(job % seeds) + 1;
+                    try {
+                        runOne(result, seed);
+                    } catch (const std::exception& e) {
+                        LOG_ERROR("Sweep run " << result.config.cars << " cars, seed " << seed << " failed: " << e.what());
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : pool) {
+            worker.join();
+        }
+    }
+
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Sweep ran " << total << " simulations on " << workers << " threads in " << millis << " ms");
+    return results;
+}
+
+/**
+ * Replays the traffic once for a configuration and merges what it measured into the result
+ * @param result The configuration's result
+ * @param seed Chooses how far each hall call moves
+ */
+void SweepRunner::runOne(Result& result, int seed) {
+    const Config& config = result.config;
+    Simulation simulation(config.cars);
+    simulation.getScheduler().setDispatchPolicy(config.policy);
+    simulation.getScheduler().setBatchWindow(config.batchWindowMs);
+
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<long long> shift(-jitter, jitter);
+    long long firstCall = -1;
+    for (const auto& [at, event] : traffic) {
+        long long moved = std::max(0LL, at + shift(random));
+        firstCall = (firstCall < 0) ? moved : std::min(firstCall, moved);
+        simulation.addFloorEvent(moved, event);
+    }
+    long long lastCompletion = 0;
+    simulation.setCompletionHandler([&](const Event&) { lastCompletion = simulation.now(); });
+    simulation.run();
+
+    const PassengerMetrics::TripHistograms& trips = simulation.getScheduler().getMetrics().getOverall();
+    result.wait.add(trips.wait);
+    result.held.add(simulation.getScheduler().getHeldMillis());
+    result.journey.add(trips.journey);
+
+    long long span = lastCompletion - firstCall;
+    double tripsPerHour = span > 0 ? simulation.getCompletedEvents() * 3600000.0 / span : 0;
+    std::lock_guard<std::mutex> lock(resultMtx);
+    result.runs++;
+    result.calls += simulation.getTotalEvents();
+    result.completed += simulation.getCompletedEvents();
+    result.tripsPerHour += (tripsPerHour - result.tripsPerHour) / result.runs;
+}
+
+/**
+ * Prints one row per configuration: average waiting time with the part of it spent held in
+ * batch windows, journey time and throughput
+ */
+void SweepRunner::printTable() const {
+    std::printf("%5s %-10s %9s %6s %9s %8s %8s %8s %10s %10s %9s\n", "cars", "policy", "window ms", "runs",
+                "served %", "AWT s", "held ms", "wait p95", "journey s", "jrny p95", "trips/h");
+    for (const std::unique_ptr<Result>& result : results) {
+        const Config& config = result->config;
+        double served = result->calls > 0 ? 100.0 * result->completed / result->calls : 0;
+        std::printf("%5d %-10s %9d %6d %9.1f %8.1f %8.0f %8.1f %10.1f %10.1f %9.0f\n", config.cars,
+                    policyName(config.policy), config.batchWindowMs, result->runs, served,
+                    result->wait.mean() / 1000.0, result->held.mean(), result->wait.percentile(95) / 1000.0,
+                    result->journey.mean() / 1000.0, result->journey.percentile(95) / 1000.0,
+                    result->tripsPerHour);
+    }
+}
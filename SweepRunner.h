@@ -0,0 +1,96 @@
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Event.h"
+#include "ElevatorEnums.h"
+#include "Metrics.h"
+
+#define SWEEP_DEFAULT_JITTER_MS 30000   // Each hall call moves by up to this much either way in a seeded run
+
+/**
+ * Runs the same traffic against many building configurations, many times each, on every
+ * core. A configuration is a fleet size, a dispatch policy and a batch window; each of its
+ * runs replays the traffic with every hall call moved by a random amount, drawn from the
+ * run's seed, so the results describe the spread of days like the recorded one rather
+ * than one replay of it.
+ *
+ * Each run is a Simulation on its own virtual clock. It opens no endpoints and shares no
+ * state with other runs, so any number run side by side in one process; worker threads
+ * take runs from a shared counter until all are done. Wait and journey times of every
+ * run are merged into the configuration's histograms.
+ */
+class SweepRunner {
+public:
+    struct Config {
+        int cars;
+        DispatchPolicy policy;
+        int batchWindowMs;
+    };
+
+    // Everything measured for one configuration, across all of its runs
+    struct Result {
+        Config config;
+        int runs = 0;
+        long long calls = 0;            // Hall calls made, summed over runs
+        long long completed = 0;        // Hall calls served to their destination
+        double tripsPerHour = 0;        // Mean over runs of trips finished per simulated hour
+        HdrHistogram wait;              // Hall call until the car arrives, every trip of every run
+        HdrHistogram held;              // Time calls spent in batch windows, already part of wait
+        HdrHistogram journey;           // Hall call until the car reaches the destination
+    };
+
+    /**
+     * Constructor for the SweepRunner class
+     * @param calls The traffic, each hall call with its time in milliseconds
+     */
+    explicit SweepRunner(std::vector<std::pair<long long, Event>> calls);
+
+    /**
+     * Adds a configuration to run
+     * @param config The fleet size and dispatch settings
+     */
+    void add(const Config& config);
+
+    /**
+     * Sets how far each seeded run may move a hall call from its recorded time
+     * @param jitterMs Milliseconds either way; 0 replays the traffic as recorded every time
+     */
+    void setJitter(long long jitterMs) { jitter = std::max(jitterMs, 0LL); }
+
+    /**
+     * Sets the number of worker threads
+     * @param count Threads to run simulations on, 0 for one per core
+     */
+    void setThreads(int count) { threads = std::max(count, 0); }
+
+    /**
+     * Runs every configuration once per seed, in parallel
+     * @param seeds Runs per configuration, seeded 1 to seeds
+     * @return One result per configuration, in the order they were added
+     */
+    const std::vector<std::unique_ptr<Result>>& run(int seeds);
+
+    /**
+     * Prints one row per configuration: average waiting time, journey time and throughput
+     */
+    void printTable() const;
+
+private:
+    std::vector<std::pair<long long, Event>> traffic;
+    std::vector<std::unique_ptr<Result>> results;
+    long long jitter;
+    int threads;
+    std::atomic<size_t> nextRun;
+    std::mutex resultMtx;           // Guards the counters of every result
+
+    void runOne(Result& result, int seed);
+};
+
+#endif // SWEEP_RUNNER_H
@@ -0,0 +1,234 @@
+#include "TimingWheel.h"
+#include <algorithm>
+#include <bit>
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_RANGE (1LL << (WHEEL_SLOT_BITS * WHEEL_LEVELS))  // Ticks the levels cover
+
+/**
+ * Constructor for the TimingWheel class
+ * @param startMs The time of the first tick
+ */
+TimingWheel::TimingWheel(long long startMs) : freeNodes(NONE), currentTick(startMs), pending(0) {
+    std::fill(std::begin(heads), std::end(heads), NONE);
+    std::fill(std::begin(tails), std::end(tails), NONE);
+    std::fill(std::begin(occupied), std::end(occupied), 0);
+}
+
+/**
+ * Schedules a callback at an absolute time
+ * @param expiryMs When the callback is due
+ * @param callback The work to run
+ * @return An id for cancel
+ */
+TimingWheel::TimerId TimingWheel::scheduleAt(long long expiryMs, std::function<void()> callback) {
+    int32_t index;
+    if (freeNodes != NONE) {
+        index = freeNodes;
+        freeNodes = nodes[index].next;
+    } else {
+        index = static_cast<int32_t>(nodes.size());
+        nodes.push_back(Node{0, NONE, NONE, NONE, 1, nullptr});
+    }
+    nodes[index].expiry = expiryMs;
+    nodes[index].callback = std::move(callback);
+    place(index);
+    pending++;
+    return (static_cast<TimerId>(nodes[index].generation) << 32) | static_cast<uint32_t>(index + 1);
+}
+
+/**
+ * Cancels a timer that has not fired
+ * @param id The id returned when it was scheduled
+ * @return False if the timer already fired or was cancelled
+ */
+bool TimingWheel::cancel(TimerId id) {
+    int64_t index = static_cast<int64_t>(static_cast<uint32_t>(id)) - 1;
+    if (index < 0 || index >= static_cast<int64_t>(nodes.size())) {
+        return false;
+    }
+    Node& node = nodes[index];
+    if (node.generation != static_cast<uint32_t>(id >> 32) || node.slot == NONE) {
+        return false;
+    }
+    if (node.slot != FIRING) {
+        unlink(static_cast<int32_t>(index));
+    }
+    release(static_cast<int32_t>(index));
+    return true;
+}
+
+/**
+ * Links a timer into the slot its expiry falls in: level 0 for the next 64 ticks, then
+ * the lowest level whose span still reaches it
+ * @param index The timer
+ */
+void TimingWheel::place(int32_t index) {
+    Node& node = nodes[index];
+    long long expiry = node.expiry;
+    long long delta = expiry - currentTick;
+    int level = 0;
+    if (delta < 0) {
+        // Overdue: runs on the next tick processed
+        expiry = currentTick;
+    } else if (delta >= WHEEL_RANGE) {
+        // Beyond the wheel: parked in the last level and placed again when it turns
+        level = WHEEL_LEVELS - 1;
+        expiry = currentTick + WHEEL_RANGE - 1;
+    } else {
+        while (level < WHEEL_LEVELS - 1 && delta >= (1LL << (WHEEL_SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+    }
+    int slot = static_cast<int>((expiry >> (WHEEL_SLOT_BITS * level)) & WHEEL_MASK);
+    int list = level * WHEEL_SLOTS + slot;
+
+    node.slot = list;
+    node.next = NONE;
+    node.prev = tails[list];
+    if (tails[list] != NONE) {
+        nodes[tails[list]].next = index;
+    } else {
+        heads[list] = index;
+        occupied[level] |= uint64_t(1) << slot;
+    }
+    tails[list] = index;
+}
+
+/**
+ * Takes a timer out of its slot
+ * @param index The timer
+ */
+void TimingWheel::unlink(int32_t index) {
+    Node& node = nodes[index];
+    int list = node.slot;
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[list] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes[node.next].prev = node.prev;
+    } else {
+        tails[list] = node.prev;
+    }
+    if (heads[list] == NONE) {
+        occupied[list / WHEEL_SLOTS] &= ~(uint64_t(1) << (list % WHEEL_SLOTS));
+    }
+}
+
+/**
+ * Returns a timer's node to the free list
+ * @param index The timer
+ */
+void TimingWheel::release(int32_t index) {
+    Node& node = nodes[index];
+    node.slot = NONE;
+    node.generation++;
+    node.callback = nullptr;
+    node.next = freeNodes;
+    freeNodes = index;
+    pending--;
+}
+
+/**
+ * Spreads the timers of one slot over the levels below
+ * @param level The level
+ * @param slot The slot
+ */
+void TimingWheel::cascade(int level, int slot) {
+    int list = level * WHEEL_SLOTS + slot;
+    int32_t index = heads[list];
+    heads[list] = NONE;
+    tails[list] = NONE;
+    occupied[level] &= ~(uint64_t(1) << slot);
+    while (index != NONE) {
+        int32_t next = nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+/**
+ * Runs the timers in a level 0 slot, including any a callback adds to it
+ * @param slot The slot
+ * @return The number of callbacks run
+ */
+size_t TimingWheel::runSlot(int slot) {
+    size_t ran = 0;
+    while (heads[slot] != NONE) {
+        // Take the list off the wheel first so callbacks can change the wheel freely
+        for (int32_t index = heads[slot]; index != NONE; index = nodes[index].next) {
+            nodes[index].slot = FIRING;
+            firing.push_back(index);
+        }
+        heads[slot] = NONE;
+        tails[slot] = NONE;
+        occupied[0] &= ~(uint64_t(1) << slot);
+
+        for (int32_t index : firing) {
+            if (nodes[index].slot != FIRING) {
+                continue;   // Cancelled by an earlier callback
+            }
+            std::function<void()> callback = std::move(nodes[index].callback);
+            release(index);
+            callback();
+            ran++;
+        }
+        firing.clear();
+    }
+    return ran;
+}
+
+/**
+ * Runs every callback due at or before a time
+ * @param nowMs The current time
+ * @return The number of callbacks run
+ */
+size_t TimingWheel::advance(long long nowMs) {
+    size_t ran = 0;
+    while (currentTick <= nowMs) {
+        int index = static_cast<int>(currentTick & WHEEL_MASK);
+        if (index == 0) {
+            // Each level turns one slot when every level below it has wrapped
+            for (int level = 1; level < WHEEL_LEVELS; level++) {
+                int slot = static_cast<int>((currentTick >> (WHEEL_SLOT_BITS * level)) & WHEEL_MASK);
+                cascade(level, slot);
+                if (slot != 0) break;
+            }
+        }
+        ran += runSlot(index);
+        currentTick++;
+
+        // Jump over ticks with nothing to run or cascade
+        long long next = nextExpiry();
+        if (next < 0 || next > nowMs) {
+            currentTick = nowMs + 1;
+        } else if (next > currentTick) {
+            currentTick = next;
+        }
+    }
+    return ran;
+}
+
+/**
+ * Finds when advance next has work to do
+ * @return The time, or -1 if no timer is pending
+ */
+long long TimingWheel::nextExpiry() const {
+    long long earliest = -1;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        if (!occupied[level]) {
+            continue;
+        }
+        // The level turns a slot at each multiple of its span; find the next occupied one
+        long long span = 1LL << (WHEEL_SLOT_BITS * level);
+        long long start = (currentTick + span - 1) & ~(span - 1);
+        int index = static_cast<int>((start >> (WHEEL_SLOT_BITS * level)) & WHEEL_MASK);
+        long long due = start + std::countr_zero(std::rotr(occupied[level], index)) * span;
+        if (earliest < 0 || due < earliest) {
+            earliest = due;
+        }
+    }
+    return earliest;
+}
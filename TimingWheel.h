@@ -0,0 +1,113 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)  // Slots per level, one bit each in the level's mask
+
+/**
+ * Hierarchical timing wheel with a tick of one millisecond. Level 0 has a slot for each
+ * of the next 64 ticks, level 1 a slot for each of the next 64 spans of 64 ticks, and so
+ * on, so four levels cover about 4.6 hours; later timers wait in the last level and are
+ * placed again as it turns. A timer is linked into the slot its expiry falls in, which
+ * makes scheduling and cancelling O(1). When level 0 wraps, the next slot of the level
+ * above is spread over level 0. Empty stretches are skipped using the occupancy masks.
+ *
+ * Not thread safe: the owner serialises calls. Callbacks run inside advance() and may
+ * schedule or cancel timers, including ones due in the same call.
+ */
+class TimingWheel {
+public:
+    typedef uint64_t TimerId;   // 0 never names a timer
+
+    /**
+     * Constructor for the TimingWheel class
+     * @param startMs The time of the first tick
+     */
+    explicit TimingWheel(long long startMs = 0);
+
+    /**
+     * Schedules a callback at an absolute time
+     * @param expiryMs When the callback is due; a time already passed is due on the next advance
+     * @param callback The work to run
+     * @return An id for cancel
+     */
+    TimerId scheduleAt(long long expiryMs, std::function<void()> callback);
+
+    /**
+     * Schedules a callback after a delay from the wheel's current time
+     * @param delayMs Milliseconds from now()
+     * @param callback The work to run
+     * @return An id for cancel
+     */
+    TimerId schedule(long long delayMs, std::function<void()> callback) {
+        return scheduleAt(currentTick + delayMs, std::move(callback));
+    }
+
+    /**
+     * Cancels a timer that has not fired
+     * @param id The id returned when it was scheduled
+     * @return False if the timer already fired or was cancelled
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * Runs every callback due at or before a time, in expiry order
+     * @param nowMs The current time
+     * @return The number of callbacks run
+     */
+    size_t advance(long long nowMs);
+
+    /**
+     * Finds when advance next has work to do. The wheel does not keep exact expiries
+     * for far timers, so this may be earlier than the first one, but never later.
+     * @return The time, or -1 if no timer is pending
+     */
+    long long nextExpiry() const;
+
+    /**
+     * Gets the first tick advance has not yet processed
+     * @return The time in milliseconds
+     */
+    long long now() const { return currentTick; }
+
+    /**
+     * Gets the number of pending timers
+     * @return The count
+     */
+    size_t size() const { return pending; }
+
+private:
+    static constexpr int32_t NONE = -1;
+    static constexpr int32_t FIRING = -2;  // Slot of a timer taken off the wheel to run
+
+    struct Node {
+        long long expiry;
+        int32_t prev;
+        int32_t next;
+        int32_t slot;               // Index into heads, NONE when free, FIRING when about to run
+        uint32_t generation;        // Bumped whenever the node is freed, so old ids stop matching
+        std::function<void()> callback;
+    };
+
+    std::vector<Node> nodes;
+    int32_t freeNodes;                          // Free list threaded through next
+    int32_t heads[WHEEL_LEVELS * WHEEL_SLOTS];
+    int32_t tails[WHEEL_LEVELS * WHEEL_SLOTS];
+    uint64_t occupied[WHEEL_LEVELS];            // Bit per non-empty slot
+    long long currentTick;
+    size_t pending;
+    std::vector<int32_t> firing;                // Timers being run by advance
+
+    void place(int32_t index);
+    void unlink(int32_t index);
+    void release(int32_t index);
+    void cascade(int level, int slot);
+    size_t runSlot(int slot);
+};
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,190 @@
+#include "TraceReader.h"
+#include "Logger.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Finds the next whitespace separated token
+ * @param cursor Start of the search, moved past the token
+ * @param end End of the line
+ * @param tokenEnd Set to the end of the token
+ * @return Start of the token, or null if the line has no more tokens
+ */
+const char* nextToken(const char*& cursor, const char* end, const char*& tokenEnd) {
+    while (cursor < end && isSpace(*cursor)) cursor++;
+    if (cursor == end) return nullptr;
+    const char* start = cursor;
+    while (cursor < end && !isSpace(*cursor)) cursor++;
+    tokenEnd = cursor;
+    return start;
+}
+
+/**
+ * Parses a whole token as an integer
+ * @return False if the token is not a number
+ */
+bool parseInt(const char* begin, const char* end, int& value) {
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+/**
+ * Compares a token with a lower case word, ignoring the token's case
+ */
+bool matchesWord(const char* begin, const char* end, const char* word) {
+    size_t length = strlen(word);
+    if (static_cast<size_t>(end - begin) != length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if ((begin[i] | 0x20) != word[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * Fills an event with this request
+ * @param event The event to overwrite
+ */
+void TraceRecord::toEvent(Event& event) const {
+    char digits[12];
+    auto result = std::to_chars(digits, digits + sizeof(digits), floor);
+    event.time.assign(time);
+    event.source.assign(digits, result.ptr - digits);
+    event.floorButton.assign(direction == DIRECTION_UP ? "UP" : "DOWN");
+    event.elevatorButton = destination;
+    event.isFromFloor = true;
+    event.assignedElevator = 0;
+    event.currentFloor = 0;
+    event.riders = 0;
+    event.isComplete = false;
+    event.fault = fault;
+}
+
+/**
+ * Maps an input file
+ * @param fileName The input file containing event data
+ */
+TraceReader::TraceReader(const std::string& fileName)
+    : fd(open(fileName.c_str(), O_RDONLY | O_CLOEXEC)), data(nullptr), size(0), position(0),
+      lineNumber(0), malformedLines(0) {
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        return; // Nothing to map; next() returns no records
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        fd = -1;
+        size = 0;
+        return;
+    }
+    data = static_cast<const char*>(mapped);
+    madvise(mapped, size, MADV_SEQUENTIAL);
+}
+
+/**
+ * Unmaps and closes the file
+ */
+TraceReader::~TraceReader() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * Parses one line
+ * @param begin First character of the line
+ * @param end End of the line, not including the newline
+ * @param record Filled in on success
+ * @return False if the line is malformed
+ */
+bool TraceReader::parseLine(const char* begin, const char* end, TraceRecord& record) {
+    const char* cursor = begin;
+    const char* tokenEnd = nullptr;
+
+    const char* time = nextToken(cursor, end, tokenEnd);
+    if (!time || tokenEnd - time > TRACE_TIME_LENGTH) return false;
+    record.timeMs = Event::timeToMillis(time, tokenEnd - time);
+    if (record.timeMs < 0) return false;
+    memcpy(record.time, time, tokenEnd - time);
+    record.time[tokenEnd - time] = '\0';
+
+    const char* floor = nextToken(cursor, end, tokenEnd);
+    if (!floor || !parseInt(floor, tokenEnd, record.floor)) return false;
+
+    const char* button = nextToken(cursor, end, tokenEnd);
+    if (!button) return false;
+    if (matchesWord(button, tokenEnd, "up")) {
+        record.direction = DIRECTION_UP;
+    } else if (matchesWord(button, tokenEnd, "down")) {
+        record.direction = DIRECTION_DOWN;
+    } else {
+        return false;
+    }
+
+    const char* destination = nextToken(cursor, end, tokenEnd);
+    if (!destination || !parseInt(destination, tokenEnd, record.destination)) return false;
+
+    const char* fault = nextToken(cursor, end, tokenEnd);
+    if (!fault || !parseInt(fault, tokenEnd, record.fault)) return false;
+
+    // Anything after the fault column is a comment
+    record.line = lineNumber;
+    return true;
+}
+
+/**
+ * Parses the next batch of requests
+ * @param records Where to put them
+ * @param capacity The most records to return
+ * @return The number of records, 0 once the file is finished
+ */
+size_t TraceReader::next(TraceRecord* records, size_t capacity) {
+    size_t count = 0;
+    while (count < capacity && position < size) {
+        const char* begin = data + position;
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', size - position));
+        const char* end = newline ? newline : data + size;
+        position = newline ? (newline - data) + 1 : size;
+        lineNumber++;
+
+        if (lineNumber <= TRACE_HEADER_LINES) {
+            continue;
+        }
+        const char* cursor = begin;
+        while (cursor < end && isSpace(*cursor)) cursor++;
+        if (cursor == end) {
+            continue; // Blank line
+        }
+        if (parseLine(begin, end, records[count])) {
+            count++;
+        } else {
+            malformedLines++;
+            LOG_ERROR("Error with line " << lineNumber << ": " << std::string(begin, end));
+        }
+    }
+    return count;
+}
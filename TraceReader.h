@@ -0,0 +1,89 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <cstddef>
+#include <string>
+#include "Event.h"
+
+#define TRACE_HEADER_LINES 2    // Column names and format lines at the top of every input file
+#define TRACE_TIME_LENGTH 15    // Longest timestamp kept, enough for hh:mm:ss.mmm
+
+/**
+ * One parsed input line: Time Floor FloorButton CarButton Fault
+ */
+struct TraceRecord {
+    long long line;                         // Line number in the file, counting from 1
+    char time[TRACE_TIME_LENGTH + 1];       // Timestamp as written, null terminated
+    long long timeMs;                       // Timestamp in milliseconds since midnight
+    int floor;                              // Floor the hall call was made on
+    Direction direction;                    // Hall button pressed
+    int destination;                        // Floor button pressed in the car
+    int fault;                              // Fault to inject
+
+    /**
+     * Fills an event with this request. The event's strings are short enough
+     * to stay in their own storage, so reusing one event does not allocate.
+     * @param event The event to overwrite
+     */
+    void toEvent(Event& event) const;
+};
+
+/**
+ * Streams floor requests out of an input file mapped into memory. Lines are parsed in
+ * place with std::from_chars and handed out in batches, so reading allocates nothing
+ * per line. Malformed lines are logged with their line number and skipped.
+ */
+class TraceReader {
+private:
+    int fd;
+    const char* data;       // The mapped file
+    size_t size;
+    size_t position;        // Start of the next unread line
+    long long lineNumber;   // Lines read so far
+    long long malformedLines;
+
+    bool parseLine(const char* begin, const char* end, TraceRecord& record);
+
+public:
+    /**
+     * Maps an input file
+     * @param fileName The input file containing event data
+     */
+    explicit TraceReader(const std::string& fileName);
+
+    /**
+     * Unmaps and closes the file
+     */
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /**
+     * Checks if the file could be opened and mapped
+     * @return True if the file is readable
+     */
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * Parses the next batch of requests
+     * @param records Where to put them
+     * @param capacity The most records to return
+     * @return The number of records, 0 once the file is finished
+     */
+    size_t next(TraceRecord* records, size_t capacity);
+
+    /**
+     * Gets the number of lines skipped because they could not be parsed
+     * @return The count of malformed lines
+     */
+    long long getMalformedLines() const { return malformedLines; }
+
+    /**
+     * Gets the number of lines read so far, including the header
+     * @return The line count
+     */
+    long long getLineNumber() const { return lineNumber; }
+};
+
+#endif // TRACE_READER_H
@@ -0,0 +1,657 @@
+#include "Transport.h"
+#include "Logger.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define TRANSPORT_MAX_ADDRESS 65536    // One mailbox slot per port number
+
+namespace {
+
+/**
+ * Endpoint that sends datagrams to other ports on 127.0.0.1
+ */
+class UdpEndpoint : public Endpoint {
+private:
+    std::unique_ptr<DatagramSocket> receiveSocket;    // Bound to the endpoint's port, null if send-only
+    std::unique_ptr<DatagramBufferPool> receivePool;  // Buffers sized from the receive socket
+    DatagramSocket sendSocket;
+    DatagramBatch outbound;     // Events waiting for the next flush
+    DatagramBatch inbound;      // Packets taken on each receive, into buffers from the pool
+
+public:
+    /**
+     * Constructor for the UdpEndpoint class
+     * @param address The port to bind, or -1 for send-only
+     */
+    explicit UdpEndpoint(int address)
+        : receiveSocket(address >= 0 ? std::make_unique<DatagramSocket>(address) : nullptr),
+          receivePool(receiveSocket ? std::make_unique<DatagramBufferPool>(*receiveSocket) : nullptr),
+          inbound(receivePool ? DatagramBatch(*receivePool) : DatagramBatch(0)) {}
+
+    int fd() const override { return receiveSocket ? receiveSocket->fd() : -1; }
+
+    void send(int address, const Event& event) override {
+        if (outbound.full()) flush();
+        size_t length = event.event_to_bytes(outbound.slot(), outbound.slotSize());
+        outbound.push(length, InetAddress::getLocalHost(), address);
+    }
+
+    void flush() override {
+        if (outbound.size() > 0) {
+            sendSocket.sendBatch(outbound);
+        }
+    }
+
+    size_t receive(std::vector<Event>& events) override {
+        events.clear();
+        if (!receiveSocket) {
+            return 0;
+        }
+        receiveSocket->receiveBatch(inbound, false);
+        for (size_t i = 0; i < inbound.size(); i++) {
+            if (inbound.truncated(i)) {
+                LOG_WARN("Dropped a datagram larger than " << receiveSocket->receiveSize() << " bytes");
+                continue;
+            }
+            // The buffer goes back to the pool once its event is decoded
+            PooledBuffer buffer = inbound.take(i);
+            events.push_back(Event::bytes_to_event(buffer.data(), inbound.getLength(i)));
+        }
+        return events.size();
+    }
+};
+
+} // namespace
+
+/**
+ * Events waiting for one in-process endpoint, and the eventfd that wakes its reactor
+ */
+class InProcessTransport::Mailbox {
+private:
+    std::unique_ptr<SpscQueue<Event>> single;   // Used when one thread sends here
+    std::unique_ptr<MpscQueue<Event>> shared;   // Used when many threads send here
+    int eventFd;
+    std::atomic<bool> signalled{false};         // Set while eventFd has been written and not yet read
+
+public:
+    /**
+     * Constructor for the Mailbox class
+     * @param senders Whether one or many threads send here
+     */
+    explicit Mailbox(Senders senders) : eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (eventFd < 0) {
+            throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+        }
+        if (senders == SENDERS_ONE) {
+            single = std::make_unique<SpscQueue<Event>>(MAILBOX_SIZE_SINGLE);
+        } else {
+            shared = std::make_unique<MpscQueue<Event>>(MAILBOX_SIZE_SHARED);
+        }
+    }
+
+    ~Mailbox() {
+        close(eventFd);
+    }
+
+    int fd() const { return eventFd; }
+
+    /**
+     * Adds an event, waiting for room if the mailbox is full, and wakes the receiver
+     * if it was idle. A sender must not wait on a mailbox its own thread drains.
+     * @param event The event, moved into the mailbox
+     */
+    void push(Event&& event) {
+        while (!(single ? single->push(std::move(event)) : shared->push(std::move(event)))) {
+            std::this_thread::yield();
+        }
+        signal();
+    }
+
+    /**
+     * Takes up to a batch of events. The receiver clears its wakeup before looking at the
+     * queue, so an event pushed after the last pop always writes the eventfd again.
+     * @param events Filled with the events taken
+     */
+    void take(std::vector<Event>& events) {
+        uint64_t wakeups;
+        if (read(eventFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+            LOG_ERROR("Error reading mailbox eventfd: " << strerror(errno));
+        }
+        signalled.store(false);
+
+        Event event;
+        while (events.size() < TRANSPORT_BATCH_SIZE && (single ? single->pop(event) : shared->pop(event))) {
+            events.push_back(std::move(event));
+        }
+        // Whatever is left is handled on the next wakeup
+        if (!(single ? single->empty() : shared->empty())) {
+            signal();
+        }
+    }
+
+private:
+    void signal() {
+        if (!signalled.exchange(true)) {
+            uint64_t one = 1;
+            if (write(eventFd, &one, sizeof(one)) < 0) {
+                LOG_ERROR("Error writing mailbox eventfd: " << strerror(errno));
+            }
+        }
+    }
+};
+
+namespace {
+
+/**
+ * Endpoint that moves events straight into the receiver's mailbox
+ */
+class InProcessEndpoint : public Endpoint {
+private:
+    InProcessTransport& transport;
+    InProcessTransport::Mailbox* mailbox;   // This endpoint's own mailbox, null if send-only
+
+public:
+    InProcessEndpoint(InProcessTransport& owner, InProcessTransport::Mailbox* own) : transport(owner), mailbox(own) {}
+
+    int fd() const override { return mailbox ? mailbox->fd() : -1; }
+
+    void send(int address, const Event& event) override {
+        send(address, Event(event));
+    }
+
+    void send(int address, Event&& event) override {
+        InProcessTransport::Mailbox* destination = transport.find(address);
+        if (!destination) {
+            LOG_WARN("Dropped event for port " << address << ", nothing is listening there");
+            return;
+        }
+        destination->push(std::move(event));
+    }
+
+    // Events are delivered as they are sent
+    void flush() override {}
+
+    size_t receive(std::vector<Event>& events) override {
+        events.clear();
+        if (mailbox) {
+            mailbox->take(events);
+        }
+        return events.size();
+    }
+};
+
+} // namespace
+
+/**
+ * Opens an endpoint on 127.0.0.1
+ * @param address The port to bind, or -1 for an endpoint that only sends
+ * @param senders Unused; any number of processes may send to a port
+ * @return The endpoint
+ */
+std::unique_ptr<Endpoint> UdpTransport::open(int address, Senders senders) {
+    (void)senders;
+    return std::make_unique<UdpEndpoint>(address);
+}
+
+/**
+ * Constructor for the InProcessTransport class
+ */
+InProcessTransport::InProcessTransport() : mailboxes(new std::atomic<Mailbox*>[TRANSPORT_MAX_ADDRESS]) {
+    for (int i = 0; i < TRANSPORT_MAX_ADDRESS; i++) {
+        mailboxes[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructor frees every mailbox. Endpoints must not be used afterwards.
+ */
+InProcessTransport::~InProcessTransport() {
+    for (int i = 0; i < TRANSPORT_MAX_ADDRESS; i++) {
+        delete mailboxes[i].load();
+    }
+}
+
+/**
+ * Opens an endpoint. A mailbox lives as long as the transport, so reopening an address
+ * after its endpoint is destroyed picks up anything still waiting there.
+ * @param address The port to receive on, or -1 for an endpoint that only sends
+ * @param senders Whether one or many threads send to this endpoint
+ * @return The endpoint
+ */
+std::unique_ptr<Endpoint> InProcessTransport::open(int address, Senders senders) {
+    if (address < 0) {
+        return std::make_unique<InProcessEndpoint>(*this, nullptr);
+    }
+    if (address >= TRANSPORT_MAX_ADDRESS) {
+        throw std::runtime_error("mailbox address out of range: " + std::to_string(address));
+    }
+    Mailbox* mailbox = mailboxes[address].load(std::memory_order_acquire);
+    if (!mailbox) {
+        Mailbox* created = new Mailbox(senders);
+        if (mailboxes[address].compare_exchange_strong(mailbox, created, std::memory_order_acq_rel)) {
+            mailbox = created;
+        } else {
+            delete created;
+        }
+    }
+    return std::make_unique<InProcessEndpoint>(*this, mailbox);
+}
+
+/**
+ * Finds the mailbox at an address
+ * @param address The port
+ * @return The mailbox, or null if nothing has opened the address
+ */
+InProcessTransport::Mailbox* InProcessTransport::find(int address) const {
+    if (address < 0 || address >= TRANSPORT_MAX_ADDRESS) {
+        return nullptr;
+    }
+    return mailboxes[address].load(std::memory_order_acquire);
+}
+
+#define RING_MAGIC 0x454C5652      // "ELVR"
+#define RING_VERSION 2
+#define RING_READY 2               // RingHeader::state once the segment is set up
+
+namespace {
+
+/**
+ * Start of a shared-memory segment, followed by RING_SLOTS slots. Only lock-free atomics
+ * are used, so the same segment works at a different address in every process.
+ */
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    std::atomic<uint32_t> state;                // 0 new, 1 being set up, RING_READY
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint64_t> head;   // Next position a sender claims
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint64_t> tail;   // Next position the receiver takes
+    alignas(QUEUE_CACHE_LINE) std::atomic<uint32_t> wakeups;  // Futex word, bumped after every send
+    std::atomic<uint32_t> sleeping;             // Set while the receiver waits on the futex
+};
+
+/**
+ * One event in a ring. The sequence number works as in MpscQueue: position when free,
+ * position + 1 when filled, position + RING_SLOTS once taken. Each slot has a cache line
+ * to itself, so senders filling neighbouring slots do not contend.
+ */
+struct alignas(QUEUE_CACHE_LINE) RingSlot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<int32_t> sender;                // Process filling the slot, 0 once taken
+    uint8_t record[EVENT_WIRE_SIZE];
+};
+
+static_assert(sizeof(RingSlot) == QUEUE_CACHE_LINE, "Ring slots should take one cache line each");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring atomics must be lock-free to be shared");
+
+long futex(std::atomic<uint32_t>* word, int operation, uint32_t value, const struct timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation, value, timeout, nullptr, 0);
+}
+
+long long steadyMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * A shared-memory segment mapped into this process
+ */
+class Ring {
+private:
+    int segmentFd;
+    size_t length;
+    RingHeader* header;
+    RingSlot* slots;
+    uint64_t mask;
+    long long stalledSince = 0;     // When the receiver first found the slot at tail claimed but empty
+
+public:
+    /**
+     * Maps a segment, creating and setting it up if this is the first process to use it
+     * @param name The shm_open name
+     */
+    explicit Ring(const std::string& name) : length(sizeof(RingHeader) + RING_SLOTS * sizeof(RingSlot)), mask(RING_SLOTS - 1) {
+        segmentFd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (segmentFd < 0) {
+            throw std::runtime_error("shm_open " + name + " failed: " + strerror(errno));
+        }
+        struct stat info;
+        // A new segment is empty; extending it fills it with zeros, which is state 0
+        if (fstat(segmentFd, &info) < 0 || (static_cast<size_t>(info.st_size) < length && ftruncate(segmentFd, length) < 0)) {
+            close(segmentFd);
+            throw std::runtime_error("sizing " + name + " failed: " + strerror(errno));
+        }
+        void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, segmentFd, 0);
+        if (mapping == MAP_FAILED) {
+            close(segmentFd);
+            throw std::runtime_error("mmap " + name + " failed: " + strerror(errno));
+        }
+        header = static_cast<RingHeader*>(mapping);
+        slots = reinterpret_cast<RingSlot*>(header + 1);
+        setUp(name);
+    }
+
+    ~Ring() {
+        munmap(header, length);
+        close(segmentFd);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    int fd() const { return segmentFd; }
+
+    /**
+     * Encodes an event into the next free slot and wakes the receiver
+     * @param event The event
+     * @return False if the ring is full
+     */
+    bool push(const Event& event) {
+        uint64_t position = header->head.load(std::memory_order_relaxed);
+        while (true) {
+            RingSlot& slot = slots[position & mask];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t lag = static_cast<int64_t>(sequence - position);
+            if (lag == 0) {
+                if (header->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.sender.store(getpid(), std::memory_order_relaxed);
+                    event.encode(slot.record, sizeof(slot.record));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                position = header->head.load(std::memory_order_relaxed);
+            }
+        }
+        header->wakeups.fetch_add(1);
+        if (header->sleeping.load()) {
+            futex(&header->wakeups, FUTEX_WAKE, INT32_MAX, nullptr);
+        }
+        return true;
+    }
+
+    /**
+     * Decodes the oldest event out of the ring. Receiver only. Repairs what a receiver or
+     * sender that died part way through left behind.
+     * @param event Receives the event
+     * @return False if nothing is ready
+     */
+    bool pop(Event& event) {
+        while (true) {
+            uint64_t position = header->tail.load(std::memory_order_relaxed);
+            RingSlot& slot = slots[position & mask];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position + 1) {
+                bool valid = Event::decode(slot.record, sizeof(slot.record), event);
+                release(slot, position);
+                if (valid) {
+                    return true;
+                }
+                LOG_WARN("Dropped a malformed record from shared memory");
+                continue;
+            }
+            if (static_cast<int64_t>(sequence - (position + 1)) > 0) {
+                // A previous receiver took this slot but stopped before moving tail on
+                header->tail.store(position + 1, std::memory_order_release);
+                continue;
+            }
+            if (header->head.load(std::memory_order_acquire) == position) {
+                return false;
+            }
+            // Claimed but not yet filled. A sender that is still alive will finish it.
+            pid_t sender = slot.sender.load(std::memory_order_relaxed);
+            bool senderAlive = sender > 0 && (kill(sender, 0) == 0 || errno == EPERM);
+            long long now = steadyMillis();
+            if (senderAlive || stalledSince == 0) {
+                stalledSince = senderAlive ? 0 : now;
+                return false;
+            }
+            if (now - stalledSince < RING_STALL_MS) {
+                return false;
+            }
+            LOG_WARN("Skipped an event a sender stopped writing " << now - stalledSince << "ms ago");
+            release(slot, position);
+        }
+    }
+
+    /**
+     * Checks whether the receiver has anything left to look at
+     * @return True if no slot has been claimed past tail
+     */
+    bool empty() const {
+        return header->head.load(std::memory_order_acquire) == header->tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Waits for a sender to bump the futex word. Receiver only.
+     * @param seen The value of the word the caller has already handled
+     * @return The new value of the word
+     */
+    uint32_t wait(uint32_t seen) {
+        header->sleeping.store(1);
+        if (header->wakeups.load() == seen) {
+            struct timespec timeout = {0, RING_POLL_MS * 1000000L};
+            futex(&header->wakeups, FUTEX_WAIT, seen, &timeout);
+        }
+        header->sleeping.store(0);
+        return header->wakeups.load();
+    }
+
+    uint32_t wakeups() const { return header->wakeups.load(); }
+
+    /**
+     * Wakes a receiver blocked in wait, such as when its endpoint is closing
+     */
+    void wake() {
+        header->wakeups.fetch_add(1);
+        futex(&header->wakeups, FUTEX_WAKE, INT32_MAX, nullptr);
+    }
+
+private:
+    void release(RingSlot& slot, uint64_t position) {
+        slot.sender.store(0, std::memory_order_relaxed);
+        slot.sequence.store(position + RING_SLOTS, std::memory_order_release);
+        header->tail.store(position + 1, std::memory_order_release);
+        stalledSince = 0;
+    }
+
+    /**
+     * Sets up a new segment, or waits for the process doing so. A segment left half set up
+     * by a process that died, or laid out by another version, is set up again.
+     * @param name The shm_open name, for errors
+     */
+    void setUp(const std::string& name) {
+        long long deadline = steadyMillis() + RING_STALL_MS;
+        uint32_t state = header->state.load(std::memory_order_acquire);
+        while (state == 1 && steadyMillis() < deadline) {
+            std::this_thread::yield();
+            state = header->state.load(std::memory_order_acquire);
+        }
+        if (state == RING_READY && header->magic == RING_MAGIC && header->version == RING_VERSION
+            && header->slots == RING_SLOTS) {
+            return;
+        }
+        if (!header->state.compare_exchange_strong(state, 1, std::memory_order_acq_rel)) {
+            if (state == RING_READY) {
+                return;
+            }
+            throw std::runtime_error("shared memory " + name + " is being set up by another process");
+        }
+        header->magic = RING_MAGIC;
+        header->version = RING_VERSION;
+        header->slots = RING_SLOTS;
+        header->head.store(0, std::memory_order_relaxed);
+        header->tail.store(0, std::memory_order_relaxed);
+        header->wakeups.store(0, std::memory_order_relaxed);
+        header->sleeping.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < RING_SLOTS; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+            slots[i].sender.store(0, std::memory_order_relaxed);
+        }
+        header->state.store(RING_READY, std::memory_order_release);
+    }
+};
+
+/**
+ * Endpoint that receives from its own segment and sends into the segments of others.
+ * A doorbell thread waits on the segment's futex and writes an eventfd for the reactor.
+ */
+class SharedMemoryEndpoint : public Endpoint {
+private:
+    const SharedMemoryTransport& transport;
+    std::unique_ptr<Ring> own;                          // Null if send-only
+    std::map<int, std::unique_ptr<Ring>> destinations;  // Segments sent to, mapped on first use
+    int eventFd = -1;
+    std::atomic<bool> signalled{false};                 // Set while eventFd has been written and not yet read
+    std::atomic<bool> closing{false};
+    std::thread doorbell;
+
+    void signal() {
+        if (!signalled.exchange(true)) {
+            uint64_t one = 1;
+            if (write(eventFd, &one, sizeof(one)) < 0) {
+                LOG_ERROR("Error writing endpoint eventfd: " << strerror(errno));
+            }
+        }
+    }
+
+    /**
+     * Rings the eventfd whenever a sender bumps the futex, and every RING_POLL_MS while
+     * events are waiting so a slot left by a dead sender is eventually skipped
+     */
+    void ring() {
+        uint32_t seen = own->wakeups();
+        // Events may have been left by a receiver that ran before this one
+        if (!own->empty()) signal();
+        while (!closing) {
+            uint32_t now = own->wait(seen);
+            if (now != seen || !own->empty()) {
+                seen = now;
+                signal();
+            }
+        }
+    }
+
+public:
+    SharedMemoryEndpoint(const SharedMemoryTransport& owner, int address) : transport(owner) {
+        if (address < 0) {
+            return;
+        }
+        own = std::make_unique<Ring>(transport.segmentName(address));
+        // The lock goes with the process, so a receiver that dies frees the address for its restart
+        if (flock(own->fd(), LOCK_EX | LOCK_NB) < 0) {
+            throw std::runtime_error("port " + std::to_string(address) + " already has a receiver");
+        }
+        eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0) {
+            throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+        }
+        doorbell = std::thread(&SharedMemoryEndpoint::ring, this);
+    }
+
+    ~SharedMemoryEndpoint() {
+        if (doorbell.joinable()) {
+            closing = true;
+            own->wake();
+            doorbell.join();
+        }
+        if (eventFd >= 0) {
+            close(eventFd);
+        }
+    }
+
+    int fd() const override { return eventFd; }
+
+    void send(int address, const Event& event) override {
+        std::unique_ptr<Ring>& destination = destinations[address];
+        if (!destination) {
+            destination = std::make_unique<Ring>(transport.segmentName(address));
+        }
+        long long deadline = 0;
+        while (!destination->push(event)) {
+            // The receiver may be restarting; give it a moment to drain
+            if (deadline == 0) {
+                deadline = steadyMillis() + RING_FULL_WAIT_MS;
+            } else if (steadyMillis() > deadline) {
+                LOG_WARN("Dropped event for port " << address << ", its shared memory ring is full");
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Events are delivered as they are sent
+    void flush() override {}
+
+    size_t receive(std::vector<Event>& events) override {
+        events.clear();
+        if (!own) {
+            return 0;
+        }
+        uint64_t wakeups;
+        if (read(eventFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+            LOG_ERROR("Error reading endpoint eventfd: " << strerror(errno));
+        }
+        signalled.store(false);
+
+        Event event;
+        while (events.size() < TRANSPORT_BATCH_SIZE && own->pop(event)) {
+            events.push_back(event);
+        }
+        if (events.size() == TRANSPORT_BATCH_SIZE && !own->empty()) {
+            signal();
+        }
+        return events.size();
+    }
+};
+
+} // namespace
+
+/**
+ * Constructor for the SharedMemoryTransport class
+ * @param name Prefix of the segment names; processes using the same name talk to each other
+ */
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name) : prefix(name) {}
+
+/**
+ * Opens an endpoint, mapping its segment
+ * @param address The port to receive on, or -1 for an endpoint that only sends
+ * @param senders Unused; every ring takes any number of senders
+ * @return The endpoint
+ */
+std::unique_ptr<Endpoint> SharedMemoryTransport::open(int address, Senders senders) {
+    (void)senders;
+    return std::make_unique<SharedMemoryEndpoint>(*this, address);
+}
+
+/**
+ * Deletes the segment at an address and anything still waiting in it
+ * @param address The port
+ */
+void SharedMemoryTransport::remove(int address) {
+    shm_unlink(segmentName(address).c_str());
+}
+
+/**
+ * Gets the name of the segment at an address
+ * @param address The port
+ * @return The name passed to shm_open
+ */
+std::string SharedMemoryTransport::segmentName(int address) const {
+    return "/" + prefix + "-" + std::to_string(address);
+}
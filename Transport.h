@@ -0,0 +1,167 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Event.h"
+#include "LockFreeQueue.h"
+
+#define TRANSPORT_BATCH_SIZE DATAGRAM_BATCH_SIZE    // Events taken per receive call
+#define MAILBOX_SIZE_SHARED 8192    // Slots in a mailbox many threads send to, such as the scheduler's
+#define MAILBOX_SIZE_SINGLE 1024    // Slots in a mailbox only one thread sends to
+#define RING_SLOTS 4096             // Events a shared-memory ring holds, a power of two
+#define RING_FULL_WAIT_MS 1000      // How long a sender waits on a full ring before dropping the event
+#define RING_STALL_MS 1000          // How long a slot claimed by a dead sender holds up the ring
+#define RING_POLL_MS 100            // How often a waiting receiver rechecks its ring without a wakeup
+
+/**
+ * Who sends to an endpoint, which lets the in-process transport pick a cheaper queue
+ */
+enum Senders {
+    SENDERS_ONE,    // Only one thread ever sends here, such as the scheduler to a floor or car
+    SENDERS_MANY    // Several threads send here, such as every car and the floor to the scheduler
+};
+
+/**
+ * One subsystem's connection to the others: a mailbox events are received from, and a way
+ * to send events to other endpoints. Endpoints are addressed by the port their subsystem
+ * listens on, so SCHEDULER_PORT, FLOOR_PORT and ELEVATOR_PORT_BASE + id work with every
+ * transport. One thread may send while another receives.
+ */
+class Endpoint {
+public:
+    virtual ~Endpoint() = default;
+
+    /**
+     * Gets a descriptor that is readable while events are waiting, for Reactor::addReadable
+     * @return The descriptor, or -1 for a send-only endpoint
+     */
+    virtual int fd() const = 0;
+
+    /**
+     * Queues a copy of an event for another endpoint. It may wait in a batch until flush().
+     * @param address The port of the receiving endpoint
+     * @param event The event
+     */
+    virtual void send(int address, const Event& event) = 0;
+
+    /**
+     * Queues an event for another endpoint, moving it when the transport allows
+     * @param address The port of the receiving endpoint
+     * @param event The event, left unspecified afterwards
+     */
+    virtual void send(int address, Event&& event) { send(address, static_cast<const Event&>(event)); }
+
+    /**
+     * Delivers everything queued by send
+     */
+    virtual void flush() = 0;
+
+    /**
+     * Takes the events waiting at this endpoint without blocking
+     * @param events Cleared, then filled with up to TRANSPORT_BATCH_SIZE events in arrival order
+     * @return The number of events taken
+     */
+    virtual size_t receive(std::vector<Event>& events) = 0;
+};
+
+/**
+ * Creates the endpoints the subsystems talk through
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    /**
+     * Opens an endpoint
+     * @param address The port to receive on, or -1 for an endpoint that only sends
+     * @param senders Whether one or many threads send to this endpoint
+     * @return The endpoint
+     */
+    virtual std::unique_ptr<Endpoint> open(int address, Senders senders) = 0;
+};
+
+/**
+ * Sends events as datagrams on 127.0.0.1 using the process-wide wire format, so the
+ * subsystems can also run in separate processes. Sends are batched into one sendmmsg
+ * per flush and receives take a whole batch per recvmmsg.
+ */
+class UdpTransport : public Transport {
+public:
+    std::unique_ptr<Endpoint> open(int address, Senders senders) override;
+};
+
+/**
+ * Passes Event objects between threads of one process through lock-free queues, with
+ * no serialisation and no system call per event. A mailbox with one sender is an
+ * SpscQueue and one with many senders an MpscQueue. Each mailbox has an eventfd that is
+ * written only when the mailbox goes from idle to having events, so a burst of sends
+ * wakes the receiver once. A sender that finds a mailbox full waits for it to drain.
+ */
+class InProcessTransport : public Transport {
+public:
+    class Mailbox;
+
+    InProcessTransport();
+    ~InProcessTransport();
+
+    InProcessTransport(const InProcessTransport&) = delete;
+    InProcessTransport& operator=(const InProcessTransport&) = delete;
+
+    std::unique_ptr<Endpoint> open(int address, Senders senders) override;
+
+    /**
+     * Finds the mailbox at an address
+     * @param address The port
+     * @return The mailbox, or null if nothing has opened the address
+     */
+    Mailbox* find(int address) const;
+
+private:
+    std::unique_ptr<std::atomic<Mailbox*>[]> mailboxes;     // One per port, created by open
+};
+
+/**
+ * Passes events between processes on one host through shared memory. Every address is
+ * a POSIX shared-memory segment holding one multi-producer ring of binary Event records,
+ * which senders encode straight into and the receiver decodes straight out of, so an
+ * event never passes through the kernel. Senders wake the receiver with a futex in the
+ * segment, and a thread in the receiving process turns that into an eventfd the reactor
+ * can wait on.
+ *
+ * Segments outlive the processes using them, so events sent while a receiver restarts
+ * are waiting for it when it comes back. Only one process may receive on an address at
+ * a time. A slot claimed by a sender that died before filling it is skipped after
+ * RING_STALL_MS. Events always use the binary wire format.
+ */
+class SharedMemoryTransport : public Transport {
+private:
+    std::string prefix;
+
+public:
+    /**
+     * Constructor for the SharedMemoryTransport class
+     * @param name Prefix of the segment names; processes using the same name talk to each other
+     */
+    explicit SharedMemoryTransport(const std::string& name = "elevator");
+
+    std::unique_ptr<Endpoint> open(int address, Senders senders) override;
+
+    /**
+     * Deletes the segment at an address and anything still waiting in it. Endpoints that
+     * have it open keep using their mapping.
+     * @param address The port
+     */
+    void remove(int address);
+
+    /**
+     * Gets the name of the segment at an address
+     * @param address The port
+     * @return The name passed to shm_open
+     */
+    std::string segmentName(int address) const;
+};
+
+#endif // TRANSPORT_H
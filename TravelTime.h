@@ -0,0 +1,73 @@
+#ifndef TRAVEL_TIME_H
+#define TRAVEL_TIME_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Motion and door timings of every car, in seconds
+#define TIME_BTWN_1_FLOOR 9
+#define TIME_BTWN_2_FLOORS 11
+#define TIME_BTWN_3_FLOORS 13
+#define TIME_BTWN_X_FLOORS_PER_FLOOR 4 // This is when floors is more than 3
+#define TIME_TO_LOAD_UNLOAD_1_PASSENGER 4 // A passenger loading/unloading
+#define TIME_TO_OPEN_CLOSE_DOOR 2 // Time to open and close door
+
+#define TRAVEL_TABLE_FLOORS 64  // Floors 0 to 63 are looked up, higher ones are computed
+
+/**
+ * Calculate move time between floors
+ * @param floorsToMove The number of floors travelled
+ * @return The time in seconds, 0 for no move
+ */
+inline int travelSeconds(int floorsToMove) {
+    floorsToMove = std::abs(floorsToMove);
+    if (floorsToMove == 0) {
+        return 0;
+    }
+    else if (floorsToMove == 1) {
+        return TIME_BTWN_1_FLOOR;
+    }
+    else if (floorsToMove == 2) {
+        return TIME_BTWN_2_FLOORS;
+    }
+    else if (floorsToMove == 3) {
+        return TIME_BTWN_3_FLOORS;
+    }
+    else {
+        return floorsToMove * TIME_BTWN_X_FLOORS_PER_FLOOR;
+    }
+}
+
+/**
+ * Milliseconds a car takes from one floor to another, computed once for every pair of
+ * floors so the scheduler can cost a route with lookups instead of the travel formula
+ */
+class TravelTimeTable {
+private:
+    std::vector<int32_t> millis;    // from * TRAVEL_TABLE_FLOORS + to
+
+public:
+    TravelTimeTable() : millis(TRAVEL_TABLE_FLOORS * TRAVEL_TABLE_FLOORS) {
+        for (int from = 0; from < TRAVEL_TABLE_FLOORS; from++) {
+            for (int to = 0; to < TRAVEL_TABLE_FLOORS; to++) {
+                millis[from * TRAVEL_TABLE_FLOORS + to] = travelSeconds(to - from) * 1000;
+            }
+        }
+    }
+
+    /**
+     * Gets the travel time between two floors
+     * @param from The floor the car leaves
+     * @param to The floor it stops at
+     * @return Milliseconds of travel, 0 if the floors are the same
+     */
+    int32_t at(int from, int to) const {
+        if (static_cast<unsigned>(from) < TRAVEL_TABLE_FLOORS && static_cast<unsigned>(to) < TRAVEL_TABLE_FLOORS) {
+            return millis[from * TRAVEL_TABLE_FLOORS + to];
+        }
+        return travelSeconds(to - from) * 1000;
+    }
+};
+
+#endif // TRAVEL_TIME_H
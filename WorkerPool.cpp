@@ -0,0 +1,120 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+/**
+ * Constructor for the WorkerPool class
+ * @param threads Worker threads to start; 0 starts one per core
+ */
+WorkerPool::WorkerPool(unsigned threads) : started(std::chrono::steady_clock::now()) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(&WorkerPool::work, this);
+    }
+    timerThread = std::thread(&WorkerPool::runTimers, this);
+}
+
+/**
+ * Destructor stops the workers
+ */
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+/**
+ * Queues a suspended coroutine to be resumed by a worker
+ * @param handle The coroutine
+ */
+void WorkerPool::resume(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        runQueue.push_back(handle);
+    }
+    ready.notify_one();
+}
+
+/**
+ * Queues a suspended coroutine to be resumed once a delay has passed
+ * @param delayMs Milliseconds to wait
+ * @param handle The coroutine
+ */
+void WorkerPool::resumeAfter(int delayMs, std::coroutine_handle<> handle) {
+    // Rounded up to the next whole millisecond so a sleep never ends early
+    long long nowUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+    long long due = (nowUs + delayMs * 1000LL + 999) / 1000;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        long long next = timers.nextExpiry();
+        earliest = next < 0 || due < next;
+        // Runs on the timer thread with the lock held
+        timers.scheduleAt(due, [this, handle]() { runQueue.push_back(handle); });
+    }
+    if (earliest) {
+        timerChanged.notify_one();
+    }
+}
+
+/**
+ * Reads the clock the timers are kept on
+ * @return Milliseconds since the pool started
+ */
+long long WorkerPool::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+/**
+ * Stops and joins every thread. Coroutines still queued or sleeping are not resumed.
+ */
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    ready.notify_all();
+    timerChanged.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    if (timerThread.joinable()) {
+        timerThread.join();
+    }
+}
+
+/**
+ * Worker loop: resumes queued coroutines until the pool stops
+ */
+void WorkerPool::work() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        ready.wait(lock, [this] { return stopping || !runQueue.empty(); });
+        if (stopping) {
+            return;
+        }
+        std::coroutine_handle<> handle = runQueue.front();
+        runQueue.pop_front();
+        lock.unlock();
+        // Runs until the coroutine's next co_await
+        handle.resume();
+        lock.lock();
+    }
+}
+
+/**
+ * Timer loop: moves coroutines whose sleep has ended onto the run queue
+ */
+void WorkerPool::runTimers() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+        if (timers.advance(elapsedMs()) > 0) {
+            ready.notify_all();
+        }
+        long long next = timers.nextExpiry();
+        if (next < 0) {
+            timerChanged.wait(lock);
+        } else {
+            timerChanged.wait_until(lock, started + std::chrono::milliseconds(next));
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimingWheel.h"
+
+/**
+ * A coroutine that starts as soon as it is called and runs until it returns. The Task
+ * owns the coroutine's frame and frees it when destroyed, so a suspended coroutine must
+ * never be resumed after its Task is gone.
+ */
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task() = default;
+    Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    /**
+     * Checks whether the coroutine has returned
+     * @return True once it has run to the end
+     */
+    bool done() const { return !handle || handle.done(); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * A fixed set of threads that resume coroutines. Coroutines suspend on co_await and are
+ * resumed by whichever worker is free, so thousands of them share a few threads. One
+ * more thread keeps the timers coroutines sleep on, in a timing wheel so adding a timer
+ * costs the same however many cars are waiting.
+ */
+class WorkerPool {
+private:
+    std::mutex mtx;
+    std::condition_variable ready;                  // Signalled when runQueue gains work or the pool stops
+    std::condition_variable timerChanged;           // Signalled when an earlier timer is added or the pool stops
+    std::deque<std::coroutine_handle<>> runQueue;   // Coroutines waiting for a worker
+    TimingWheel timers;                             // In milliseconds since the pool started
+    std::chrono::steady_clock::time_point started;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    std::thread timerThread;
+
+    void work();
+    void runTimers();
+    long long elapsedMs() const;
+
+public:
+    /**
+     * Awaitable that suspends the calling coroutine for a number of milliseconds
+     */
+    class Sleep {
+    public:
+        Sleep(WorkerPool& pool, int durationMs) : pool(pool), durationMs(durationMs) {}
+        bool await_ready() const { return durationMs <= 0; }
+        void await_suspend(std::coroutine_handle<> handle) { pool.resumeAfter(durationMs, handle); }
+        void await_resume() const {}
+
+    private:
+        WorkerPool& pool;
+        int durationMs;
+    };
+
+    /**
+     * Constructor for the WorkerPool class
+     * @param threads Worker threads to start; 0 starts one per core
+     */
+    explicit WorkerPool(unsigned threads = 0);
+
+    /**
+     * Destructor stops the workers
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Queues a suspended coroutine to be resumed by a worker
+     * @param handle The coroutine
+     */
+    void resume(std::coroutine_handle<> handle);
+
+    /**
+     * Queues a suspended coroutine to be resumed once a delay has passed
+     * @param delayMs Milliseconds to wait
+     * @param handle The coroutine
+     */
+    void resumeAfter(int delayMs, std::coroutine_handle<> handle);
+
+    /**
+     * Suspends the calling coroutine, as in co_await pool.sleep(100)
+     * @param durationMs Milliseconds to sleep
+     * @return The awaitable
+     */
+    Sleep sleep(int durationMs) { return Sleep(*this, durationMs); }
+
+    /**
+     * Stops and joins every thread. Coroutines still queued or sleeping are not resumed.
+     */
+    void stop();
+
+    /**
+     * Get the number of worker threads
+     * @return The number of workers
+     */
+    size_t size() const { return workers.size(); }
+};
+
+#endif // WORKER_POOL_H
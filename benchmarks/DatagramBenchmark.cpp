@@ -0,0 +1,76 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "../Event.h"
+
+// Loopback port used only by this benchmark
+#define BENCHMARK_PORT 8500
+#define ROUNDS 20000
+
+/**
+ * Compares packets per second between one syscall per packet and sendmmsg/recvmmsg
+ * batches, sending binary Event records over loopback in bursts of DATAGRAM_BATCH_SIZE.
+ */
+int main() {
+    DatagramSocket receiver(BENCHMARK_PORT);
+    DatagramSocket sender;
+    Event event("10:00:00", "Elevator: 1", "UP", 5, false, 1, 3, 1, false, 0);
+    const long long total = static_cast<long long>(ROUNDS) * DATAGRAM_BATCH_SIZE;
+
+    // One packet per syscall, as DatagramSocket::send and receive do, each received into
+    // a pooled buffer sized from the socket and decoded before the buffer goes back
+    std::vector<uint8_t> sendData = event.event_to_bytes();
+    DatagramPacket sendPacket(sendData, sendData.size(), InetAddress::getLocalHost(), BENCHMARK_PORT);
+    DatagramBufferPool pool(receiver);
+    Event decoded;
+    long long dropped = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < DATAGRAM_BATCH_SIZE; i++) {
+            sender.send(sendPacket);
+        }
+        for (int i = 0; i < DATAGRAM_BATCH_SIZE; i++) {
+            PooledBuffer buffer = pool.acquire();
+            DatagramPacket receivePacket(buffer.data(), buffer.size(), buffer.size());
+            if (!receiver.receive(receivePacket) || !Event::decode(buffer.data(), receivePacket.getLength(), decoded)) {
+                dropped++;
+            }
+        }
+    }
+    double singleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Whole batches per syscall, received into pooled buffers as UdpEndpoint does
+    DatagramBatch sendBatch;
+    DatagramBatch receiveBatch(pool);
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        while (!sendBatch.full()) {
+            size_t length = event.encode(sendBatch.slot(), sendBatch.slotSize());
+            sendBatch.push(length, InetAddress::getLocalHost(), BENCHMARK_PORT);
+        }
+        sender.sendBatch(sendBatch);
+        size_t received = 0;
+        while (received < DATAGRAM_BATCH_SIZE) {
+            size_t taken = receiver.receiveBatch(receiveBatch);
+            for (size_t i = 0; i < taken; i++) {
+                PooledBuffer buffer = receiveBatch.take(i);
+                if (!Event::decode(buffer.data(), receiveBatch.getLength(i), decoded)) {
+                    dropped++;
+                }
+            }
+            received += taken;
+        }
+    }
+    double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Packets per round: " << DATAGRAM_BATCH_SIZE << ", rounds: " << ROUNDS << std::endl;
+    std::cout << "Single packet path: " << static_cast<long long>(total / singleSeconds) << " packets/sec" << std::endl;
+    std::cout << "Batched path:       " << static_cast<long long>(total / batchSeconds) << " packets/sec" << std::endl;
+    std::cout << "Speedup:            " << singleSeconds / batchSeconds << "x" << std::endl;
+    if (dropped > 0) {
+        std::cout << "Packets that did not decode: " << dropped << std::endl;
+    }
+    return 0;
+}
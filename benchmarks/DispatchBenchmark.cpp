@@ -0,0 +1,324 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Scheduler.h"
+#include "../Logger.h"
+
+#define FLOORS 40                   // Floors in the synthetic building
+#define CALL_POOL 1024              // Distinct hall calls cycled through
+#define UPDATE_POOL 4096            // Distinct position updates cycled through
+#define DISPATCH_OPS 100000         // Operations timed per scheduler case
+#define LOOK_CAR_OPS 6400000        // Cars costed per LOOK case, which costs every car's route
+#define CODEC_OPS 1000000           // Operations timed per encode/decode case
+
+/**
+ * Times the scheduler's hot paths in process, without sockets or threads:
+ * assignOptimalElevator under both dispatch policies, updateElevatorInfo, and the
+ * binary and text Event encodings. Every operation is timed on its own, and the
+ * benchmark reports ns/op, p50/p99/p999 latency and heap allocations per operation.
+ * The cost of reading the clock is measured first and taken off every sample.
+ *
+ * Usage: dispatchBenchmark [--json results.json] [--label name]
+ * With --json the results are also written as JSON, tagged with the label (for example
+ * a commit id), so runs can be compared across commits.
+ */
+
+namespace {
+thread_local long long allocationCount = 0;     // Heap allocations made by this thread
+}
+
+// Every form of the global new and delete is replaced, so memory is always freed by
+// the same allocator that gave it out, whichever form a library happens to call.
+// Frees go through one out-of-line function so the compiler, having inlined a delete,
+// does not pair free with the new it knows as a builtin.
+[[gnu::noinline]] void releaseMemory(void* memory) noexcept { free(memory); }
+
+void* operator new(size_t size) {
+    allocationCount++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocationCount++;
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;   // aligned_alloc wants a multiple
+    void* memory = aligned_alloc(align, rounded);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { allocationCount++; return malloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { allocationCount++; return malloc(size ? size : 1); }
+
+void operator delete(void* memory) noexcept { releaseMemory(memory); }
+void operator delete(void* memory, size_t) noexcept { releaseMemory(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { releaseMemory(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { releaseMemory(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { releaseMemory(memory); }
+void operator delete[](void* memory) noexcept { releaseMemory(memory); }
+void operator delete[](void* memory, size_t) noexcept { releaseMemory(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { releaseMemory(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { releaseMemory(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { releaseMemory(memory); }
+
+struct Result {
+    std::string name;
+    long long ops;
+    double nsPerOp;
+    double p50Ns;
+    double p99Ns;
+    double p999Ns;
+    double allocsPerOp;
+};
+
+double clockOverheadNs = 0;
+
+// Nanoseconds between two clock reads
+inline long long elapsedNs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Median cost of an empty timed region
+double measureClockOverhead() {
+    std::vector<long long> samples(100000);
+    for (auto& sample : samples) {
+        auto start = std::chrono::steady_clock::now();
+        sample = elapsedNs(start, std::chrono::steady_clock::now());
+    }
+    std::sort(samples.begin(), samples.end());
+    return static_cast<double>(samples[samples.size() / 2]);
+}
+
+/**
+ * Times ops calls of run, calling setup untimed before each one
+ * @param name The case name reported
+ * @param ops Number of timed calls
+ * @param setup Untimed work before call i, such as retiring old requests
+ * @param run The operation measured
+ * @return The measurements
+ */
+template <typename Setup, typename Run>
+Result measure(const std::string& name, long long ops, Setup setup, Run run) {
+    // Warm up caches and let any lazily built state settle
+    for (long long i = 0; i < ops / 10; i++) {
+        setup(i);
+        run(i);
+    }
+
+    std::vector<double> samples(ops);
+    long long allocations = 0;
+    double total = 0;
+    for (long long i = 0; i < ops; i++) {
+        setup(i);
+        long long allocationsBefore = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        run(i);
+        auto end = std::chrono::steady_clock::now();
+        allocations += allocationCount - allocationsBefore;
+        samples[i] = std::max(0.0, elapsedNs(start, end) - clockOverheadNs);
+        total += samples[i];
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double fraction) {
+        return samples[std::min(ops - 1, static_cast<long long>(fraction * ops))];
+    };
+    return Result{name, ops, total / ops, percentile(0.50), percentile(0.99), percentile(0.999),
+                  static_cast<double>(allocations) / ops};
+}
+
+/**
+ * Builds a scheduler with its cars spread over the building, half of them moving
+ * @param cars The fleet size
+ * @param random Source of positions
+ * @return The scheduler
+ */
+std::unique_ptr<Scheduler> makeScheduler(int cars, std::mt19937& random) {
+    auto scheduler = std::make_unique<Scheduler>(cars, false);
+    for (int id = 0; id < cars; id++) {
+        int floor = random() % FLOORS + 1;
+        const char* direction = (id % 2) ? "" : (floor > FLOORS / 2 ? "DOWN" : "UP");
+        scheduler->updateElevatorInfo(Event("", "Elevator: " + std::to_string(id), direction, 0, false, id, floor, 0, false, 0), 0);
+    }
+    return scheduler;
+}
+
+/**
+ * Times assignOptimalElevator on a stream of random hall calls. At most two calls per car are
+ * outstanding: before the next call is assigned, the oldest is served, untimed, by its car
+ * arriving at the caller's floor, leaving with them and arriving at their destination.
+ */
+Result benchmarkAssign(DispatchPolicy policy, int cars) {
+    std::mt19937 random(cars);
+    std::unique_ptr<Scheduler> scheduler = makeScheduler(cars, random);
+    scheduler->setDispatchPolicy(policy);
+
+    std::vector<Event> calls;
+    for (int i = 0; i < CALL_POOL; i++) {
+        int origin = random() % FLOORS + 1;
+        int destination = random() % FLOORS + 1;
+        if (destination == origin) destination = origin % FLOORS + 1;
+        calls.push_back(Event("10:00:00", std::to_string(origin), destination > origin ? "UP" : "DOWN", destination, true));
+    }
+    std::vector<Event> updates;
+    for (int id = 0; id < cars; id++) {
+        updates.push_back(Event("10:00:00", "Elevator: " + std::to_string(id), "", 0, false, id, 0, 0, false, 0));
+    }
+
+    // Outstanding assignments, oldest first
+    size_t window = static_cast<size_t>(cars) * 2;
+    std::vector<std::pair<int, const Event*>> outstanding(window);
+    size_t head = 0, count = 0;
+    int assigned = -1;
+    const Event* last = nullptr;
+
+    // Each operation is a millisecond on the scheduler's clock
+    auto setup = [&](long long i) {
+        if (last && assigned >= 0) {
+            outstanding[(head + count) % window] = {assigned, last};
+            count++;
+        }
+        last = nullptr;
+        if (count == window) {
+            const Event* call = outstanding[head].second;
+            Event& update = updates[outstanding[head].first];
+            int origin = std::stoi(call->source);
+            // Arrive at the caller's floor, leave with them, then arrive at their destination
+            update.floorButton = "";
+            update.currentFloor = origin;
+            scheduler->updateElevatorInfo(update, i);
+            update.floorButton = call->floorButton;
+            scheduler->updateElevatorInfo(update, i);
+            update.floorButton = "";
+            update.currentFloor = call->elevatorButton;
+            scheduler->updateElevatorInfo(update, i);
+            head = (head + 1) % window;
+            count--;
+        }
+    };
+    auto run = [&](long long i) {
+        last = &calls[i % CALL_POOL];
+        assigned = scheduler->assignOptimalElevator(*last, i);
+    };
+
+    const char* policyName = policy == DISPATCH_LOOK ? "look" : (policy == DISPATCH_ETA ? "eta" : "heuristic");
+    std::string name = std::string("assign/") + policyName + "/" + std::to_string(cars);
+    long long ops = policy == DISPATCH_LOOK ? std::min<long long>(DISPATCH_OPS, LOOK_CAR_OPS / cars) : DISPATCH_OPS;
+    Result result = measure(name, ops, setup, run);
+
+    // Served calls must leave the cars' itineraries, or later assignments see a clogged fleet
+    size_t pending = 0;
+    for (const auto& [id, info] : scheduler->getInfoMap()) {
+        pending += info.stops.pickups.size();
+    }
+    if (pending > window) {
+        std::cerr << name << ": " << pending << " pickups outstanding, expected at most " << window << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    return result;
+}
+
+/**
+ * Times updateElevatorInfo on position updates: random cars leaving and reaching floors.
+ * Under DISPATCH_ETA each update also rebuilds the car's timed route.
+ */
+Result benchmarkUpdate(DispatchPolicy policy, int cars) {
+    std::mt19937 random(cars + 1);
+    std::unique_ptr<Scheduler> scheduler = makeScheduler(cars, random);
+    scheduler->setDispatchPolicy(policy);
+
+    std::vector<Event> updates;
+    for (int i = 0; i < UPDATE_POOL; i += 2) {
+        int id = random() % cars;
+        int floor = random() % FLOORS + 1;
+        std::string source = "Elevator: " + std::to_string(id);
+        updates.push_back(Event("", source, floor > FLOORS / 2 ? "DOWN" : "UP", 0, false, id, floor, 0, false, 0));
+        updates.push_back(Event("", source, "", 0, false, id, floor, 1, false, 0));
+    }
+    std::string name = std::string("update/") + (policy == DISPATCH_ETA ? "eta/" : "") + std::to_string(cars);
+    return measure(name, DISPATCH_OPS, [](long long) {},
+                   [&](long long i) { scheduler->updateElevatorInfo(updates[i % UPDATE_POOL], i); });
+}
+
+/**
+ * Times encoding and decoding a position update in one wire format
+ */
+void benchmarkCodec(WireFormat format, std::vector<Result>& results) {
+    Event::wireFormat() = format;
+    std::string suffix = format == WIRE_BINARY ? "binary" : "text";
+    Event status("10:00:05.250", "Elevator: 3", "DOWN", 9, false, 3, 7, 2, false, 0);
+    uint8_t buffer[DATAGRAM_PACKET_SIZE];
+    size_t length = 0;
+
+    results.push_back(measure("encode/" + suffix, CODEC_OPS, [&](long long i) { status.currentFloor = i % FLOORS + 1; },
+                              [&](long long) { length = status.event_to_bytes(buffer, sizeof(buffer)); }));
+
+    length = status.event_to_bytes(buffer, sizeof(buffer));
+    Event decoded;
+    if (format == WIRE_BINARY) {
+        results.push_back(measure("decode/" + suffix, CODEC_OPS, [](long long) {},
+                                  [&](long long) { Event::decode(buffer, length, decoded); }));
+    } else {
+        results.push_back(measure("decode/" + suffix, CODEC_OPS, [](long long) {},
+                                  [&](long long) { decoded = Event::bytes_to_event(buffer, length); }));
+    }
+    Event::wireFormat() = WIRE_BINARY;
+}
+
+// Writes the results as one JSON document
+void writeJson(const std::string& fileName, const std::string& label, const std::vector<Result>& results) {
+    std::ofstream out(fileName);
+    out << "{\n  \"label\": \"" << label << "\",\n  \"clock_overhead_ns\": " << clockOverheadNs << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"p50_ns\": " << r.p50Ns << ", \"p99_ns\": " << r.p99Ns << ", \"p999_ns\": " << r.p999Ns
+            << ", \"allocs_per_op\": " << r.allocsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string jsonFile, label = "unlabelled";
+    for (int i = 1; i + 1 < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json") jsonFile = argv[++i];
+        else if (arg == "--label") label = argv[++i];
+    }
+
+    // Measure dispatch, not logging
+    Logger::setLevel(LOG_LEVEL_OFF);
+    clockOverheadNs = measureClockOverhead();
+
+    std::vector<Result> results;
+    for (int cars : {4, 64, 1024}) {
+        results.push_back(benchmarkAssign(DISPATCH_HEURISTIC, cars));
+        results.push_back(benchmarkAssign(DISPATCH_LOOK, cars));
+        results.push_back(benchmarkAssign(DISPATCH_ETA, cars));
+        results.push_back(benchmarkUpdate(DISPATCH_HEURISTIC, cars));
+        results.push_back(benchmarkUpdate(DISPATCH_ETA, cars));
+    }
+    benchmarkCodec(WIRE_BINARY, results);
+    benchmarkCodec(WIRE_TEXT, results);
+
+    std::cout << "clock overhead " << clockOverheadNs << " ns, taken off every sample" << std::endl;
+    std::cout << "case\tns/op\tp50\tp99\tp999\tallocs/op" << std::endl;
+    for (const Result& r : results) {
+        std::cout << r.name << "\t" << r.nsPerOp << "\t" << r.p50Ns << "\t" << r.p99Ns << "\t" << r.p999Ns
+                  << "\t" << r.allocsPerOp << std::endl;
+    }
+    if (!jsonFile.empty()) {
+        writeJson(jsonFile, label, results);
+        std::cout << "Results written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Simulation.h"
+#include "../Logger.h"
+
+#define CARS 8                  // Cars in the synthetic building
+#define FLOORS 20               // Floors in the synthetic building
+#define CALLS 3000              // Hall calls per run
+#define MEAN_GAP_MS 6000        // Mean time between hall calls
+
+/**
+ * Measures how the fleet holds up while cars are failing. The same call sequence is run
+ * on the simulation clock with a growing share of calls carrying a fault that leaves a car
+ * stuck between floors or without its arrival sensor. Faulted cars hand their waiting
+ * calls to other cars and are back in service after CAR_RECOVERY_TIME, so every call
+ * should still finish. For each fault rate the benchmark reports throughput in trips per
+ * simulated hour and the tail of the journey from hall call to arrival, timed from when
+ * the call was first made rather than from its reassignment.
+ *
+ * Calls are assigned by collective control (DISPATCH_LOOK).
+ *
+ * Usage: faultRecoveryBenchmark
+ */
+
+struct Run {
+    double faultRate;
+    int faults;
+    int completed;
+    uint64_t reassigned;
+    double tripsPerHour;
+    int64_t p50Ms;
+    int64_t p99Ms;
+    int64_t p999Ms;
+    int64_t maxMs;
+};
+
+Run runWithFaults(double faultRate) {
+    Simulation simulation(CARS);
+    simulation.getScheduler().setDispatchPolicy(DispatchPolicy::DISPATCH_LOOK);
+    std::mt19937 random(42);
+    std::exponential_distribution<double> gap(1.0 / MEAN_GAP_MS);
+    std::uniform_int_distribution<int> floor(1, FLOORS);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    // Each call is named by its index so its completion can be matched to when it was made
+    std::unordered_map<std::string, long long> calledAt;
+    long long at = 0;
+    int faults = 0;
+    for (int i = 0; i < CALLS; i++) {
+        int origin = floor(random);
+        int destination = floor(random);
+        while (destination == origin) destination = floor(random);
+        int fault = 0;
+        if (chance(random) < faultRate) {
+            fault = (faults++ % 2 == 0) ? ELEVATOR_STUCK : ARRIVAL_SENSOR_ISSUE;
+        }
+        Event call(std::to_string(i), std::to_string(origin), destination > origin ? "Up" : "Down", destination, true);
+        call.fault = fault;
+        calledAt[call.time] = at;
+        simulation.addFloorEvent(at, call);
+        at += static_cast<long long>(gap(random));
+    }
+
+    HdrHistogram journey;
+    long long lastCompletion = 0;
+    simulation.setCompletionHandler([&](const Event& response) {
+        journey.record(simulation.now() - calledAt[response.time]);
+        lastCompletion = simulation.now();
+    });
+    simulation.run();
+
+    Run run;
+    run.faultRate = faultRate;
+    run.faults = faults;
+    run.completed = simulation.getCompletedEvents();
+    run.reassigned = simulation.getScheduler().getMetrics().getReassigned();
+    run.tripsPerHour = lastCompletion > 0 ? run.completed * 3600000.0 / lastCompletion : 0;
+    run.p50Ms = journey.percentile(50);
+    run.p99Ms = journey.percentile(99);
+    run.p999Ms = journey.percentile(99.9);
+    run.maxMs = journey.maximum();
+    return run;
+}
+
+int main() {
+    Logger::setLevel(LOG_LEVEL_OFF);
+
+    std::printf("%d cars, %d floors, %d calls, one every %d ms on average, cars recover in %d s\n",
+                CARS, FLOORS, CALLS, MEAN_GAP_MS, CAR_RECOVERY_TIME);
+    std::printf("%-8s %7s %9s %11s %10s %8s %8s %8s %8s\n", "faults", "injected", "completed", "reassigned",
+                "trips/h", "p50 s", "p99 s", "p99.9 s", "max s");
+    bool allFinished = true;
+    for (double rate : {0.0, 0.01, 0.02, 0.05, 0.10}) {
+        Run run = runWithFaults(rate);
+        std::printf("%6.0f%%  %8d %9d %11llu %10.0f %8.1f %8.1f %8.1f %8.1f\n", run.faultRate * 100, run.faults,
+                    run.completed, static_cast<unsigned long long>(run.reassigned), run.tripsPerHour,
+                    run.p50Ms / 1000.0, run.p99Ms / 1000.0, run.p999Ms / 1000.0, run.maxMs / 1000.0);
+        allFinished = allFinished && run.completed == CALLS;
+    }
+    if (!allFinished) {
+        std::cerr << "Some calls never finished" << std::endl;
+        return 1;
+    }
+    return 0;
+}
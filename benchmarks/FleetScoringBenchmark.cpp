@@ -0,0 +1,72 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../Scheduler.h"
+#include "../Logger.h"
+
+#define TARGET_CAR_SCORES 50000000LL // Cars scored per measurement, split into calls
+
+/**
+ * Times scoring a whole fleet for one hall call at 4, 64, 1024 and 16384 cars:
+ * the scalar kernel, the AVX2 kernel, and a full Scheduler::assignOptimalElevator
+ * with the default heuristic policy. Every eighth car is out of service.
+ */
+
+// Nanoseconds per call of the given work
+template <typename Work>
+double timePerCall(long long calls, Work work) {
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < calls; i++) {
+        work(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main() {
+    std::cout << "AVX2 " << (ElevatorFleet::hasAvx2() ? "available" : "not available") << std::endl;
+    std::cout << "cars\tscalar ns/call\tavx2 ns/call\tassign ns/call" << std::endl;
+
+    for (int cars : {4, 64, 1024, 16384}) {
+        long long calls = TARGET_CAR_SCORES / cars;
+        std::mt19937 random(cars);
+
+        ElevatorFleet fleet(cars);
+        for (int i = 0; i < cars; i++) {
+            fleet.currentFloor[i] = random() % 40 + 1;
+            fleet.state[i] = random() % 5;
+            fleet.busy[i] = random() % 2;
+            if (i % 8 == 7) fleet.remove(i);
+        }
+        std::vector<int32_t> scores(cars);
+        long long checksum = 0;
+        double scalarNs = timePerCall(calls, [&](long long i) {
+            fleet.scoreHeuristic(i % 40 + 1, i & 1, scores.data(), false);
+            checksum += fleet.lowestScore(scores.data(), false);
+        });
+        double simdNs = timePerCall(calls, [&](long long i) {
+            fleet.scoreHeuristic(i % 40 + 1, i & 1, scores.data());
+            checksum += fleet.lowestScore(scores.data());
+        });
+
+        // The full assignment path, with scheduler output switched off
+        Scheduler scheduler(cars, false);
+        for (int i = 7; i < cars; i += 8) {
+            scheduler.removeElevator(i);
+        }
+        std::vector<Event> requests;
+        for (int floor = 1; floor <= 40; floor++) {
+            requests.push_back(Event("10:00:00", std::to_string(floor), floor > 20 ? "DOWN" : "UP", floor > 20 ? 1 : 40, true));
+        }
+        long long assignCalls = std::min(calls, 200000LL);
+        Logger::setLevel(LOG_LEVEL_OFF);
+        double assignNs = timePerCall(assignCalls, [&](long long i) {
+            checksum += scheduler.assignOptimalElevator(requests[i % requests.size()], i);
+        });
+        Logger::setLevel(LOG_LEVEL_INFO);
+
+        std::cout << cars << "\t" << scalarNs << "\t" << simdNs << "\t" << assignNs << std::endl;
+        if (checksum == -1) std::cout << checksum << std::endl; // Keeps the work from being optimized away
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <poll.h>
+#include "../Floor.h"
+
+#define NUM_ELEVATORS 4
+#define SINGLE_CALLS 500
+#define BURST_CALLS 200
+
+/**
+ * Measures hall-call-to-assignment latency through a running Scheduler.
+ * The benchmark plays the elevator subsystems, timing how long each assignment takes
+ * to reach an elevator port: first for single calls sent one at a time, then for a
+ * burst injected by Floor::run from a trace file.
+ */
+
+// Opens a socket on an elevator port, using the same port convention as DatagramSocket
+int openElevatorSocket(int id) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = ELEVATOR_PORT_BASE + id;
+    address.sin_addr.s_addr = INADDR_ANY;
+    if (bind(fd, (const struct sockaddr*)&address, sizeof(address)) < 0) {
+        throw std::runtime_error("could not bind elevator port");
+    }
+    return fd;
+}
+
+// Waits for one assignment on any elevator socket
+void awaitAssignment(std::vector<struct pollfd>& fds) {
+    char buffer[256];
+    while (true) {
+        poll(fds.data(), fds.size(), -1);
+        for (auto& entry : fds) {
+            if (entry.revents & POLLIN) {
+                recv(entry.fd, buffer, sizeof(buffer), 0);
+                return;
+            }
+        }
+    }
+}
+
+int main() {
+    Scheduler scheduler(NUM_ELEVATORS);
+    std::vector<struct pollfd> fds;
+    for (int i = 0; i < NUM_ELEVATORS; i++) {
+        fds.push_back({openElevatorSocket(i), POLLIN, 0});
+    }
+    std::thread schedulerThread(&Scheduler::run, &scheduler);
+
+    DatagramSocket floorSocket;
+    Event call("10:00:00", "3", "UP", 7, true);
+    std::vector<uint8_t> data = call.event_to_bytes();
+    DatagramPacket packet(data, data.size(), InetAddress::getLocalHost(), SCHEDULER_PORT);
+
+    // One call at a time: send, then wait for its assignment
+    std::vector<double> latencies;
+    for (int i = 0; i < SINGLE_CALLS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        floorSocket.send(packet);
+        awaitAssignment(fds);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // A burst of calls injected by the Floor subsystem
+    const char* traceFileName = "temp_latency_trace.txt";
+    std::ofstream trace(traceFileName);
+    trace << "Time Floor FloorButton CarButton Fault\n";
+    trace << "hh:mm:ss.mmm n Up/Down n n\n";
+    for (int i = 0; i < BURST_CALLS; i++) {
+        trace << "10:00:00 " << (i % 9 + 1) << " UP 10 0\n";
+    }
+    trace.close();
+
+    Floor floor(scheduler, traceFileName);
+    auto start = std::chrono::steady_clock::now();
+    std::thread floorThread(&Floor::run, &floor);
+    for (int i = 0; i < BURST_CALLS; i++) {
+        awaitAssignment(fds);
+    }
+    floorThread.join();
+    std::remove(traceFileName);
+    double burstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "Hall call to assignment latency (us): p50=" << latencies[latencies.size() / 2]
+              << " p99=" << latencies[latencies.size() * 99 / 100]
+              << " max=" << latencies.back() << std::endl;
+    std::cerr << "Floor burst of " << BURST_CALLS << " calls assigned in " << burstMs << " ms ("
+              << static_cast<long long>(BURST_CALLS * 1000 / burstMs) << " calls/sec)" << std::endl;
+
+    // The scheduler thread never returns on its own; leave without unwinding it
+    exit(0);
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+#include "../TimingWheel.h"
+
+#define TIMER_OPS 1000000       // Timers added per case
+#define MAX_DELAY_MS 60000      // Timers are due up to a minute out
+
+/**
+ * Compares the timing wheel with an ordered map of deadlines, the usual way to keep
+ * cancellable timers. Each case keeps a fleet's worth of timers pending (one per car),
+ * and for every new timer cancels an old one, as a car arriving cancels its arrival
+ * watchdog. A final pass advances the clock until every timer has fired.
+ *
+ * Usage: timingWheelBenchmark
+ */
+
+double nsPerOp(std::chrono::steady_clock::time_point start, long long ops) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+}
+
+int main() {
+    std::printf("%10s %22s %22s %22s\n", "pending", "wheel add+cancel ns", "map add+cancel ns", "wheel expire ns");
+    for (int pending : {100, 10000, 1000000}) {
+        std::mt19937 random(3);
+        std::uniform_int_distribution<long long> delay(1, MAX_DELAY_MS);
+        std::vector<long long> delays(TIMER_OPS);
+        for (long long& d : delays) d = delay(random);
+        long long fired = 0;
+
+        // Timing wheel
+        TimingWheel wheel;
+        std::vector<TimingWheel::TimerId> wheelIds(pending);
+        for (int i = 0; i < pending; i++) {
+            wheelIds[i] = wheel.schedule(delays[i], [&fired]() { fired++; });
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TIMER_OPS; i++) {
+            TimingWheel::TimerId& slot = wheelIds[i % pending];
+            wheel.cancel(slot);
+            slot = wheel.schedule(delays[i], [&fired]() { fired++; });
+        }
+        double wheelNs = nsPerOp(start, TIMER_OPS);
+
+        start = std::chrono::steady_clock::now();
+        wheel.advance(MAX_DELAY_MS);
+        double expireNs = nsPerOp(start, pending);
+
+        // Ordered map keyed by deadline
+        std::multimap<long long, std::function<void()>> deadlines;
+        std::vector<std::multimap<long long, std::function<void()>>::iterator> mapIds(pending);
+        for (int i = 0; i < pending; i++) {
+            mapIds[i] = deadlines.emplace(delays[i], [&fired]() { fired++; });
+        }
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TIMER_OPS; i++) {
+            auto& slot = mapIds[i % pending];
+            deadlines.erase(slot);
+            slot = deadlines.emplace(delays[i], [&fired]() { fired++; });
+        }
+        double mapNs = nsPerOp(start, TIMER_OPS);
+
+        std::printf("%10d %22.1f %22.1f %22.1f\n", pending, wheelNs, mapNs, expireNs);
+        if (fired != pending) {
+            std::cerr << "Expected " << pending << " timers to fire, got " << fired << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "../TraceReader.h"
+
+#define BENCHMARK_LINES 5000000     // Lines in the generated input file
+#define BENCHMARK_FILE "/tmp/TraceReaderBenchmark.txt"
+
+/**
+ * Parses a generated input file of BENCHMARK_LINES requests two ways: the old
+ * std::getline and std::stringstream loop into an Event per line, and TraceReader
+ * handing out batches of DATAGRAM_BATCH_SIZE records. Prints lines per second.
+ */
+
+// Seconds since start
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    {
+        std::ofstream out(BENCHMARK_FILE);
+        out << "Time Floor FloorButton CarButton Fault\nhh:mm:ss.mmm n Up/Down n n\n";
+        std::mt19937 random(1);
+        char line[64];
+        for (int i = 0; i < BENCHMARK_LINES; i++) {
+            int ms = i * 10;
+            int floor = random() % 40 + 1;
+            int length = snprintf(line, sizeof(line), "%02d:%02d:%02d.%03d %d %s %d %d\n",
+                                  ms / 3600000 % 24, ms / 60000 % 60, ms / 1000 % 60, ms % 1000,
+                                  floor, random() % 2 ? "Up" : "Down", static_cast<int>(random() % 40 + 1), 0);
+            out.write(line, length);
+        }
+    }
+
+    // The loop Floor and Simulation used before
+    long long checksum = 0, lines = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::ifstream inFile(BENCHMARK_FILE);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(inFile, line)) {
+            if (++lineNumber <= 2) continue;
+            Event event;
+            std::stringstream extract(line);
+            if (extract >> event.time >> event.source >> event.floorButton >> event.elevatorButton >> event.fault) {
+                checksum += event.elevatorButton;
+                lines++;
+            }
+        }
+    }
+    double streamSeconds = secondsSince(start);
+    std::cout << "getline+stringstream: " << lines << " lines, " << static_cast<long long>(lines / streamSeconds)
+              << " lines/s (checksum " << checksum << ")" << std::endl;
+
+    checksum = 0;
+    lines = 0;
+    start = std::chrono::steady_clock::now();
+    {
+        TraceReader reader(BENCHMARK_FILE);
+        TraceRecord records[DATAGRAM_BATCH_SIZE];
+        size_t count;
+        while ((count = reader.next(records, DATAGRAM_BATCH_SIZE)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                checksum += records[i].destination;
+            }
+            lines += count;
+        }
+    }
+    double mappedSeconds = secondsSince(start);
+    std::cout << "TraceReader:          " << lines << " lines, " << static_cast<long long>(lines / mappedSeconds)
+              << " lines/s (checksum " << checksum << ")" << std::endl;
+
+    std::remove(BENCHMARK_FILE);
+    return 0;
+}
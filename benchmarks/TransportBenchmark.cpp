@@ -0,0 +1,99 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include "../Transport.h"
+
+// Ports used only by this benchmark
+#define PING_PORT 8600
+#define PONG_PORT 8601
+#define ROUND_TRIPS 20000
+#define STREAM_BATCHES 20000     // Bursts of DATAGRAM_BATCH_SIZE events, each acknowledged
+
+// Waits until an endpoint has events, then takes them
+size_t receiveWaiting(Endpoint& endpoint, std::vector<Event>& events) {
+    while (endpoint.receive(events) == 0) {
+        struct pollfd ready = {endpoint.fd(), POLLIN, 0};
+        poll(&ready, 1, 1000);
+    }
+    return events.size();
+}
+
+/**
+ * Bounces one event between two threads, then streams bursts of events one way with an
+ * acknowledgement per burst so UDP never overflows its socket buffer. Both threads wait
+ * on the endpoint descriptors the way the reactor does.
+ * @param name Name printed with the results
+ * @param transport The transport
+ */
+void measure(const std::string& name, Transport& transport) {
+    std::unique_ptr<Endpoint> ping = transport.open(PING_PORT, SENDERS_ONE);
+    std::unique_ptr<Endpoint> pong = transport.open(PONG_PORT, SENDERS_MANY);
+    Event event("10:00:00", "Elevator: 1", "UP", 5, false, 1, 3, 1, false, 0);
+
+    // The echo thread returns every round trip event and one event per burst
+    std::thread echo([&]() {
+        std::vector<Event> events;
+        long long streamed = 0;
+        for (int handled = 0; handled < ROUND_TRIPS + STREAM_BATCHES * DATAGRAM_BATCH_SIZE;) {
+            receiveWaiting(*ping, events);
+            for (const Event& received : events) {
+                if (received.riders == 1 || ++streamed % DATAGRAM_BATCH_SIZE == 0) {
+                    pong->send(PONG_PORT, received);
+                }
+                handled++;
+            }
+            pong->flush();
+        }
+    });
+
+    std::vector<Event> events;
+    std::vector<double> roundTrips;
+    for (int i = 0; i < ROUND_TRIPS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        ping->send(PING_PORT, event);
+        ping->flush();
+        receiveWaiting(*pong, events);
+        roundTrips.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(roundTrips.begin(), roundTrips.end());
+
+    event.riders = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int burst = 0; burst < STREAM_BATCHES; burst++) {
+        for (int i = 0; i < DATAGRAM_BATCH_SIZE; i++) {
+            ping->send(PING_PORT, event);
+        }
+        ping->flush();
+        receiveWaiting(*pong, events);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    echo.join();
+
+    std::cout << name << ": round trip p50 " << roundTrips[roundTrips.size() / 2] << "us p99 "
+              << roundTrips[roundTrips.size() * 99 / 100] << "us, one way "
+              << static_cast<long long>(STREAM_BATCHES * DATAGRAM_BATCH_SIZE / seconds) << " events/sec" << std::endl;
+}
+
+/**
+ * Compares the transports the subsystems can talk through
+ */
+int main() {
+    InProcessTransport inProcess;
+    measure("In-process   ", inProcess);
+
+    SharedMemoryTransport sharedMemory("elevator-benchmark-" + std::to_string(getpid()));
+    sharedMemory.remove(PING_PORT);
+    sharedMemory.remove(PONG_PORT);
+    measure("Shared memory", sharedMemory);
+    sharedMemory.remove(PING_PORT);
+    sharedMemory.remove(PONG_PORT);
+
+    UdpTransport udp;
+    measure("UDP          ", udp);
+    return 0;
+}
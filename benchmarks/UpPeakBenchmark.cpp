@@ -0,0 +1,96 @@
+#include <iostream>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "../Simulation.h"
+#include "../Logger.h"
+
+#define CARS 4                  // Cars in the synthetic building
+#define FLOORS 16               // Floors in the synthetic building
+#define CALLS 2000              // Hall calls per run, all from the lobby
+
+/**
+ * Measures the fleet at the morning up-peak, when every passenger boards at the lobby
+ * and rides up. Cars carry at most ELEVATOR_CAPACITY passengers, so once the lobby queue
+ * outgrows a car the fleet's handling capacity is set by how many boarders each trip
+ * takes and how long the round trip back to the lobby is. For each dispatch policy and
+ * arrival rate the benchmark reports throughput in trips per simulated hour, the journey
+ * from hall call to arrival, and how often a full car handed a caller back to be
+ * assigned again.
+ *
+ * Usage: upPeakBenchmark
+ */
+
+struct Run {
+    int completed;
+    uint64_t handedBack;
+    double tripsPerHour;
+    int64_t p50Ms;
+    int64_t p99Ms;
+    int64_t maxMs;
+};
+
+Run runUpPeak(DispatchPolicy policy, int meanGapMs) {
+    Simulation simulation(CARS);
+    simulation.getScheduler().setDispatchPolicy(policy);
+    std::mt19937 random(11);
+    std::exponential_distribution<double> gap(1.0 / meanGapMs);
+    std::uniform_int_distribution<int> floor(2, FLOORS);
+
+    // Each call is named by its index so its completion can be matched to when it was made
+    std::unordered_map<std::string, long long> calledAt;
+    long long at = 0;
+    for (int i = 0; i < CALLS; i++) {
+        Event call(std::to_string(i), "1", "Up", floor(random), true);
+        calledAt[call.time] = at;
+        simulation.addFloorEvent(at, call);
+        at += static_cast<long long>(gap(random));
+    }
+
+    HdrHistogram journey;
+    long long lastCompletion = 0;
+    simulation.setCompletionHandler([&](const Event& response) {
+        journey.record(simulation.now() - calledAt[response.time]);
+        lastCompletion = simulation.now();
+    });
+    simulation.run();
+
+    Run run;
+    run.completed = simulation.getCompletedEvents();
+    run.handedBack = simulation.getScheduler().getMetrics().getReassigned();
+    run.tripsPerHour = lastCompletion > 0 ? run.completed * 3600000.0 / lastCompletion : 0;
+    run.p50Ms = journey.percentile(50);
+    run.p99Ms = journey.percentile(99);
+    run.maxMs = journey.maximum();
+    return run;
+}
+
+int main() {
+    Logger::setLevel(LOG_LEVEL_OFF);
+
+    std::printf("%d cars of %d passengers, %d floors, %d calls from the lobby\n",
+                CARS, ELEVATOR_CAPACITY, FLOORS, CALLS);
+    std::printf("%-10s %8s %9s %12s %10s %8s %8s %8s\n", "policy", "gap ms", "completed", "handed back",
+                "trips/h", "p50 s", "p99 s", "max s");
+    const std::pair<DispatchPolicy, const char*> policies[] = {
+        {DispatchPolicy::DISPATCH_HEURISTIC, "heuristic"},
+        {DispatchPolicy::DISPATCH_LOOK, "look"},
+        {DispatchPolicy::DISPATCH_ETA, "eta"},
+    };
+    bool allFinished = true;
+    for (const auto& [policy, name] : policies) {
+        for (int meanGapMs : {12000, 9000, 7000, 6000}) {
+            Run run = runUpPeak(policy, meanGapMs);
+            std::printf("%-10s %8d %9d %12llu %10.0f %8.1f %8.1f %8.1f\n", name, meanGapMs, run.completed,
+                        static_cast<unsigned long long>(run.handedBack), run.tripsPerHour,
+                        run.p50Ms / 1000.0, run.p99Ms / 1000.0, run.maxMs / 1000.0);
+            allFinished = allFinished && run.completed == CALLS;
+        }
+    }
+    if (!allFinished) {
+        std::cerr << "Some calls never finished" << std::endl;
+        return 1;
+    }
+    return 0;
+}
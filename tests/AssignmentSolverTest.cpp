@@ -0,0 +1,85 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <vector>
+#include "../AssignmentSolver.h"
+
+// Cheapest total over every way of giving each row of the smaller side its own column
+int64_t bruteForce(const std::vector<int64_t>& cost, int rows, int cols) {
+    int small = std::min(rows, cols);
+    int large = std::max(rows, cols);
+    std::vector<int> order(large);
+    for (int i = 0; i < large; i++) order[i] = i;
+    int64_t best = INT64_MAX;
+    do {
+        int64_t total = 0;
+        for (int i = 0; i < small; i++) {
+            total += rows <= cols ? cost[i * cols + order[i]] : cost[order[i] * cols + i];
+        }
+        best = std::min(best, total);
+    } while (std::next_permutation(order.begin(), order.end()));
+    return best;
+}
+
+// Sums the assignment and checks no column is used twice
+int64_t totalOf(const std::vector<int>& assignment, const std::vector<int64_t>& cost, int rows, int cols) {
+    std::vector<bool> used(cols, false);
+    int64_t total = 0;
+    int matched = 0;
+    for (int r = 0; r < rows; r++) {
+        if (assignment[r] < 0) continue;
+        assert(assignment[r] < cols && !used[assignment[r]] && "Each column should be given once");
+        used[assignment[r]] = true;
+        total += cost[r * cols + assignment[r]];
+        matched++;
+    }
+    assert(matched == std::min(rows, cols) && "Every row of the smaller side should be matched");
+    return total;
+}
+
+int main() {
+    AssignmentSolver solver;
+
+    // Test scenario 1 - the greedy choice for the first row is not the cheapest overall
+    {
+        // Row 0 alone would take column 0, but then row 1 pays 100
+        std::vector<int64_t> cost = {1, 2,
+                                     1, 100};
+        const std::vector<int>& assignment = solver.solve(cost, 2, 2);
+        assert(assignment[0] == 1 && assignment[1] == 0);
+        std::cout << "Test Passed: Joint assignment beats the greedy one." << std::endl;
+    }
+
+    // Test scenario 2 - square and rectangular matrices match a brute-force search
+    {
+        std::mt19937 random(16);
+        std::uniform_int_distribution<int> value(0, 50);
+        for (int trial = 0; trial < 300; trial++) {
+            int rows = 1 + trial % 6;
+            int cols = 1 + (trial / 6) % 6;
+            std::vector<int64_t> cost(rows * cols);
+            for (int64_t& entry : cost) {
+                entry = value(random);
+            }
+            // Some pairings are ruled out, as with a car out of service
+            if (trial % 5 == 0) cost[random() % cost.size()] = ASSIGNMENT_INFEASIBLE;
+            const std::vector<int>& assignment = solver.solve(cost, rows, cols);
+            assert(totalOf(assignment, cost, rows, cols) == bruteForce(cost, rows, cols));
+        }
+        std::cout << "Test Passed: Solver finds the cheapest assignment." << std::endl;
+    }
+
+    // Test scenario 3 - rows left over when there are more rows than columns get -1
+    {
+        std::vector<int64_t> cost = {5, 9,
+                                     1, 9,
+                                     7, 2};
+        const std::vector<int>& assignment = solver.solve(cost, 3, 2);
+        assert(assignment[0] == -1 && assignment[1] == 0 && assignment[2] == 1);
+        assert(solver.solve({}, 0, 4).empty());
+        std::cout << "Test Passed: Extra rows are left unassigned." << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../Simulation.h"
+#include "../Logger.h"
+
+#define CHECKPOINT_FILE "checkpoint_test.bin"
+#define CHECKPOINT_AT_MS 60000
+
+// Test event creation function
+Event createTestEvent(const std::string& source, const std::string& floorBtn, int elevatorBtn, int faultType) {
+    Event event;
+    event.isFromFloor = true;
+    event.source = source;
+    event.floorButton = floorBtn;
+    event.elevatorButton = elevatorBtn;
+    event.fault = faultType;
+    return event;
+}
+
+// A busy morning: a crowd at the lobby, calls between floors and a car that gets stuck
+void addTraffic(Simulation& simulation) {
+    for (int i = 0; i < 30; i++) {
+        simulation.addFloorEvent(i * 3000, createTestEvent("1", "Up", i % 9 + 2, 0));
+    }
+    for (int i = 0; i < 12; i++) {
+        int floor = i % 10 + 2;
+        simulation.addFloorEvent(5000 + i * 7000, createTestEvent(std::to_string(floor), "Down", 1, 0));
+    }
+    simulation.addFloorEvent(40000, createTestEvent("6", "Up", 9, ELEVATOR_STUCK));
+}
+
+// Every completion a run makes, as when and which trip
+struct Completions {
+    std::vector<std::string> trips;
+
+    void attach(Simulation& simulation) {
+        simulation.setCompletionHandler([this, &simulation](const Event& response) {
+            trips.push_back(std::to_string(simulation.now()) + " " + response.source + " "
+                            + std::to_string(response.elevatorButton));
+        });
+    }
+};
+
+int main() {
+    Logger::setLevel(LOG_LEVEL_WARN);
+
+    // Test scenario 1 - a run restored from a mid-morning checkpoint finishes exactly as the
+    // run it was taken from, for assignment one at a time and in batch windows
+    for (int windowMs : {0, 1500}) {
+        Simulation whole(3);
+        whole.getScheduler().setDispatchPolicy(DispatchPolicy::DISPATCH_ETA);
+        whole.getScheduler().setBatchWindow(windowMs);
+        addTraffic(whole);
+        Completions wholeTrips;
+        wholeTrips.attach(whole);
+        whole.runUntil(CHECKPOINT_AT_MS);
+        assert(whole.now() == CHECKPOINT_AT_MS);
+        size_t before = wholeTrips.trips.size();
+        assert(before > 0 && whole.getCompletedEvents() < whole.getTotalEvents());
+        assert(whole.saveCheckpoint(CHECKPOINT_FILE));
+        whole.run();
+        assert(whole.getCompletedEvents() == whole.getTotalEvents());
+
+        std::unique_ptr<Simulation> restored = Simulation::restoreCheckpoint(CHECKPOINT_FILE);
+        assert(restored && "Checkpoint should restore");
+        assert(restored->now() == CHECKPOINT_AT_MS);
+        assert(restored->getScheduler().getNumElevators() == 3);
+        assert(restored->getScheduler().getDispatchPolicy() == DispatchPolicy::DISPATCH_ETA);
+        assert(restored->getScheduler().getBatchWindow() == windowMs);
+        assert(restored->getCompletedEvents() == static_cast<int>(before));
+        Completions restoredTrips;
+        restoredTrips.attach(*restored);
+        restored->run();
+
+        assert(restored->now() == whole.now());
+        assert(restored->getCompletedEvents() == whole.getCompletedEvents());
+        assert(std::equal(restoredTrips.trips.begin(), restoredTrips.trips.end(), wholeTrips.trips.begin() + before,
+                          wholeTrips.trips.end()) && restoredTrips.trips.size() == wholeTrips.trips.size() - before);
+        const PassengerMetrics& a = whole.getScheduler().getMetrics();
+        const PassengerMetrics& b = restored->getScheduler().getMetrics();
+        assert(b.getOverall().journey.count() == a.getOverall().journey.count());
+        assert(b.getOverall().journey.mean() == a.getOverall().journey.mean());
+        assert(b.getOverall().wait.percentile(95) == a.getOverall().wait.percentile(95));
+        assert(b.getOverall().ride.maximum() == a.getOverall().ride.maximum());
+        assert(b.getReassigned() == a.getReassigned() && a.getReassigned() > 0);
+        assert(b.getFloor(1)->wait.count() == a.getFloor(1)->wait.count());
+        for (int car = 0; car < 3; car++) {
+            Elevator* left = whole.getElevatorSubsystem(car).getElevator();
+            Elevator* right = restored->getElevatorSubsystem(car).getElevator();
+            assert(right->getCurrentFloor() == left->getCurrentFloor());
+            assert(right->getTotalPassengers() == left->getTotalPassengers());
+            assert(b.getCar(car)->journey.count() == a.getCar(car)->journey.count());
+        }
+    }
+    std::cout << "Test Passed: A restored run finishes exactly as the run it was saved from." << std::endl;
+
+    // Test scenario 2 - a restored run can branch off with another policy
+    {
+        std::unique_ptr<Simulation> branch = Simulation::restoreCheckpoint(CHECKPOINT_FILE);
+        assert(branch);
+        branch->getScheduler().setDispatchPolicy(DispatchPolicy::DISPATCH_LOOK);
+        branch->addFloorEvent(CHECKPOINT_AT_MS + 1000, createTestEvent("4", "Up", 8, 0));
+        branch->run();
+        assert(branch->getCompletedEvents() == branch->getTotalEvents());
+    }
+    std::cout << "Test Passed: A restored run branches off with another policy and more calls." << std::endl;
+
+    // Test scenario 3 - what cannot be saved or read back is refused
+    {
+        Simulation simulation(2);
+        bool ran = false;
+        simulation.schedule(1000, [&ran]() { ran = true; });
+        assert(!simulation.saveCheckpoint(CHECKPOINT_FILE) && "Pending callbacks cannot be saved");
+        simulation.run();
+        assert(ran);
+        simulation.addFloorEvent(2000, createTestEvent("3", "Up", 5, 0));
+        assert(simulation.saveCheckpoint(CHECKPOINT_FILE));
+
+        // Cut the file short
+        FILE* file = std::fopen(CHECKPOINT_FILE, "rb");
+        std::vector<char> bytes(1 << 16);
+        size_t size = std::fread(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+        file = std::fopen(CHECKPOINT_FILE, "wb");
+        std::fwrite(bytes.data(), 1, size - 3, file);
+        std::fclose(file);
+        assert(!Simulation::restoreCheckpoint(CHECKPOINT_FILE) && "A cut-off checkpoint is refused");
+        assert(!Simulation::restoreCheckpoint("no_such_checkpoint.bin"));
+    }
+    std::cout << "Test Passed: Checkpoints that cannot be saved or read are refused." << std::endl;
+
+    std::remove(CHECKPOINT_FILE);
+    std::cout << "All checkpoint tests passed successfully." << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include <vector>
+#include <poll.h>
+#include "../ElevatorBank.h"
+#include "../Logger.h"
+
+#define SLEEPERS 10000
+#define BANK_SIZE 2000
+
+// Sleeps, then records how late it woke
+Task sleeper(WorkerPool& pool, int durationMs, std::atomic<int>& finished, std::atomic<long long>& early) {
+    auto start = std::chrono::steady_clock::now();
+    co_await pool.sleep(durationMs);
+    auto slept = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (slept < durationMs) early++;
+    finished++;
+}
+
+int main() {
+    Logger::setLevel(LOG_LEVEL_WARN);
+
+    // Test scenario 1 - thousands of coroutines sleep on a few threads
+    {
+        WorkerPool pool(2);
+        assert(pool.size() == 2);
+        std::atomic<int> finished{0};
+        std::atomic<long long> early{0};
+        std::vector<Task> tasks;
+        for (int i = 0; i < SLEEPERS; i++) {
+            tasks.push_back(sleeper(pool, i % 50, finished, early));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (finished < SLEEPERS && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        assert(finished == SLEEPERS && "Every sleeping coroutine should be resumed");
+        assert(early == 0 && "No coroutine should wake before its time");
+        pool.stop();
+        for (const Task& task : tasks) {
+            assert(task.done());
+        }
+    }
+    std::cout << "Test Passed: Worker pool resumes sleeping coroutines on time." << std::endl;
+
+    // Test scenario 2 - a bank of cars run as coroutines answer their assignments
+    {
+        InProcessTransport transport;
+        Scheduler scheduler(BANK_SIZE, false, &transport);
+        std::unique_ptr<Endpoint> responses = transport.open(SCHEDULER_PORT, SENDERS_MANY);
+        {
+            ElevatorBank bank(scheduler, BANK_SIZE, 2);
+            assert(bank.size() == BANK_SIZE && bank.getPool().size() == 2);
+            for (int i = 0; i < BANK_SIZE; i++) {
+                bank.getCar(i).accept(Event{"14:05:15.0", "3", "UP", 5, true, i, 0, 0, false, 0});
+            }
+            // An assignment for another car is ignored
+            bank.getCar(0).accept(Event{"14:05:15.0", "7", "UP", 9, true, 1, 0, 0, false, 0});
+
+            // Every car reports that it is leaving floor 1 for the call
+            std::set<int> moving;
+            std::vector<Event> events;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (moving.size() < BANK_SIZE && std::chrono::steady_clock::now() < deadline) {
+                struct pollfd ready = {responses->fd(), POLLIN, 0};
+                poll(&ready, 1, 100);
+                responses->receive(events);
+                for (const Event& event : events) {
+                    assert(event.floorButton == "UP" && event.currentFloor == 1);
+                    moving.insert(event.assignedElevator);
+                }
+            }
+            assert(moving.size() == BANK_SIZE && "Every car should start towards its call");
+            assert((bank.getCar(0).getElevator()->getItinerary() == std::vector<int>{3, 5}));
+            // The bank is destroyed while every car is between floors
+        }
+    }
+    std::cout << "Test Passed: Elevator bank runs every car on the worker pool." << std::endl;
+
+    return 0;
+}
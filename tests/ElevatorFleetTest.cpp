@@ -0,0 +1,57 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <vector>
+#include "../ElevatorFleet.h"
+
+int main() {
+    // Test scenario 1 - the AVX2 and scalar kernels agree on every car
+    // (1001 cars so the scalar tail after the last block of eight is exercised)
+    ElevatorFleet fleet(1001);
+    std::mt19937 random(42);
+    for (int i = 0; i < fleet.size(); i++) {
+        fleet.currentFloor[i] = random() % 30 + 1;
+        fleet.state[i] = random() % 5;
+        fleet.busy[i] = random() % 2;
+        fleet.load[i] = random() % (ELEVATOR_CAPACITY + 2);
+        if (random() % 7 == 0) fleet.remove(i);
+    }
+    std::vector<int32_t> simd(fleet.size()), scalar(fleet.size());
+    for (int floor = 1; floor <= 30; floor++) {
+        for (bool up : {true, false}) {
+            fleet.scoreHeuristic(floor, up, simd.data());
+            fleet.scoreHeuristic(floor, up, scalar.data(), false);
+            assert(simd == scalar && "Kernels should give the same scores");
+            assert(fleet.lowestScore(simd.data()) == fleet.lowestScore(scalar.data(), false));
+        }
+    }
+    std::cout << "Test Passed: Kernels agree (AVX2 " << (ElevatorFleet::hasAvx2() ? "used" : "not available") << ")." << std::endl;
+
+    // Test scenario 2 - scores follow the heuristic, full cars lose and removed cars are never chosen
+    ElevatorFleet small(3);
+    small.currentFloor = {1, 6, 9};
+    small.state = {ELEVATOR_REST, ELEVATOR_MOVING_UP, ELEVATOR_MOVING_DOWN};
+    std::vector<int32_t> scores(3);
+    small.scoreHeuristic(7, false, scores.data());
+    assert(scores[0] == SCORE_BASE + 6 * SCORE_PER_FLOOR - SCORE_AT_REST);
+    assert(scores[1] == SCORE_BASE + 1 * SCORE_PER_FLOOR);
+    assert(scores[2] == SCORE_BASE + 2 * SCORE_PER_FLOOR - SCORE_ON_THE_WAY);
+    assert(small.lowestScore(scores.data()) == 2 && "Car coming down towards the call should win");
+    small.load[2] = ELEVATOR_CAPACITY;
+    small.scoreHeuristic(7, false, scores.data());
+    assert(scores[2] == SCORE_BASE + 2 * SCORE_PER_FLOOR - SCORE_ON_THE_WAY + SCORE_FULL);
+    assert(small.lowestScore(scores.data()) == 0 && "A full car should be passed over");
+    small.load[2] = 0;
+    small.remove(2);
+    small.scoreHeuristic(7, false, scores.data());
+    assert(scores[2] == SCORE_REMOVED);
+    assert(small.lowestScore(scores.data()) == 0);
+    small.remove(0);
+    small.remove(1);
+    small.scoreHeuristic(7, false, scores.data());
+    assert(small.lowestScore(scores.data()) == -1 && "No car should be chosen once all are removed");
+    std::cout << "Test Passed: Full and removed cars are skipped." << std::endl;
+
+    std::cout << "All fleet tests passed successfully." << std::endl;
+    return 0;
+}
@@ -61,7 +61,7 @@ int main() {
 
     // Stuck elevator fault
     Event elevator_stuck = createTestEvent(true, "2", "UP", 5, ELEVATOR_STUCK);
-    int elevatorId = scheduler.assignOptimalElevator(elevator_stuck);
+    int elevatorId = scheduler.assignOptimalElevator(elevator_stuck, 0);
     elevatorSubsystems[elevatorId]->getElevator()->setEvent(elevator_stuck);
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
     assert(elevatorSubsystems[elevatorId]->getElevator()->moveTo(2) == false && "Elevator should fail due to being stuck.");
@@ -69,7 +69,7 @@ int main() {
 
     // Arrival sensor fault
     Event arrival_sensor = createTestEvent(true, "3", "DOWN", 1, ARRIVAL_SENSOR_ISSUE);
-    elevatorId = scheduler.assignOptimalElevator(arrival_sensor);
+    elevatorId = scheduler.assignOptimalElevator(arrival_sensor, 0);
     elevatorSubsystems[elevatorId]->getElevator()->setEvent(arrival_sensor);
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
     assert(elevatorSubsystems[elevatorId]->getElevator()->moveTo(3) == false && "Elevator was supposed to fail because the arrival sensor had a fault.");
@@ -77,7 +77,7 @@ int main() {
 
     // Doors open stuck fault
     Event door_open_stuck = createTestEvent(true, "4", "UP", 6, DOOR_OPEN_STUCK);
-    elevatorId = scheduler.assignOptimalElevator(door_open_stuck);
+    elevatorId = scheduler.assignOptimalElevator(door_open_stuck, 0);
     elevatorSubsystems[elevatorId]->getElevator()->openDoors();
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
     assert(elevatorSubsystems[elevatorId]->getElevator()->getState() == ELEVATOR_DOOR_OPEN && "Elevator doors were supposed to be stuck open.");
@@ -85,7 +85,7 @@ int main() {
 
     // Door close stuck fault
     Event door_close_stuck = createTestEvent(true, "5", "DOWN", 2, DOOR_CLOSE_STUCK);
-    elevatorId = scheduler.assignOptimalElevator(door_close_stuck);
+    elevatorId = scheduler.assignOptimalElevator(door_close_stuck, 0);
     elevatorSubsystems[elevatorId]->getElevator()->closeDoors();
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
     assert(elevatorSubsystems[elevatorId]->getElevator()->getState() == ELEVATOR_DOOR_CLOSE && "Elevator doors were supposed to be stuck closed.");
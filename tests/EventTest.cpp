@@ -0,0 +1,72 @@
+#include <iostream>
+#include <chrono>
+#include <cassert>
+#include "../Event.h"
+
+// Encodes an event in the given format and decodes it again
+Event roundTrip(const Event& event, WireFormat format) {
+    Event::wireFormat() = format;
+    return Event::bytes_to_event(event.event_to_bytes());
+}
+
+int main() {
+    // Test scenario 1 - a floor request survives both formats
+    Event request("14:05:15.250", "2", "UP", 4, true, 0, 0, 0, false, 2); // Door stuck open fault
+    request.callMs = 90061234567LL;
+    for (WireFormat format : {WIRE_TEXT, WIRE_BINARY}) {
+        Event decoded = roundTrip(request, format);
+        assert(decoded.source == "2");
+        assert(decoded.floorButton == "UP");
+        assert(decoded.elevatorButton == 4);
+        assert(decoded.isFromFloor);
+        assert(decoded.fault == 2);
+        assert(decoded.callMs == request.callMs && "The time of the press travels with the call");
+        assert(decoded.answering == DIRECTION_IDLE);
+        assert(Event::timeToMillis(decoded.time) == Event::timeToMillis(request.time));
+    }
+    std::cout << "Test Passed: Floor request round trips in text and binary." << std::endl;
+
+    // Test scenario 2 - elevator responses keep their source spelling and flags
+    Event status("10:00:05", "Elevator: 3", "DOWN", 0, false, 3, 7, 2, false, 0);
+    Event done("10:00:05", "Elevator3", "", 9, false, 3, 9, 0, true, 0);
+    Event decodedStatus = roundTrip(status, WIRE_BINARY);
+    Event decodedDone = roundTrip(done, WIRE_BINARY);
+    assert(decodedStatus.source == "Elevator: 3" && !decodedStatus.isFromFloor);
+    assert(decodedStatus.currentFloor == 7 && decodedStatus.riders == 2 && decodedStatus.assignedElevator == 3);
+    assert(decodedStatus.floorButton == "DOWN" && !decodedStatus.isComplete);
+    assert(decodedDone.source == "Elevator3" && decodedDone.isComplete && decodedDone.floorButton.empty());
+
+    // An arrival names the hall call its car has come for
+    Event arrival("10:00:05", "Elevator: 3", "", 0, false, 3, 7, 2, false, 0);
+    arrival.answering = DIRECTION_DOWN;
+    for (WireFormat format : {WIRE_TEXT, WIRE_BINARY}) {
+        Event decodedArrival = roundTrip(arrival, format);
+        assert(decodedArrival.answering == DIRECTION_DOWN && decodedArrival.floorButton.empty());
+    }
+    std::cout << "Test Passed: Elevator responses round trip in binary." << std::endl;
+
+    // Test scenario 3 - mixed case buttons map onto the direction enum
+    Event mixed("10:00:00", "3", "Down", 1, true);
+    assert(mixed.direction() == DIRECTION_DOWN);
+    assert(roundTrip(mixed, WIRE_BINARY).floorButton == "DOWN");
+    assert(Event::timeToMillis("10:00:00") == 36000000);
+    assert(Event::timeToMillis("bad") == -1);
+    std::cout << "Test Passed: Directions and timestamps are parsed." << std::endl;
+
+    // Test scenario 4 - measure encode and decode cost on a reused buffer
+    const int iterations = 1000000;
+    uint8_t buffer[EVENT_WIRE_SIZE];
+    Event target;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        status.currentFloor = i & 0xFF;
+        status.encode(buffer, sizeof(buffer));
+        Event::decode(buffer, sizeof(buffer), target);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    assert(target.currentFloor == ((iterations - 1) & 0xFF));
+    std::cout << "Binary encode+decode: " << elapsed.count() / iterations << " ns/event" << std::endl;
+
+    std::cout << "All event tests passed successfully." << std::endl;
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <thread>
+#include <chrono>
 #include <cassert>
+#include <cstdlib>
 #include "../Floor.h"
 #include "../Scheduler.h"
 #include "../ElevatorSubsystem.h"
@@ -17,6 +19,19 @@ Event createTestEvent(const std::string& source, const std::string& floorBtn, in
     return event;
 }
 
+// The scheduler ends the process once every event is complete, so its metrics are checked on the way out
+Scheduler* finishedScheduler = nullptr;
+
+void checkJoinedWaits() {
+    // The riders who joined a lit button waited from their own press until the car came,
+    // and no wait came out negative
+    const PassengerMetrics& metrics = finishedScheduler->getMetrics();
+    assert(metrics.getOverall().wait.negatives() == 0 && "Waits should start at the press");
+    assert(metrics.getOverall().wait.count() == 5);
+    assert(metrics.getFloor(5)->wait.percentile(0) > 1000 && "Joined riders at floor 5 should have waited");
+    std::cout << "Test Passed: Joined riders are timed from their own press." << std::endl;
+}
+
 int main() {
     // simulated input file
     const char* tempFileName = "temp_floor_test.txt";
@@ -36,10 +51,14 @@ int main() {
 
     int NUM_ELEVATORS = 4;
     Scheduler scheduler(NUM_ELEVATORS);
+    finishedScheduler = &scheduler;
+    std::atexit(checkJoinedWaits);
     std::cout << "Scheduler created with 2 elevators" << std::endl;
 
     Floor floor(scheduler, tempFileName);
     std::cout << "Floor instance created" << std::endl;
+    // The events span 477 seconds, replayed in under half a second
+    floor.setReplaySpeed(1000);
     assert(floor.getCompletedEvents() == 0 && "Floor should have 0 completed events initially");
     
     // Use a vector to store all the elevatorSubsystems, each with its own port
@@ -54,6 +73,7 @@ int main() {
     }
 
     // Create scheduler and floor threads
+    auto start = std::chrono::steady_clock::now();
     std::thread schedulerThread(&Scheduler::run, &scheduler);
     std::thread floorThread(&Floor::run, &floor);
 
@@ -61,6 +81,17 @@ int main() {
     floorThread.join();
     assert(floor.getTotalEvents() > 0 && "Floor thread did not complete successfully.");
 
+    // The last event is due 477 ms in, and no event should go out much later than it was due
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    assert(elapsed.count() >= 477 && "Floor sent the last event before it was due");
+    assert(floor.getMaxDriftUs() < 50000 && "Floor sent an event more than 50 ms late");
+    std::cout << "Test Passed: Events replayed at 1000x, max drift " << floor.getMaxDriftUs() << "us" << std::endl;
+
+    // Floor 5 is called up again 120 ms after the first call, and floor 2 (to go up to 4)
+    // 358 ms after, both long before a car gets there
+    assert(floor.getJoinedPresses() == 2 && "A press of a lit button should not be sent");
+    std::cout << "Test Passed: Presses of a lit hall button joined the waiting calls." << std::endl;
+
     // Wait for scheduler thread to complete
     schedulerThread.join();
     scheduler.finish();
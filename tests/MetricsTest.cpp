@@ -0,0 +1,113 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../Metrics.h"
+
+// Checks a histogram percentile against the exact value from sorted samples
+void checkPercentile(const HdrHistogram& histogram, std::vector<int64_t>& sorted, double percent) {
+    int64_t exact = sorted[std::max<size_t>(1, static_cast<size_t>(percent / 100.0 * sorted.size() + 0.5)) - 1];
+    int64_t estimate = histogram.percentile(percent);
+    assert(estimate >= exact && "Percentiles are rounded up to the end of their bucket");
+    assert(estimate <= exact + exact / 64 + 1 && "Percentiles should be within 1.6% of the exact value");
+}
+
+int main() {
+    // Test scenario 1 - buckets cover every value exactly once, small values exactly
+    for (int64_t value = 0; value < 128; value++) {
+        assert(HdrHistogram::bucketOf(value) == static_cast<size_t>(value));
+    }
+    for (int64_t value = 128; value < 1 << 20; value++) {
+        size_t bucket = HdrHistogram::bucketOf(value);
+        assert(HdrHistogram::highestInBucket(bucket) >= value);
+        assert(bucket == 0 || HdrHistogram::highestInBucket(bucket - 1) < value);
+    }
+    assert(HdrHistogram::bucketOf(int64_t(1) << 40) == HISTOGRAM_BUCKETS - 1 && "Large values are clamped");
+    std::cout << "Test Passed: Histogram buckets are contiguous." << std::endl;
+
+    // Test scenario 2 - percentiles match sorted samples within the bucket error
+    {
+        HdrHistogram histogram;
+        std::mt19937 random(7);
+        std::lognormal_distribution<double> waits(10.0, 1.0);
+        std::vector<int64_t> samples;
+        for (int i = 0; i < 100000; i++) {
+            int64_t value = static_cast<int64_t>(waits(random));
+            samples.push_back(value);
+            histogram.record(value);
+        }
+        std::sort(samples.begin(), samples.end());
+        for (double percent : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+            checkPercentile(histogram, samples, percent);
+        }
+        assert(histogram.maximum() == samples.back());
+        assert(histogram.count() == samples.size());
+
+        // Merging two halves gives the histogram of all the samples
+        HdrHistogram first, second, merged;
+        for (size_t i = 0; i < samples.size(); i++) {
+            (i % 2 ? first : second).record(samples[i]);
+        }
+        merged.add(first);
+        merged.add(second);
+        assert(merged.count() == histogram.count() && merged.mean() == histogram.mean());
+        assert(merged.maximum() == histogram.maximum());
+        for (double percent : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+            assert(merged.percentile(percent) == histogram.percentile(percent));
+        }
+    }
+    std::cout << "Test Passed: Percentiles are within the histogram's precision." << std::endl;
+
+    // Test scenario 3 - threads record into shared histograms without losing counts
+    {
+        PassengerMetrics metrics(4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&metrics, t]() {
+                for (int i = 0; i < 50000; i++) {
+                    TripTimes times;
+                    times.callMs = 0;
+                    times.arrivalMs = 1000;
+                    times.boardMs = 5000;
+                    times.destinationMs = 20000 + t;
+                    metrics.recordTrip(t, i % 10 + 1, times);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(metrics.getOverall().journey.count() == 200000);
+        assert(metrics.getOverall().wait.mean() == 1000);
+        assert(metrics.getOverall().ride.percentile(50) >= 15000);
+        assert(metrics.getOverall().journey.maximum() == 20003);
+        for (int floor = 1; floor <= 10; floor++) {
+            assert(metrics.getFloor(floor)->wait.count() == 20000);
+        }
+        assert(metrics.getFloor(11) == nullptr && "Floors without trips have no histograms");
+        for (int car = 0; car < 4; car++) {
+            assert(metrics.getCar(car)->journey.count() == 50000);
+            assert(metrics.getCar(car)->journey.maximum() == 20000 + car);
+        }
+        assert(metrics.getCar(4) == nullptr);
+    }
+    std::cout << "Test Passed: Concurrent trips are counted per floor and per car." << std::endl;
+
+    // Test scenario 4 - a negative time is counted as an error, not as a zero
+    {
+        HdrHistogram histogram;
+        histogram.record(40);
+        histogram.record(-5);
+        assert(histogram.count() == 1 && histogram.negatives() == 1);
+        assert(histogram.percentile(1) == 40 && "The negative value must not pull the low percentiles to 0");
+        HdrHistogram merged;
+        merged.add(histogram);
+        assert(merged.negatives() == 1);
+    }
+    std::cout << "Test Passed: Negative times are left out and counted." << std::endl;
+
+    std::cout << "All metrics tests passed successfully." << std::endl;
+    return 0;
+}
@@ -21,8 +21,86 @@ Event createTestEvent(bool isFromFloor, const std::string& source,
     return event;
 }
 
+// Reports a car's position the way Elevator::endMove and beginMove do
+Event createPositionUpdate(int elevatorId, int floor, const std::string& direction) {
+    return Event{"", "Elevator: " + std::to_string(elevatorId), direction, 0, false, elevatorId, floor, 0, false, 0};
+}
+
 // Run testing program
 int main() {
+    // Dispatch policies on the same situation: car 0 has picked up a passenger at
+    // floor 2 for floor 9 and is about to head up, car 1 is idle at floor 1
+    for (DispatchPolicy policy : {DispatchPolicy::DISPATCH_HEURISTIC, DispatchPolicy::DISPATCH_LOOK, DispatchPolicy::DISPATCH_ETA}) {
+        Scheduler policyScheduler(2, false);
+        policyScheduler.setDispatchPolicy(policy);
+        assert(policyScheduler.assignOptimalElevator(createTestEvent(true, "2", "UP", 9, 0), 0) == 0);
+        policyScheduler.updateElevatorInfo(createPositionUpdate(0, 2, ""), 0);
+
+        // A call ahead of car 0 going its way
+        int onTheWay = policyScheduler.assignOptimalElevator(createTestEvent(true, "4", "UP", 7, 0), 0);
+        // A call car 0 has already passed
+        int behind = policyScheduler.assignOptimalElevator(createTestEvent(true, "1", "UP", 5, 0), 0);
+        if (policy == DispatchPolicy::DISPATCH_LOOK) {
+            assert(onTheWay == 0 && "LOOK should give a call on the way to the car sweeping past it");
+            assert(behind == 1 && "LOOK should not give a passed call to a car moving away");
+            std::cout << "Test passed: LOOK assigned calls to the car passing them" << std::endl;
+        } else if (policy == DispatchPolicy::DISPATCH_ETA) {
+            // Car 0 arrives in 11s but its stop holds up the rider for 8s; car 1 arrives in 13s
+            assert(onTheWay == 1 && "ETA should count the delay to car 0's rider");
+            assert(behind == 1 && "ETA should not give a passed call to a car moving away");
+            std::cout << "Test passed: ETA weighed arrival against the delay to riders" << std::endl;
+        } else {
+            assert(onTheWay == 1 && "Heuristic avoids the busy car");
+            std::cout << "Test passed: Heuristic policy still selectable" << std::endl;
+        }
+    }
+
+    // Stops cost more than LOOK's flat per-stop charge: car 0 at floor 1 has riders for
+    // floors 2 and 3, car 1 is idle at floor 12, and a call comes from floor 4
+    for (DispatchPolicy policy : {DispatchPolicy::DISPATCH_LOOK, DispatchPolicy::DISPATCH_ETA}) {
+        Scheduler policyScheduler(2, false);
+        policyScheduler.setDispatchPolicy(policy);
+        policyScheduler.updateElevatorInfo(createPositionUpdate(1, 12, ""), 0);
+        assert(policyScheduler.assignOptimalElevator(createTestEvent(true, "1", "UP", 2, 0), 0) == 0);
+        assert(policyScheduler.assignOptimalElevator(createTestEvent(true, "1", "UP", 3, 0), 0) == 0);
+        policyScheduler.updateElevatorInfo(createPositionUpdate(0, 1, ""), 0);
+
+        int chosen = policyScheduler.assignOptimalElevator(createTestEvent(true, "4", "UP", 8, 0), 0);
+        if (policy == DispatchPolicy::DISPATCH_LOOK) {
+            assert(chosen == 0 && "LOOK counts 3 floors and 2 stops against 8 floors");
+        } else {
+            // Car 0: three 9s hops and two 8s stops is 43s; car 1: 8 floors is 32s
+            const EtaModel& etas = policyScheduler.getEtaModel();
+            assert(etas.getTravelTimes().at(12, 4) == 32000 && etas.getTravelTimes().at(1, 2) == 9000);
+            assert(etas.getRoute(0).size() == 3 && etas.getRoute(0)[2].departMs == 34000);
+            assert(chosen == 1 && "ETA should see the stops cost more than the longer trip");
+        }
+    }
+    std::cout << "Test passed: ETA counts door and transfer times at each stop" << std::endl;
+
+    // Routes are timed from each car's last report: car 0 left floor 1 at 0s for a rider
+    // to floor 9, car 1 rests at floor 5, and a call comes from floor 9
+    for (long long nowMs : {0LL, 20000LL}) {
+        Scheduler etaScheduler(2, false);
+        etaScheduler.setDispatchPolicy(DispatchPolicy::DISPATCH_ETA);
+        etaScheduler.updateElevatorInfo(createPositionUpdate(1, 5, ""), 0);
+        assert(etaScheduler.assignOptimalElevator(createTestEvent(true, "1", "UP", 9, 0), 0) == 0);
+        etaScheduler.updateElevatorInfo(createPositionUpdate(0, 1, "UP"), 0);
+
+        const EtaModel& etas = etaScheduler.getEtaModel();
+        const TravelTimeTable& travel = etas.getTravelTimes();
+        Itinerary::Pickup call{9, 12, Direction::DIRECTION_UP};
+        assert(etas.eta(0, call, nowMs) == travel.at(1, 9) - nowMs && "Car 0 is that much nearer floor 9");
+        assert(etas.eta(1, call, nowMs) == travel.at(5, 9) && "An idle car sets off when called");
+        int chosen = etaScheduler.assignOptimalElevator(createTestEvent(true, "9", "UP", 12, 0), nowMs);
+        if (nowMs == 0) {
+            assert(chosen == 1 && "Car 0 has 8 floors to go, car 1 only 4");
+        } else {
+            assert(chosen == 0 && "20s on, car 0 is closer than car 1");
+        }
+    }
+    std::cout << "Test passed: ETA takes off the time since each car reported" << std::endl;
+
     // Create Scheduler with 3 elevators
     Scheduler scheduler(NUM_ELEVATORS);
     std::cout << "Scheduler created with 3 elevators" << std::endl;
@@ -50,7 +128,7 @@ int main() {
     
     // Test scenario 1 - no fault
     Event noFaultRequest = createTestEvent(true, "1", "UP", 3, 0);
-    int elevator1 = scheduler.assignOptimalElevator(noFaultRequest);
+    int elevator1 = scheduler.assignOptimalElevator(noFaultRequest, 0);
     elevatorSubsystems[elevator1]->getElevator()->setEvent(noFaultRequest);
     std::cout << "Floor 3 with button UP request assigned to elevator " << elevator1 << std::endl;
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
@@ -62,7 +140,7 @@ int main() {
 
     // Test scenario 2 - doors open stuck fault
     Event doorsOpenRequest = createTestEvent(true, "4", "DOWN", 2, DOOR_OPEN_STUCK);
-    int elevator2 = scheduler.assignOptimalElevator(doorsOpenRequest);
+    int elevator2 = scheduler.assignOptimalElevator(doorsOpenRequest, 0);
     elevatorSubsystems[elevator2]->getElevator()->setEvent(doorsOpenRequest);
     std::cout << "Floor 7 with button DOWN request assigned to elevator " << elevator2 << std::endl;
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
@@ -76,7 +154,7 @@ int main() {
 
     // Test scenario 3 - door close stuck fault
     Event doorsCloseRequest = createTestEvent(true, "5", "DOWN", 1, DOOR_CLOSE_STUCK);
-    int elevator3 = scheduler.assignOptimalElevator(doorsCloseRequest);
+    int elevator3 = scheduler.assignOptimalElevator(doorsCloseRequest, 0);
     elevatorSubsystems[elevator3]->getElevator()->setEvent(doorsCloseRequest);
     std::cout << "Floor 5 button DOWN request assigned to elevator: " << elevator3 << std::endl;
     std::this_thread::sleep_for(std::chrono::seconds(2)); 
@@ -90,7 +168,7 @@ int main() {
 
     // Test scenario 4 - arrival sensor fault
     Event arrivalSensorRequest = createTestEvent(true, "3", "UP", 6, ARRIVAL_SENSOR_ISSUE);
-    int elevator4 = scheduler.assignOptimalElevator(arrivalSensorRequest);
+    int elevator4 = scheduler.assignOptimalElevator(arrivalSensorRequest, 0);
     elevatorSubsystems[elevator4]->getElevator()->setEvent(arrivalSensorRequest);
     elevatorSubsystems[elevator4]->removeElevator();
     std::cout << "Floor 3 button UP request assigned to elevator: " << elevator4 << std::endl;
@@ -103,7 +181,7 @@ int main() {
 
      // Test scenario 1 - elevator stuck fault
      Event elevatorStuckRequest = createTestEvent(true, "1", "UP", 3, 1);
-     int elevator5 = scheduler.assignOptimalElevator(elevatorStuckRequest);
+     int elevator5 = scheduler.assignOptimalElevator(elevatorStuckRequest, 0);
      elevatorSubsystems[elevator1]->getElevator()->setEvent(elevatorStuckRequest);
      std::cout << "Floor 3 with button UP request assigned to elevator " << elevator1 << std::endl;
      std::this_thread::sleep_for(std::chrono::seconds(2)); 
@@ -0,0 +1,236 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+#include <algorithm>
+#include "../Simulation.h"
+
+// Test event creation function
+Event createTestEvent(const std::string& source, const std::string& floorBtn, int elevatorBtn, int faultType) {
+    Event event;
+    event.isFromFloor = true;
+    event.source = source;
+    event.floorButton = floorBtn;
+    event.elevatorButton = elevatorBtn;
+    event.fault = faultType;
+    return event;
+}
+
+int main() {
+    // Test scenario 1 - a single trip takes exactly its modelled time
+    // 1->2 (9s), open (2s), load (4s), close (2s), 2->4 (11s), open (2s), unload (4s), close (2s)
+    {
+        Simulation simulation(4);
+        simulation.addFloorEvent(0, createTestEvent("2", "Up", 4, 0));
+        simulation.run();
+        assert(simulation.getCompletedEvents() == 1 && "Trip should complete");
+        assert(simulation.now() == 36000 && "Trip should take 36 simulated seconds");
+        Elevator* elevator = simulation.getElevatorSubsystem(0).getElevator();
+        assert(elevator->getCurrentFloor() == 4 && "Elevator should end at the destination");
+        assert(elevator->getTotalPassengers() == 1 && "Elevator should have served one passenger");
+        std::cout << "Test Passed: Single trip completed in simulated time." << std::endl;
+    }
+
+    // Test scenario 2 - a stuck car hands its waiting calls to another car, keeps its riders and recovers
+    {
+        // Car 0's watchdog goes off 2s after it was due at floor 5 (18s), then car 1 takes the call:
+        // 1->5 (16s), stop (8s), 5->7 (11s), stop (8s)
+        Simulation simulation(4);
+        simulation.addFloorEvent(0, createTestEvent("5", "Up", 7, ELEVATOR_STUCK));
+        // Due at floor 5 at 16s without reporting, the car is only faulted when its watchdog goes off
+        simulation.runUntil(17999);
+        assert(simulation.getScheduler().getRemovedElevators().empty() && "No fault before the watchdog expires");
+        simulation.runUntil(18000);
+        assert(simulation.getElevatorSubsystem(0).getElevator()->isOutOfService());
+        simulation.run();
+        assert(simulation.getCompletedEvents() == 1 && "Reassigned call should complete");
+        assert(simulation.now() == 61000 && "Reassigned call should be picked up by the next car");
+        assert(simulation.getScheduler().getMetrics().getReassigned() == 1);
+        assert(simulation.getElevatorSubsystem(1).getElevator()->getTotalPassengers() == 1);
+        Elevator* stuck = simulation.getElevatorSubsystem(0).getElevator();
+        assert(!stuck->isOutOfService() && "Stuck car should be back in service");
+        assert(simulation.getScheduler().getRemovedElevators().empty());
+
+        // A rider stays on board: stop at 1 (8s), stuck on 1->4 (13s + 2s), recovery (30s), 1->4 (13s), stop (8s)
+        Simulation single(1);
+        single.addFloorEvent(0, createTestEvent("1", "Up", 4, ELEVATOR_STUCK));
+        single.run();
+        assert(single.getCompletedEvents() == 1 && "Rider should be delivered after recovery");
+        assert(single.now() == 74000);
+        assert(single.getScheduler().getMetrics().getReassigned() == 0);
+        assert(single.getElevatorSubsystem(0).getElevator()->getCurrentFloor() == 4);
+
+        // The handed-back passenger waited from the press, through the stuck car, until car 1
+        // reached floor 5: the watchdog at 18s, then 1->5 (16s)
+        const HdrHistogram& wait = simulation.getScheduler().getMetrics().getOverall().wait;
+        assert(wait.count() == 1 && wait.maximum() == 34000);
+
+        // A call pressed before it reached the scheduler is timed from the press
+        Simulation late(1);
+        Event delayed = createTestEvent("1", "Up", 2, 0);
+        delayed.callMs = 1000;
+        late.addFloorEvent(4000, delayed);
+        late.run();
+        assert(late.getScheduler().getMetrics().getOverall().wait.maximum() == 3000);
+        std::cout << "Test Passed: Stuck car handed its calls on and recovered." << std::endl;
+    }
+
+    // Test scenario 3 - replaying the same input gives the same result
+    const char* tempFileName = "temp_simulation_test.txt";
+    std::ofstream outFile(tempFileName);
+    assert(outFile.is_open());
+    outFile << "Header line 1\n";
+    outFile << "Header line 2\n";
+    outFile << "10:00:00 5 UP 10 0\n";
+    outFile << "10:00:05 3 DOWN 1 2\n";
+    outFile << "10:00:10 8 DOWN 2 3\n";
+    outFile << "10:00:15 1 UP 9 0\n";
+    outFile << "10:00:20 6 DOWN 3 0\n";
+    outFile.close();
+
+    long long firstEnd = 0;
+    for (int run = 0; run < 2; run++) {
+        Simulation simulation(4);
+        assert(simulation.loadFile(tempFileName));
+        simulation.run();
+        assert(simulation.getTotalEvents() == 5);
+        assert(simulation.getCompletedEvents() == 5 && "All events should complete");
+        if (run == 0) {
+            firstEnd = simulation.now();
+        } else {
+            assert(simulation.now() == firstEnd && "Replays should be deterministic");
+        }
+    }
+    std::cout << "Test Passed: Replays finish at the same simulated time." << std::endl;
+
+    // Test scenario 4 - pacing at 1000x stretches 36 simulated seconds to about 36ms
+    {
+        Simulation simulation(4, 1000);
+        simulation.addFloorEvent(0, createTestEvent("2", "Up", 4, 0));
+        auto start = std::chrono::steady_clock::now();
+        simulation.run();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        assert(elapsed.count() >= 35 && "Paced run should follow the wall clock");
+        std::cout << "Test Passed: Paced run followed the wall clock." << std::endl;
+    }
+
+    // Test scenario 5 - calls along the way are served in one sweep
+    // 1->2 (9s), stop (8s), 2->4 (11s), stop (8s), 4->6 (11s), stop (8s), 6->8 (11s), stop (8s)
+    {
+        Simulation simulation(1);
+        simulation.addFloorEvent(0, createTestEvent("2", "Up", 6, 0));
+        simulation.addFloorEvent(1000, createTestEvent("4", "Up", 8, 0));
+        simulation.run();
+        assert(simulation.getCompletedEvents() == 2 && "Both trips should complete");
+        assert(simulation.now() == 74000 && "Second passenger should be picked up on the way");
+        Elevator* elevator = simulation.getElevatorSubsystem(0).getElevator();
+        assert(elevator->getTotalPassengers() == 2);
+        assert(elevator->getPassengers() == 0);
+        assert(elevator->getItinerary().empty());
+
+        // Waits of 9s and 27s, journeys of 47s and 65s, rides of 32s each
+        const PassengerMetrics::TripHistograms& trips = simulation.getScheduler().getMetrics().getOverall();
+        assert(trips.journey.count() == 2);
+        assert(trips.wait.mean() == 18000 && trips.wait.maximum() == 27000);
+        assert(trips.ride.mean() == 32000);
+        assert(trips.journey.mean() == 56000 && trips.journey.maximum() == 65000);
+        assert(simulation.getScheduler().getMetrics().getFloor(4)->wait.maximum() == 27000);
+        std::cout << "Test Passed: Two calls served in a single sweep." << std::endl;
+    }
+
+    // Test scenario 6 - stops are ordered in sweeps, skipping calls going the other way
+    {
+        Itinerary itinerary;
+        itinerary.pickups.push_back({3, 7, DIRECTION_UP});
+        itinerary.pickups.push_back({8, 2, DIRECTION_DOWN});
+        itinerary.dropoffs.push_back(6);
+        std::vector<int> expected = {6, 8, 2, 3, 7};
+        assert(itinerary.plan(5, DIRECTION_UP) == expected && "Stops should follow the LOOK order");
+        std::cout << "Test Passed: Itinerary follows the sweep order." << std::endl;
+    }
+
+    // Test scenario 7 - batch windows hold calls until their car is ready, then assign them together
+    {
+        // The trips of scenario 5, each sent on when its 500ms window closes
+        Simulation simulation(1);
+        simulation.getScheduler().setBatchWindow(500);
+        simulation.addFloorEvent(0, createTestEvent("2", "Up", 6, 0));
+        simulation.addFloorEvent(1000, createTestEvent("4", "Up", 8, 0));
+        simulation.run();
+        assert(simulation.getCompletedEvents() == 2);
+        assert(simulation.now() == 74500 && "Each call should wait only for its window");
+        assert(simulation.getScheduler().getHeldCallCount() == 0);
+        // Waits run from the press, so the time a call was held is part of its wait
+        const HdrHistogram& held = simulation.getScheduler().getHeldMillis();
+        const HdrHistogram& wait = simulation.getScheduler().getMetrics().getOverall().wait;
+        Simulation unbatched(1);
+        unbatched.addFloorEvent(0, createTestEvent("2", "Up", 6, 0));
+        unbatched.addFloorEvent(1000, createTestEvent("4", "Up", 8, 0));
+        unbatched.run();
+        const HdrHistogram& direct = unbatched.getScheduler().getMetrics().getOverall().wait;
+        assert(held.count() == 2 && held.maximum() == 500);
+        assert(wait.maximum() == direct.maximum() + held.maximum() && "The hold should count in the wait");
+        assert(wait.percentile(0) > direct.percentile(0));
+
+        // Two calls in one window go to different idle cars
+        Simulation pair(2);
+        pair.getScheduler().setBatchWindow(500);
+        pair.addFloorEvent(0, createTestEvent("5", "Up", 9, 0));
+        pair.addFloorEvent(100, createTestEvent("6", "Up", 9, 0));
+        pair.run();
+        assert(pair.getCompletedEvents() == 2);
+        assert(pair.getElevatorSubsystem(0).getElevator()->getTotalPassengers() == 1);
+        assert(pair.getElevatorSubsystem(1).getElevator()->getTotalPassengers() == 1);
+        std::cout << "Test Passed: Batch windows assign held calls jointly." << std::endl;
+    }
+
+    // Test scenario 8 - a full car leaves callers it has no room for to the next car
+    {
+        // Collective control gives calls to the nearest car until it is full
+        Simulation pair(2);
+        pair.getScheduler().setDispatchPolicy(DispatchPolicy::DISPATCH_LOOK);
+        for (int i = 0; i < ELEVATOR_CAPACITY + 2; i++) {
+            pair.addFloorEvent(0, createTestEvent("1", "Up", 5, 0));
+        }
+        pair.run();
+        assert(pair.getCompletedEvents() == ELEVATOR_CAPACITY + 2);
+        assert(pair.getElevatorSubsystem(0).getElevator()->getTotalPassengers() == ELEVATOR_CAPACITY);
+        assert(pair.getElevatorSubsystem(1).getElevator()->getTotalPassengers() == 2);
+        assert(pair.getScheduler().getMetrics().getReassigned() == 0);
+
+        // With one car the two left behind wait for its second trip:
+        // open (2s), load 10 (40s), close (2s), 1->5 (16s), open (2s), unload 10 (40s), close (2s),
+        // 5->1 (16s), open (2s), load 2 (8s), close (2s), 1->5 (16s), open (2s), unload 2 (8s), close (2s)
+        Simulation single(1);
+        for (int i = 0; i < ELEVATOR_CAPACITY + 2; i++) {
+            single.addFloorEvent(0, createTestEvent("1", "Up", 5, 0));
+        }
+        single.run();
+        assert(single.getCompletedEvents() == ELEVATOR_CAPACITY + 2);
+        assert(single.now() == 160000);
+        assert(single.getScheduler().getMetrics().getReassigned() == 2 && "Callers left behind should be handed back");
+        assert(single.getElevatorSubsystem(0).getElevator()->getTotalPassengers() == ELEVATOR_CAPACITY + 2);
+        std::cout << "Test Passed: Full car left callers for another trip." << std::endl;
+    }
+
+    // Test scenario 9 - presses of a lit button join the car already answering it
+    {
+        // The heuristic would send each of these to a different idle car
+        Simulation simulation(4);
+        simulation.addFloorEvent(0, createTestEvent("5", "Up", 9, 0));
+        simulation.addFloorEvent(1000, createTestEvent("5", "Up", 8, 0));
+        simulation.addFloorEvent(2000, createTestEvent("5", "Up", 10, 0));
+        simulation.addFloorEvent(3000, createTestEvent("5", "Down", 1, 0));
+        simulation.run();
+        assert(simulation.getCompletedEvents() == 4);
+        assert(simulation.getScheduler().getJoinedCalls() == 2);
+        assert(simulation.getElevatorSubsystem(0).getElevator()->getTotalPassengers() == 3);
+        assert(simulation.getElevatorSubsystem(1).getElevator()->getTotalPassengers() == 1
+               && "A call the other way is assigned on its own");
+        std::cout << "Test Passed: Presses of a lit button joined its call." << std::endl;
+    }
+
+    std::remove(tempFileName);
+    std::cout << "All simulation tests passed successfully." << std::endl;
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <cassert>
+#include "../SweepRunner.h"
+#include "../Simulation.h"
+#include "../Logger.h"
+
+std::vector<std::pair<long long, Event>> createTraffic() {
+    std::vector<std::pair<long long, Event>> calls;
+    for (int i = 0; i < 12; i++) {
+        Event call("0", std::to_string(i % 5 + 1), "Up", i % 5 + 6, true);
+        calls.emplace_back(i * 4000LL, call);
+    }
+    return calls;
+}
+
+struct Waits {
+    int64_t count;
+    double mean;
+    int64_t maximum;
+};
+
+// Runs one replay of the traffic the way the sweep does with no jitter
+Waits runAlone(int cars, DispatchPolicy policy) {
+    Simulation simulation(cars);
+    simulation.getScheduler().setDispatchPolicy(policy);
+    for (const auto& [at, event] : createTraffic()) {
+        simulation.addFloorEvent(at, event);
+    }
+    simulation.run();
+    const HdrHistogram& wait = simulation.getScheduler().getMetrics().getOverall().wait;
+    return {static_cast<int64_t>(wait.count()), wait.mean(), static_cast<int64_t>(wait.maximum())};
+}
+
+int main() {
+    Logger::setLevel(LOG_LEVEL_WARN);
+
+    // Test scenario 1 - without jitter every run is the recorded day, so each configuration
+    // measures what a single simulation of it does, once per run
+    {
+        SweepRunner sweep(createTraffic());
+        sweep.setJitter(0);
+        sweep.setThreads(2);
+        sweep.add({2, DispatchPolicy::DISPATCH_LOOK, 0});
+        sweep.add({4, DispatchPolicy::DISPATCH_ETA, 0});
+        const auto& results = sweep.run(3);
+        assert(results.size() == 2);
+        const std::pair<int, DispatchPolicy> alone[] = {
+            {2, DispatchPolicy::DISPATCH_LOOK},
+            {4, DispatchPolicy::DISPATCH_ETA},
+        };
+        for (size_t i = 0; i < results.size(); i++) {
+            const SweepRunner::Result& result = *results[i];
+            Waits wait = runAlone(alone[i].first, alone[i].second);
+            assert(result.runs == 3 && "Each configuration runs once per seed");
+            assert(result.calls == 36 && result.completed == 36 && "Every call of every run is served");
+            assert(result.wait.count() == static_cast<uint64_t>(3 * wait.count));
+            assert(result.wait.mean() == wait.mean);
+            assert(result.wait.maximum() == wait.maximum);
+            assert(result.journey.count() == 36);
+            assert(result.tripsPerHour > 0);
+        }
+    }
+    std::cout << "Test Passed: Runs without jitter repeat a single simulation." << std::endl;
+
+    // Test scenario 2 - each seed moves the calls the same way however many threads run them
+    {
+        SweepRunner one(createTraffic());
+        SweepRunner many(createTraffic());
+        one.setThreads(1);
+        many.setThreads(4);
+        for (SweepRunner* sweep : {&one, &many}) {
+            sweep->setJitter(10000);
+            sweep->add({2, DispatchPolicy::DISPATCH_HEURISTIC, 0});
+            sweep->add({3, DispatchPolicy::DISPATCH_LOOK, 2000});
+        }
+        const auto& serial = one.run(5);
+        const auto& parallel = many.run(5);
+        for (size_t i = 0; i < serial.size(); i++) {
+            assert(parallel[i]->runs == 5);
+            assert(parallel[i]->completed == serial[i]->completed);
+            assert(parallel[i]->wait.count() == serial[i]->wait.count());
+            assert(parallel[i]->wait.mean() == serial[i]->wait.mean());
+            assert(parallel[i]->journey.percentile(95) == serial[i]->journey.percentile(95));
+            assert(parallel[i]->journey.maximum() == serial[i]->journey.maximum());
+            assert(parallel[i]->held.mean() == serial[i]->held.mean());
+        }
+        // Only the batched configuration holds calls, and its waits include the hold
+        assert(serial[0]->held.count() == 0);
+        assert(serial[1]->held.count() > 0 && serial[1]->held.maximum() <= serial[1]->wait.maximum());
+    }
+    std::cout << "Test Passed: Seeded runs measure the same on one thread as on four." << std::endl;
+
+    // Test scenario 3 - the sweep quietens the logger while it runs and gives back the caller's level
+    {
+        Logger::setLevel(LOG_LEVEL_INFO);
+        SweepRunner sweep(createTraffic());
+        sweep.add({2, DispatchPolicy::DISPATCH_LOOK, 0});
+        sweep.run(1);
+        assert(Logger::getLevel() == LOG_LEVEL_INFO);
+        Logger::setLevel(LOG_LEVEL_WARN);
+    }
+    std::cout << "Test Passed: Sweeps restore the caller's log level." << std::endl;
+
+    std::cout << "All sweep runner tests passed successfully." << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <vector>
+#include "../TimingWheel.h"
+
+int main() {
+    // Test scenario 1 - timers at every level fire on their tick, in expiry order
+    {
+        TimingWheel wheel(1000);
+        std::mt19937 random(7);
+        std::vector<long long> delays;
+        for (int i = 0; i < 2000; i++) {
+            // Spread over all four levels and past the end of the wheel
+            int level = i % 5;
+            long long limit = level == 4 ? 40000000LL : (1LL << (WHEEL_SLOT_BITS * (level + 1)));
+            delays.push_back(std::uniform_int_distribution<long long>(0, limit)(random));
+        }
+        std::vector<long long> fired;
+        for (long long delay : delays) {
+            long long due = 1000 + delay;
+            wheel.schedule(delay, [&wheel, &fired, due]() {
+                assert(wheel.now() == due && "Timer should fire on its own tick");
+                fired.push_back(due);
+            });
+        }
+        assert(wheel.size() == delays.size());
+
+        // Advance in uneven steps, as a timer thread waking late would
+        long long now = 1000;
+        while (wheel.size() > 0) {
+            long long next = wheel.nextExpiry();
+            assert(next >= 0);
+            now = std::max(now, next) + std::uniform_int_distribution<int>(0, 3)(random);
+            wheel.advance(now);
+            for (long long due : fired) {
+                assert(due <= now && "Timer should not fire early");
+            }
+        }
+        assert(fired.size() == delays.size());
+        assert(std::is_sorted(fired.begin(), fired.end()) && "Timers should fire in expiry order");
+        std::cout << "Test Passed: Timers fired on time across every level." << std::endl;
+    }
+
+    // Test scenario 2 - cancelled timers never fire and ids are not reused
+    {
+        TimingWheel wheel;
+        int fired = 0;
+        std::vector<TimingWheel::TimerId> ids;
+        for (int i = 0; i < 100; i++) {
+            ids.push_back(wheel.schedule(i * 50, [&fired]() { fired++; }));
+        }
+        for (int i = 0; i < 100; i += 2) {
+            assert(wheel.cancel(ids[i]));
+        }
+        assert(!wheel.cancel(ids[0]) && "A timer is cancelled only once");
+        assert(wheel.size() == 50);
+
+        // The freed nodes are reused, but the old ids no longer match them
+        TimingWheel::TimerId reused = wheel.schedule(10, [&fired]() { fired += 1000; });
+        assert(!wheel.cancel(ids[2]));
+        wheel.advance(10000);
+        assert(fired == 1050);
+        assert(!wheel.cancel(reused) && "A fired timer cannot be cancelled");
+        assert(wheel.size() == 0 && wheel.nextExpiry() == -1);
+        std::cout << "Test Passed: Cancelled timers did not fire." << std::endl;
+    }
+
+    // Test scenario 3 - callbacks can schedule and cancel, including on the tick being run
+    {
+        TimingWheel wheel;
+        std::vector<int> order;
+        TimingWheel::TimerId victim = 0;
+        wheel.schedule(5, [&]() {
+            order.push_back(1);
+            assert(wheel.cancel(victim) && "A timer due on the same tick can be cancelled");
+            wheel.schedule(0, [&]() { order.push_back(2); });
+            wheel.schedule(100, [&]() { order.push_back(3); });
+        });
+        victim = wheel.schedule(5, [&]() { order.push_back(99); });
+        assert(wheel.advance(5) == 2 && "The callback and the timer it added should run");
+        assert((order == std::vector<int>{1, 2}));
+        wheel.advance(104);
+        assert(order.size() == 2);
+        wheel.advance(105);
+        assert((order == std::vector<int>{1, 2, 3}));
+        std::cout << "Test Passed: Callbacks changed the wheel while it ran." << std::endl;
+    }
+
+    std::cout << "All timing wheel tests passed successfully." << std::endl;
+    return 0;
+}
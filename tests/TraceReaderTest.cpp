@@ -0,0 +1,96 @@
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <cstdio>
+#include "../TraceReader.h"
+
+// Writes an input file with the usual two header lines
+std::string writeTrace(const std::string& body) {
+    std::string fileName = "/tmp/TraceReaderTest.txt";
+    std::ofstream out(fileName);
+    out << "Time Floor FloorButton CarButton Fault\n";
+    out << "hh:mm:ss.mmm n Up/Down n n\n";
+    out << body;
+    return fileName;
+}
+
+int main() {
+    // Test scenario 1 - fields are parsed and malformed lines are skipped by line number
+    std::string fileName = writeTrace(
+        "14:05:15.0 2 Up 4 0\n"
+        "\n"
+        "14:05:16.5\t5 DOWN 1 4\r\n"
+        "14:05:17 x Up 4 0\n"
+        "14:05:18 3 Sideways 4 0\n"
+        "14:05:19 3 Up 4\n"
+        "14:05:20 7 down 2 1 trailing notes\n"
+        "14:05:21 8 Up 9 0");
+    {
+        TraceReader reader(fileName);
+        assert(reader.isOpen());
+        TraceRecord records[8];
+        size_t count = reader.next(records, 3);
+        assert(count == 3);
+        assert(reader.getMalformedLines() == 3);
+
+        assert(records[0].line == 3 && records[0].timeMs == 50715000);
+        assert(records[0].floor == 2 && records[0].direction == DIRECTION_UP);
+        assert(records[0].destination == 4 && records[0].fault == 0);
+        assert(records[1].line == 5 && records[1].timeMs == 50716500);
+        assert(records[1].floor == 5 && records[1].direction == DIRECTION_DOWN && records[1].fault == 4);
+        assert(records[2].line == 9 && records[2].direction == DIRECTION_DOWN && records[2].fault == 1);
+
+        Event event;
+        records[1].toEvent(event);
+        assert(event.time == "14:05:16.5" && event.source == "5" && event.floorButton == "DOWN");
+        assert(event.elevatorButton == 1 && event.fault == 4 && event.isFromFloor && !event.isComplete);
+
+        // The last line has no newline and is left for the next call
+        count = reader.next(records, 8);
+        assert(count == 1 && records[0].line == 10 && records[0].floor == 8);
+        assert(reader.next(records, 8) == 0);
+        assert(reader.getLineNumber() == 10);
+    }
+    std::cout << "Test Passed: Trace lines are parsed and malformed lines are skipped." << std::endl;
+
+    // Test scenario 2 - batches never exceed the capacity and resume where they stopped
+    std::string body;
+    for (int i = 0; i < 100; i++) {
+        body += "10:00:00 " + std::to_string(i % 10 + 1) + " UP 10 0\n";
+    }
+    fileName = writeTrace(body);
+    {
+        TraceReader reader(fileName);
+        TraceRecord records[32];
+        size_t total = 0, count, batches = 0;
+        while ((count = reader.next(records, 32)) > 0) {
+            assert(count <= 32);
+            assert(records[0].floor == static_cast<int>(total % 10 + 1));
+            total += count;
+            batches++;
+        }
+        assert(total == 100 && batches == 4);
+        assert(reader.getMalformedLines() == 0);
+    }
+    std::cout << "Test Passed: Records are handed out in batches." << std::endl;
+
+    // Test scenario 3 - missing and empty files
+    {
+        TraceReader missing("/tmp/TraceReaderTest-missing.txt");
+        assert(!missing.isOpen());
+        TraceRecord records[1];
+        assert(missing.next(records, 1) == 0);
+    }
+    fileName = "/tmp/TraceReaderTest.txt";
+    std::ofstream(fileName).close();
+    {
+        TraceReader empty(fileName);
+        TraceRecord records[1];
+        assert(empty.isOpen() && empty.next(records, 1) == 0);
+    }
+    std::remove(fileName.c_str());
+    std::cout << "Test Passed: Missing and empty files give no records." << std::endl;
+
+    std::cout << "All trace reader tests passed successfully." << std::endl;
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../Transport.h"
+#include "../Scheduler.h"
+
+#define PRODUCERS 4
+#define EVENTS_PER_PRODUCER 100000
+#define DATAGRAM_TEST_PORT 8600
+#define SMALL_RECEIVE_SIZE 64
+
+// Waits until an endpoint has events, then takes them
+size_t receiveWaiting(Endpoint& endpoint, std::vector<Event>& events) {
+    while (true) {
+        struct pollfd ready = {endpoint.fd(), POLLIN, 0};
+        assert(poll(&ready, 1, 5000) == 1 && "A waiting event should wake the receiver");
+        if (endpoint.receive(events) > 0) {
+            return events.size();
+        }
+    }
+}
+
+Event makeEvent(int producer, int sequence) {
+    return Event("14:05:15.0", std::to_string(producer), "UP", sequence, true, producer);
+}
+
+int main() {
+    // Test scenario 1 - the SPSC queue keeps order and reports full and empty
+    {
+        SpscQueue<int> queue(4);
+        int value;
+        assert(queue.empty() && !queue.pop(value));
+        for (int i = 0; i < 4; i++) {
+            assert(queue.push(int(i)));
+        }
+        assert(!queue.push(4) && "A full queue refuses the value");
+        for (int i = 0; i < 4; i++) {
+            assert(queue.pop(value) && value == i);
+        }
+        assert(queue.empty());
+
+        // Wraps around many times with a producer and consumer running together
+        SpscQueue<int> shared(64);
+        std::thread producer([&shared]() {
+            for (int i = 0; i < 1000000; i++) {
+                while (!shared.push(int(i))) std::this_thread::yield();
+            }
+        });
+        for (int i = 0; i < 1000000; i++) {
+            while (!shared.pop(value)) std::this_thread::yield();
+            assert(value == i);
+        }
+        producer.join();
+    }
+    std::cout << "Test Passed: SPSC queue keeps order across threads." << std::endl;
+
+    // Test scenario 2 - the MPSC queue loses nothing and keeps each producer's order
+    {
+        MpscQueue<int> queue(256);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([&queue, p]() {
+                for (int i = 0; i < EVENTS_PER_PRODUCER; i++) {
+                    while (!queue.push(p * EVENTS_PER_PRODUCER + i)) std::this_thread::yield();
+                }
+            });
+        }
+        std::vector<int> next(PRODUCERS, 0);
+        int value;
+        for (int received = 0; received < PRODUCERS * EVENTS_PER_PRODUCER;) {
+            if (!queue.pop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            int producer = value / EVENTS_PER_PRODUCER;
+            assert(value % EVENTS_PER_PRODUCER == next[producer]++ && "Each producer's values arrive in order");
+            received++;
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        assert(queue.empty());
+    }
+    std::cout << "Test Passed: MPSC queue delivers every value from many producers." << std::endl;
+
+    // Test scenario 3 - in-process endpoints move events between threads and wake the receiver
+    {
+        InProcessTransport transport;
+        std::unique_ptr<Endpoint> scheduler = transport.open(SCHEDULER_PORT, SENDERS_MANY);
+        std::unique_ptr<Endpoint> car = transport.open(ELEVATOR_PORT_BASE, SENDERS_ONE);
+        std::vector<Event> events;
+        assert(scheduler->receive(events) == 0);
+
+        std::vector<std::thread> senders;
+        for (int p = 0; p < PRODUCERS; p++) {
+            senders.emplace_back([&transport, p]() {
+                std::unique_ptr<Endpoint> sender = transport.open(-1, SENDERS_ONE);
+                assert(sender->fd() == -1);
+                for (int i = 0; i < 10000; i++) {
+                    sender->send(SCHEDULER_PORT, makeEvent(p, i));
+                }
+                sender->flush();
+            });
+        }
+        std::vector<int> next(PRODUCERS, 0);
+        for (int received = 0; received < PRODUCERS * 10000;) {
+            receiveWaiting(*scheduler, events);
+            assert(events.size() <= TRANSPORT_BATCH_SIZE);
+            for (const Event& event : events) {
+                assert(event.elevatorButton == next[event.assignedElevator]++);
+                assert(event.floorButton == "UP" && event.time == "14:05:15.0");
+                received++;
+            }
+        }
+        for (std::thread& sender : senders) {
+            sender.join();
+        }
+        assert(scheduler->receive(events) == 0);
+
+        // A reply goes to the car's mailbox and nowhere else
+        scheduler->send(ELEVATOR_PORT_BASE, makeEvent(0, 7));
+        scheduler->flush();
+        assert(receiveWaiting(*car, events) == 1 && events[0].elevatorButton == 7);
+        assert(scheduler->receive(events) == 0);
+
+        // Events for a port nobody opened are dropped
+        scheduler->send(ELEVATOR_PORT_BASE + 1, makeEvent(1, 1));
+    }
+    std::cout << "Test Passed: In-process endpoints deliver events and wake the receiver." << std::endl;
+
+    // Test scenario 4 - UDP endpoints deliver the same events through the wire format
+    {
+        UdpTransport transport;
+        std::unique_ptr<Endpoint> receiver = transport.open(FLOOR_PORT, SENDERS_ONE);
+        std::unique_ptr<Endpoint> sender = transport.open(-1, SENDERS_ONE);
+        for (int i = 0; i < 3; i++) {
+            sender->send(FLOOR_PORT, makeEvent(2, i));
+        }
+        sender->flush();
+        std::vector<Event> events;
+        std::vector<Event> received;
+        while (received.size() < 3) {
+            receiveWaiting(*receiver, events);
+            received.insert(received.end(), events.begin(), events.end());
+        }
+        for (int i = 0; i < 3; i++) {
+            assert(received[i].elevatorButton == i && received[i].assignedElevator == 2);
+        }
+    }
+    std::cout << "Test Passed: UDP endpoints deliver events through the wire format." << std::endl;
+
+    // Test scenario 5 - datagrams are received into pooled buffers sized from the socket,
+    // and one too large for its buffer is cut off at the buffer instead of overrunning it
+    {
+        DatagramSocket receiver(DATAGRAM_TEST_PORT, SMALL_RECEIVE_SIZE);
+        DatagramSocket sender;
+        DatagramBufferPool pool(receiver, 4);
+        assert(pool.bufferSize() == SMALL_RECEIVE_SIZE && pool.capacity() == 4);
+        {
+            std::vector<PooledBuffer> taken;
+            for (int i = 0; i < 4; i++) {
+                taken.push_back(pool.acquire());
+                assert(taken.back() && taken.back().size() == SMALL_RECEIVE_SIZE);
+                memset(taken.back().data(), 0xAA, SMALL_RECEIVE_SIZE);
+            }
+            assert(!pool.acquire() && pool.available() == 0 && "Every buffer is on loan");
+        }
+        assert(pool.available() == 4 && "Buffers go back when their handles go away");
+
+        Event call = makeEvent(5, 9);
+        std::vector<uint8_t> bytes = call.event_to_bytes();
+        DatagramPacket out(bytes, bytes.size(), InetAddress::getLocalHost(), DATAGRAM_TEST_PORT);
+        sender.send(out);
+        std::vector<uint8_t> large(SMALL_RECEIVE_SIZE * 3, 'x');
+        DatagramPacket oversized(large, large.size(), InetAddress::getLocalHost(), DATAGRAM_TEST_PORT);
+        sender.send(oversized);
+
+        PooledBuffer first = pool.acquire();
+        PooledBuffer second = pool.acquire();
+        PooledBuffer guard = pool.acquire();     // The slab after the second buffer
+        memset(guard.data(), 0xAA, guard.size());
+        DatagramPacket in(first.data(), first.size(), first.size());
+        assert(receiver.receive(in) && in.getLength() == bytes.size());
+        Event decoded;
+        assert(Event::decode(first.data(), in.getLength(), decoded));
+        assert(decoded.elevatorButton == 9 && decoded.assignedElevator == 5);
+
+        DatagramPacket cut(second.data(), second.size(), second.size());
+        assert(!receiver.receive(cut) && "A datagram larger than the buffer is reported cut off");
+        assert(cut.getLength() == SMALL_RECEIVE_SIZE);
+        for (size_t i = 0; i < guard.size(); i++) {
+            assert(guard.data()[i] == 0xAA && "Nothing is written past the buffer");
+        }
+
+        // A UDP endpoint drops a cut-off datagram and keeps the events around it
+        UdpTransport transport;
+        std::unique_ptr<Endpoint> endpoint = transport.open(DATAGRAM_TEST_PORT + 1, SENDERS_ONE);
+        std::vector<uint8_t> junk(DATAGRAM_PACKET_SIZE * 2, '7');
+        DatagramPacket tooLarge(junk, junk.size(), InetAddress::getLocalHost(), DATAGRAM_TEST_PORT + 1);
+        sender.send(tooLarge);
+        DatagramPacket after(bytes, bytes.size(), InetAddress::getLocalHost(), DATAGRAM_TEST_PORT + 1);
+        sender.send(after);
+        std::vector<Event> events;
+        std::vector<Event> received;
+        while (received.empty()) {
+            receiveWaiting(*endpoint, events);
+            received.insert(received.end(), events.begin(), events.end());
+        }
+        assert(received.size() == 1 && received[0].elevatorButton == 9);
+
+        // A pooled batch receives into buffers from the pool and takes a fresh one only for
+        // a slot whose buffer was handed on, so a caller holding buffers stalls the batch
+        DatagramBufferPool batchPool(receiver, 2);
+        DatagramBatch batch(batchPool, 2);
+        for (int i = 0; i < 3; i++) {
+            sender.send(out);
+        }
+        assert(receiver.receiveBatch(batch) == 2 && batchPool.available() == 0);
+        PooledBuffer kept = batch.take(0);
+        assert(kept.data() == batch.getData(0) && Event::decode(kept.data(), batch.getLength(0), decoded));
+        assert(receiver.receiveBatch(batch, false) == 0 && "Slot 0 has no buffer until one is given back");
+        kept.reset();
+        assert(receiver.receiveBatch(batch) == 1 && batchPool.available() == 0);
+        assert(Event::decode(batch.getData(0), batch.getLength(0), decoded) && decoded.elevatorButton == 9);
+    }
+    std::cout << "Test Passed: Datagrams are received into pooled buffers without overrunning them." << std::endl;
+
+    // Test scenario 6 - shared-memory rings carry events from other processes
+    {
+        SharedMemoryTransport transport("elevator-test-" + std::to_string(getpid()));
+        transport.remove(SCHEDULER_PORT);
+        std::unique_ptr<Endpoint> scheduler = transport.open(SCHEDULER_PORT, SENDERS_MANY);
+        bool refused = false;
+        try {
+            transport.open(SCHEDULER_PORT, SENDERS_MANY);
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        assert(refused && "Only one receiver may open an address");
+
+        std::vector<pid_t> children;
+        for (int p = 0; p < PRODUCERS; p++) {
+            pid_t child = fork();
+            if (child == 0) {
+                std::unique_ptr<Endpoint> sender = transport.open(-1, SENDERS_ONE);
+                for (int i = 0; i < 10000; i++) {
+                    sender->send(SCHEDULER_PORT, makeEvent(p, i));
+                }
+                _exit(0);
+            }
+            children.push_back(child);
+        }
+        std::vector<Event> events;
+        std::vector<int> next(PRODUCERS, 0);
+        for (int received = 0; received < PRODUCERS * 10000;) {
+            receiveWaiting(*scheduler, events);
+            for (const Event& event : events) {
+                assert(event.elevatorButton == next[event.assignedElevator]++);
+                assert(event.floorButton == "UP" && event.time == "14:05:15.000");
+                received++;
+            }
+        }
+        for (pid_t child : children) {
+            int status;
+            waitpid(child, &status, 0);
+            assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+
+        // Events sent while the receiver is down wait for it to come back
+        scheduler.reset();
+        std::unique_ptr<Endpoint> sender = transport.open(-1, SENDERS_ONE);
+        for (int i = 0; i < 5; i++) {
+            sender->send(SCHEDULER_PORT, makeEvent(1, i));
+        }
+        scheduler = transport.open(SCHEDULER_PORT, SENDERS_MANY);
+        std::vector<Event> received;
+        while (received.size() < 5) {
+            receiveWaiting(*scheduler, events);
+            received.insert(received.end(), events.begin(), events.end());
+        }
+        for (int i = 0; i < 5; i++) {
+            assert(received[i].elevatorButton == i);
+        }
+        scheduler.reset();
+        transport.remove(SCHEDULER_PORT);
+    }
+    std::cout << "Test Passed: Shared-memory rings deliver events across processes and restarts." << std::endl;
+
+    return 0;
+}